@@ -5,8 +5,8 @@
  *
  */
 
-#define _VERSION     "1.2.17"
-#define VERSION_DATE "12.02.2025"
+#define _VERSION     "1.2.18"
+#define VERSION_DATE "17.10.2026"
 
 #define DB_API 8
 
@@ -19,6 +19,35 @@
 /*
  * ------------------------------------
 
+2026-10-17: version 1.2.18 (horchi)
+   - change: Pool of prepared db connections for the service interface
+   - added:  Streaming (server side cursor) mode for large db scans
+   - added:  Batch writer (multi row upsert) for components and recording inserts
+   - change: Update only the changed fields of a row
+   - change: Grow string buffers of db values on demand
+   - added:  Hold small tables (channelmap, vdrs, parameters) in memory
+   - added:  SVDRP command DBSTAT with latency histograms and slow statement capture
+   - change: Reconnect to the database in place, prepared statements stay valid,
+             a result pending at the reconnect fails it's next fetch
+   - change: Field indices generated from the dictionary (dbfields.h) for hot paths
+   - added:  Dictionary cache, schema fingerprint (parameters) to skip the table validation, optional lazy prepare (setup.conf LazyPrepare)
+   - change: Compact hashed event index for the EIT handler
+   - change: EIT handler writes the DVB events in background (write behind queue)
+   - change: EIT handler instances share one connection and event index
+   - change: EIT segments of different channels are handled concurrently (striped channel locks)
+   - change: Lock free channel map snapshot for the lookups of the EIT handler
+   - change: EIT handler skips the rewrite of events with unchanged content (content hash)
+   - added:  Persisted snapshot of the handler event index, at start only the changed events are read,
+             a snapshot of a other database or not matching the db is dropped
+   - change: DropOutdated with a single update, the segment is removed from the per channel timeline of the event index
+   - change: Components of the DVB events are only rewritten if they changed
+   - added:  Recording of the EIT handler calls and replay benchmark (SVDRP EITREC / EITREPLAY)
+   - change: Prefetch the components and aux values of the changed events per channel instead of one query per event
+   - change: refreshEpg fetches and builds the events of a channel before taking the vdr locks, lock hold times are logged
+   - added:  Fetch workers with own db connections for the full reload (setup.conf FetchWorkers, default 4)
+   - change: refreshEpg looks up the timer of an event by a index instead of scanning all timers per event
+   - change: refreshEpg updates events with unchanged start time in place, the schedule is only sorted if events are added
+
 2025-02-12: version 1.2.17 (horchi)
    - change: Porting to vdr API version > 20501
 
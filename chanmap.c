@@ -0,0 +1,130 @@
+/*
+ * chanmap.c: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include <algorithm>
+
+#include "lib/common.h"
+
+#include "chanmap.h"
+
+//***************************************************************************
+// Channel Map
+//***************************************************************************
+
+cChannelMap::~cChannelMap()
+{
+   delete current.load();
+
+   for (auto snapshot : retired)
+      delete snapshot;
+}
+
+//***************************************************************************
+// Hash Of
+//***************************************************************************
+
+uint64_t cChannelMap::hashOf(const tChannelID& channelId)
+{
+   uint64_t h = (uint64_t)(uint32_t)channelId.Source() << 32
+      | (uint64_t)(channelId.Nid() & 0xFFFF) << 16 | (channelId.Tid() & 0xFFFF);
+
+   h ^= (uint64_t)(channelId.Sid() & 0xFFFF) << 40 ^ (uint64_t)(channelId.Rid() & 0xFFFF) << 8;
+
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+
+   return h;
+}
+
+//***************************************************************************
+// Publish
+//  - the callers serialize the publish() calls
+//  - a reader loads the snapshot only after it's counted, so if no reader
+//    is counted after the exchange none can hold a replaced snapshot
+//***************************************************************************
+
+void cChannelMap::publish(const std::map<std::string,std::string>& ids)
+{
+   Snapshot* snapshot = new Snapshot;
+
+   snapshot->reserve(ids.size());
+
+   for (const auto& id : ids)
+   {
+      tChannelID channelId = tChannelID::FromString(id.first.c_str());
+
+      if (!channelId.Valid())
+         continue;
+
+      snapshot->push_back({ hashOf(channelId), channelId, isZero(id.second.c_str()) ? cmZero : cmExternal });
+   }
+
+   std::sort(snapshot->begin(), snapshot->end(),
+             [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+
+   if (Snapshot* old = current.exchange(snapshot))
+      retired.push_back(old);
+
+   if (readers.load() == 0)
+   {
+      for (auto r : retired)
+         delete r;
+
+      retired.clear();
+   }
+   else
+   {
+      tell(2, "Handler: Channel map in use, keeping %zu replaced snapshot(s)", retired.size());
+   }
+}
+
+//***************************************************************************
+// Mapping Of
+//***************************************************************************
+
+int cChannelMap::mappingOf(const tChannelID& channelId) const
+{
+   int mapping = cmNone;
+
+   readers++;
+
+   const Snapshot* snapshot = current.load();
+
+   if (snapshot)
+   {
+      uint64_t hash = hashOf(channelId);
+
+      auto it = std::lower_bound(snapshot->begin(), snapshot->end(), hash,
+                                 [](const Entry& e, uint64_t h) { return e.hash < h; });
+
+      for (; it != snapshot->end() && it->hash == hash; ++it)
+      {
+         if (it->channelId == channelId)
+         {
+            mapping = it->mapping;
+            break;
+         }
+      }
+   }
+
+   readers--;
+
+   return mapping;
+}
+
+size_t cChannelMap::size() const
+{
+   readers++;
+
+   const Snapshot* snapshot = current.load();
+   size_t size = snapshot ? snapshot->size() : 0;
+
+   readers--;
+
+   return size;
+}
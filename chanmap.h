@@ -0,0 +1,65 @@
+/*
+ * chanmap.h: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+
+#include <vdr/channels.h>
+
+//***************************************************************************
+// Channel Map
+//  - external id of the channels (channelmap), for the lookups of the EIT handler
+//  - the map is an immutable snapshot, sorted by a 64 bit hash of the channel id.
+//    publish() replaces it atomically (RCU like), the readers take no lock
+//    and don't allocate
+//  - the lookups count themselves as readers, a replaced snapshot is deleted
+//    by a later publish() which finds no reader active. The lookups return
+//    no pointer into the snapshot, so nobody holds it after the lookup
+//***************************************************************************
+
+class cChannelMap
+{
+   public:
+
+      enum Mapping
+      {
+         cmNone,                   // the channel isn't mapped
+         cmZero,                   // mapped to the external id 0 (or empty)
+         cmExternal                // mapped to a external id
+      };
+
+      cChannelMap() {}
+      ~cChannelMap();
+
+      void publish(const std::map<std::string,std::string>& ids);   // channel id -> external id
+
+      int mappingOf(const tChannelID& channelId) const;             // Mapping
+      size_t size() const;
+
+      static uint64_t hashOf(const tChannelID& channelId);
+
+   private:
+
+      struct Entry
+      {
+         uint64_t hash;
+         tChannelID channelId;
+         int mapping;
+      };
+
+      typedef std::vector<Entry> Snapshot;
+
+      std::atomic<Snapshot*> current {nullptr};
+      mutable std::atomic<int> readers {0};
+      std::vector<Snapshot*> retired;     // replaced, wait for a publish() without readers
+};
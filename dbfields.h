@@ -0,0 +1,1179 @@
+/*
+ * dbfields.h: field indices of the db dictionary
+ *
+ * Generated from 'configs/epg.dat' by lib/dict2h.awk, don't edit!
+ *
+ */
+
+#pragma once
+
+#include "lib/dbdict.h"
+
+namespace dbf
+{
+   namespace events
+   {
+      constexpr int fiEVENTID = 0;
+      constexpr int fiCHANNELID = 1;
+      constexpr int fiMASTERID = 2;
+      constexpr int fiUSEID = 3;
+      constexpr int fiSOURCE = 4;
+      constexpr int fiFILEREF = 5;
+      constexpr int fiINSSP = 6;
+      constexpr int fiUPDSP = 7;
+      constexpr int fiUPDFLG = 8;
+      constexpr int fiDELFLG = 9;
+      constexpr int fiTABLEID = 10;
+      constexpr int fiVERSION = 11;
+      constexpr int fiTITLE = 12;
+      constexpr int fiCOMPTITLE = 13;
+      constexpr int fiSHORTTEXT = 14;
+      constexpr int fiCOMPSHORTTEXT = 15;
+      constexpr int fiLONGDESCRIPTION = 16;
+      constexpr int fiCOMPLONGDESCRIPTION = 17;
+      constexpr int fiSTARTTIME = 18;
+      constexpr int fiDURATION = 19;
+      constexpr int fiPARENTALRATING = 20;
+      constexpr int fiVPS = 21;
+      constexpr int fiCONTENTS = 22;
+      constexpr int fiSHORTDESCRIPTION = 23;
+      constexpr int fiACTOR = 24;
+      constexpr int fiAUDIO = 25;
+      constexpr int fiCATEGORY = 26;
+      constexpr int fiCOUNTRY = 27;
+      constexpr int fiDIRECTOR = 28;
+      constexpr int fiCOMMENTATOR = 29;
+      constexpr int fiFLAGS = 30;
+      constexpr int fiGENRE = 31;
+      constexpr int fiMUSIC = 32;
+      constexpr int fiPRODUCER = 33;
+      constexpr int fiSCREENPLAY = 34;
+      constexpr int fiSHORTREVIEW = 35;
+      constexpr int fiTIPP = 36;
+      constexpr int fiTOPIC = 37;
+      constexpr int fiYEAR = 38;
+      constexpr int fiRATING = 39;
+      constexpr int fiNUMRATING = 40;
+      constexpr int fiTXTRATING = 41;
+      constexpr int fiMOVIEID = 42;
+      constexpr int fiMODERATOR = 43;
+      constexpr int fiOTHER = 44;
+      constexpr int fiGUEST = 45;
+      constexpr int fiCAMERA = 46;
+      constexpr int fiEXTEPNUM = 47;
+      constexpr int fiIMAGECOUNT = 48;
+      constexpr int fiEPISODECOMPNAME = 49;
+      constexpr int fiEPISODECOMPSHORTNAME = 50;
+      constexpr int fiEPISODECOMPPARTNAME = 51;
+      constexpr int fiEPISODELANG = 52;
+      constexpr int fiSCRSERIESID = 53;
+      constexpr int fiSCRSERIESEPISODE = 54;
+      constexpr int fiSCRMOVIEID = 55;
+      constexpr int fiSCRSP = 56;
+
+      constexpr int fieldCount = 57;
+   }
+
+   namespace components
+   {
+      constexpr int fiEVENTID = 0;
+      constexpr int fiCHANNELID = 1;
+      constexpr int fiSTREAM = 2;
+      constexpr int fiTYPE = 3;
+      constexpr int fiLANG = 4;
+      constexpr int fiDESCRIPTION = 5;
+      constexpr int fiINSSP = 6;
+      constexpr int fiUPDSP = 7;
+
+      constexpr int fieldCount = 8;
+   }
+
+   namespace fileref
+   {
+      constexpr int fiNAME = 0;
+      constexpr int fiSOURCE = 1;
+      constexpr int fiINSSP = 2;
+      constexpr int fiUPDSP = 3;
+      constexpr int fiEXTERNALID = 4;
+      constexpr int fiFILEREF = 5;
+      constexpr int fiTAG = 6;
+
+      constexpr int fieldCount = 7;
+   }
+
+   namespace imagerefs
+   {
+      constexpr int fiEVENTID = 0;
+      constexpr int fiLFN = 1;
+      constexpr int fiINSSP = 2;
+      constexpr int fiUPDSP = 3;
+      constexpr int fiSOURCE = 4;
+      constexpr int fiFILEREF = 5;
+      constexpr int fiIMGNAME = 6;
+      constexpr int fiIMGNAMEFS = 7;
+
+      constexpr int fieldCount = 8;
+   }
+
+   namespace images
+   {
+      constexpr int fiIMGNAME = 0;
+      constexpr int fiINSSP = 1;
+      constexpr int fiUPDSP = 2;
+      constexpr int fiIMAGE = 3;
+
+      constexpr int fieldCount = 4;
+   }
+
+   namespace episodes
+   {
+      constexpr int fiCOMPNAME = 0;
+      constexpr int fiCOMPPARTNAME = 1;
+      constexpr int fiLANG = 2;
+      constexpr int fiINSSP = 3;
+      constexpr int fiUPDSP = 4;
+      constexpr int fiLINK = 5;
+      constexpr int fiSHORTNAME = 6;
+      constexpr int fiCOMPSHORTNAME = 7;
+      constexpr int fiEPISODENAME = 8;
+      constexpr int fiPARTNAME = 9;
+      constexpr int fiSEASON = 10;
+      constexpr int fiPART = 11;
+      constexpr int fiPARTS = 12;
+      constexpr int fiNUMBER = 13;
+      constexpr int fiEXTRACOL1 = 14;
+      constexpr int fiEXTRACOL2 = 15;
+      constexpr int fiEXTRACOL3 = 16;
+      constexpr int fiCOMMENT = 17;
+
+      constexpr int fieldCount = 18;
+   }
+
+   namespace channelmap
+   {
+      constexpr int fiEXTERNALID = 0;
+      constexpr int fiCHANNELID = 1;
+      constexpr int fiSOURCE = 2;
+      constexpr int fiORDER = 3;
+      constexpr int fiVISIBLE = 4;
+      constexpr int fiCHANNELNAME = 5;
+      constexpr int fiVPS = 6;
+      constexpr int fiFORMAT = 7;
+      constexpr int fiUNKNOWNATVDR = 8;
+      constexpr int fiMERGE = 9;
+      constexpr int fiMERGESP = 10;
+      constexpr int fiINSSP = 11;
+      constexpr int fiUPDSP = 12;
+      constexpr int fiUPDFLG = 13;
+
+      constexpr int fieldCount = 14;
+   }
+
+   namespace vdrs
+   {
+      constexpr int fiUUID = 0;
+      constexpr int fiINSSP = 1;
+      constexpr int fiUPDSP = 2;
+      constexpr int fiNAME = 3;
+      constexpr int fiVERSION = 4;
+      constexpr int fiDBAPI = 5;
+      constexpr int fiLASTUPDATE = 6;
+      constexpr int fiNEXTUPDATE = 7;
+      constexpr int fiLASTMERGE = 8;
+      constexpr int fiSTATE = 9;
+      constexpr int fiMASTER = 10;
+      constexpr int fiIP = 11;
+      constexpr int fiMAC = 12;
+      constexpr int fiPID = 13;
+      constexpr int fiSVDRP = 14;
+      constexpr int fiOSD2WEBP = 15;
+      constexpr int fiTUNERCOUNT = 16;
+      constexpr int fiSHAREINWEB = 17;
+      constexpr int fiUSECOMMONRECFOLDER = 18;
+      constexpr int fiVIDEODIR = 19;
+      constexpr int fiVIDEOTOTAL = 20;
+      constexpr int fiVIDEOFREE = 21;
+
+      constexpr int fieldCount = 22;
+   }
+
+   namespace users
+   {
+      constexpr int fiUSER = 0;
+      constexpr int fiINSSP = 1;
+      constexpr int fiUPDSP = 2;
+      constexpr int fiPASSWD = 3;
+      constexpr int fiACTIVE = 4;
+      constexpr int fiRIGHTS = 5;
+
+      constexpr int fieldCount = 6;
+   }
+
+   namespace parameters
+   {
+      constexpr int fiOWNER = 0;
+      constexpr int fiNAME = 1;
+      constexpr int fiINSSP = 2;
+      constexpr int fiUPDSP = 3;
+      constexpr int fiVALUE = 4;
+
+      constexpr int fieldCount = 5;
+   }
+
+   namespace analyse
+   {
+      constexpr int fiCHANNELID = 0;
+      constexpr int fiVDRMASTERID = 1;
+      constexpr int fiVDREVENTID = 2;
+      constexpr int fiVDRSTARTTIME = 3;
+      constexpr int fiVDRDURATION = 4;
+      constexpr int fiVDRTITLE = 5;
+      constexpr int fiVDRSHORTTEXT = 6;
+      constexpr int fiEXTMASTERID = 7;
+      constexpr int fiEXTEVENTID = 8;
+      constexpr int fiEXTSTARTTIME = 9;
+      constexpr int fiEXTDURATION = 10;
+      constexpr int fiEXTTITLE = 11;
+      constexpr int fiEXTSHORTTEXT = 12;
+      constexpr int fiEXTEPISODE = 13;
+      constexpr int fiEXTMERGE = 14;
+      constexpr int fiEXIIMAGES = 15;
+      constexpr int fiLVMIN = 16;
+      constexpr int fiRANK = 17;
+
+      constexpr int fieldCount = 18;
+   }
+
+   namespace snapshot
+   {
+      constexpr int fiCHANNELID = 0;
+      constexpr int fiSOURCE = 1;
+      constexpr int fiVDRMASTERID = 2;
+      constexpr int fiEVENTID = 3;
+      constexpr int fiUSEID = 4;
+      constexpr int fiSTARTTIME = 5;
+      constexpr int fiDURATION = 6;
+      constexpr int fiTITLE = 7;
+      constexpr int fiCOMPTITLE = 8;
+      constexpr int fiSHORTTEXT = 9;
+      constexpr int fiCOMPSHORTTEXT = 10;
+      constexpr int fiUPDSP = 11;
+      constexpr int fiEPISODE = 12;
+      constexpr int fiMERGE = 13;
+      constexpr int fiIMAGES = 14;
+
+      constexpr int fieldCount = 15;
+   }
+
+   namespace useevents
+   {
+      constexpr int fiCNTSOURCE = 0;
+      constexpr int fiCHANNELID = 1;
+      constexpr int fiCNTEVENTID = 2;
+      constexpr int fiMASTERID = 3;
+      constexpr int fiUSEID = 4;
+      constexpr int fiSUBSOURCE = 5;
+      constexpr int fiSUBEVENTID = 6;
+      constexpr int fiUPDSP = 7;
+      constexpr int fiUPDFLG = 8;
+      constexpr int fiDELFLG = 9;
+      constexpr int fiFILEREF = 10;
+      constexpr int fiTABLEID = 11;
+      constexpr int fiVERSION = 12;
+      constexpr int fiTITLE = 13;
+      constexpr int fiSHORTTEXT = 14;
+      constexpr int fiCOMPTITLE = 15;
+      constexpr int fiCOMPSHORTTEXT = 16;
+      constexpr int fiGENRE = 17;
+      constexpr int fiCOUNTRY = 18;
+      constexpr int fiYEAR = 19;
+      constexpr int fiSTARTTIME = 20;
+      constexpr int fiDURATION = 21;
+      constexpr int fiPARENTALRATING = 22;
+      constexpr int fiVPS = 23;
+      constexpr int fiCONTENTS = 24;
+      constexpr int fiCATEGORY = 25;
+      constexpr int fiSHORTDESCRIPTION = 26;
+      constexpr int fiSHORTREVIEW = 27;
+      constexpr int fiTIPP = 28;
+      constexpr int fiRATING = 29;
+      constexpr int fiNUMRATING = 30;
+      constexpr int fiTXTRATING = 31;
+      constexpr int fiTOPIC = 32;
+      constexpr int fiLONGDESCRIPTION = 33;
+      constexpr int fiCOMPLONGDESCRIPTION = 34;
+      constexpr int fiCNTLONGDESCRIPTION = 35;
+      constexpr int fiMODERATOR = 36;
+      constexpr int fiGUEST = 37;
+      constexpr int fiACTOR = 38;
+      constexpr int fiPRODUCER = 39;
+      constexpr int fiOTHER = 40;
+      constexpr int fiDIRECTOR = 41;
+      constexpr int fiCOMMENTATOR = 42;
+      constexpr int fiSCREENPLAY = 43;
+      constexpr int fiCAMERA = 44;
+      constexpr int fiMUSIC = 45;
+      constexpr int fiAUDIO = 46;
+      constexpr int fiFLAGS = 47;
+      constexpr int fiIMAGECOUNT = 48;
+      constexpr int fiSCRSERIESID = 49;
+      constexpr int fiSCRSERIESEPISODE = 50;
+      constexpr int fiSCRMOVIEID = 51;
+      constexpr int fiSCRSP = 52;
+      constexpr int fiEPISODECOMPNAME = 53;
+      constexpr int fiEPISODECOMPSHORTNAME = 54;
+      constexpr int fiEPISODECOMPPARTNAME = 55;
+      constexpr int fiEPISODENAME = 56;
+      constexpr int fiEPISODESHORTNAME = 57;
+      constexpr int fiEPISODEPARTNAME = 58;
+      constexpr int fiEPISODELANG = 59;
+      constexpr int fiEPISODEEXTRACOL1 = 60;
+      constexpr int fiEPISODEEXTRACOL2 = 61;
+      constexpr int fiEPISODEEXTRACOL3 = 62;
+      constexpr int fiEPISODESEASON = 63;
+      constexpr int fiEPISODEPART = 64;
+      constexpr int fiEPISODEPARTS = 65;
+      constexpr int fiEPISODENUMBER = 66;
+
+      constexpr int fieldCount = 67;
+   }
+
+   namespace recordinglist
+   {
+      constexpr int fiMD5PATH = 0;
+      constexpr int fiSTARTTIME = 1;
+      constexpr int fiOWNER = 2;
+      constexpr int fiINSSP = 3;
+      constexpr int fiUPDSP = 4;
+      constexpr int fiLASTIFOUPD = 5;
+      constexpr int fiIMGID = 6;
+      constexpr int fiVDRUUID = 7;
+      constexpr int fiPATH = 8;
+      constexpr int fiNAME = 9;
+      constexpr int fiFOLDER = 10;
+      constexpr int fiTITLE = 11;
+      constexpr int fiSHORTTEXT = 12;
+      constexpr int fiLONGDESCRIPTION = 13;
+      constexpr int fiDESCRIPTION = 14;
+      constexpr int fiDURATION = 15;
+      constexpr int fiFSK = 16;
+      constexpr int fiEVENTID = 17;
+      constexpr int fiCHANNELID = 18;
+      constexpr int fiCHANNELNAME = 19;
+      constexpr int fiSTATE = 20;
+      constexpr int fiINUSE = 21;
+      constexpr int fiJOB = 22;
+      constexpr int fiACTOR = 23;
+      constexpr int fiAUDIO = 24;
+      constexpr int fiCATEGORY = 25;
+      constexpr int fiCOUNTRY = 26;
+      constexpr int fiDIRECTOR = 27;
+      constexpr int fiFLAGS = 28;
+      constexpr int fiGENRE = 29;
+      constexpr int fiMUSIC = 30;
+      constexpr int fiPRODUCER = 31;
+      constexpr int fiSCREENPLAY = 32;
+      constexpr int fiSHORTREVIEW = 33;
+      constexpr int fiTIPP = 34;
+      constexpr int fiTOPIC = 35;
+      constexpr int fiYEAR = 36;
+      constexpr int fiRATING = 37;
+      constexpr int fiNUMRATING = 38;
+      constexpr int fiTXTRATING = 39;
+      constexpr int fiMODERATOR = 40;
+      constexpr int fiOTHER = 41;
+      constexpr int fiGUEST = 42;
+      constexpr int fiCAMERA = 43;
+      constexpr int fiEPISODECOMPNAME = 44;
+      constexpr int fiEPISODECOMPSHORTNAME = 45;
+      constexpr int fiEPISODECOMPPARTNAME = 46;
+      constexpr int fiEPISODELANG = 47;
+      constexpr int fiSCRSERIESID = 48;
+      constexpr int fiSCRSERIESEPISODE = 49;
+      constexpr int fiSCRMOVIEID = 50;
+      constexpr int fiSCRINFOMOVIEID = 51;
+      constexpr int fiSCRINFOSERIESID = 52;
+      constexpr int fiSCRINFOEPISODEID = 53;
+      constexpr int fiSCRNEW = 54;
+      constexpr int fiSCRSP = 55;
+
+      constexpr int fieldCount = 56;
+   }
+
+   namespace recordingimages
+   {
+      constexpr int fiIMGID = 0;
+      constexpr int fiLFN = 1;
+      constexpr int fiINSSP = 2;
+      constexpr int fiUPDSP = 3;
+      constexpr int fiTITLE = 4;
+      constexpr int fiSHORTTEXT = 5;
+      constexpr int fiIMAGE = 6;
+
+      constexpr int fieldCount = 7;
+   }
+
+   namespace recordingdirs
+   {
+      constexpr int fiVDRUUID = 0;
+      constexpr int fiDIRECTORY = 1;
+      constexpr int fiINSSP = 2;
+      constexpr int fiUPDSP = 3;
+
+      constexpr int fieldCount = 4;
+   }
+
+   namespace timers
+   {
+      constexpr int fiID = 0;
+      constexpr int fiVDRUUID = 1;
+      constexpr int fiINSSP = 2;
+      constexpr int fiUPDSP = 3;
+      constexpr int fiEVENTID = 4;
+      constexpr int fiCHANNELID = 5;
+      constexpr int fiEVTSTARTTIME = 6;
+      constexpr int fi_STARTTIME = 7;
+      constexpr int fi_ENDTIME = 8;
+      constexpr int fiSOURCE = 9;
+      constexpr int fiTYPE = 10;
+      constexpr int fiSTATE = 11;
+      constexpr int fiINFO = 12;
+      constexpr int fiACTION = 13;
+      constexpr int fiTCCMAILCNT = 14;
+      constexpr int fiWRNCOUNT = 15;
+      constexpr int fiRETRYS = 16;
+      constexpr int fiNAMINGMODE = 17;
+      constexpr int fiTEMPLATE = 18;
+      constexpr int fiACTIVE = 19;
+      constexpr int fiDAY = 20;
+      constexpr int fiWEEKDAYS = 21;
+      constexpr int fiSTARTTIME = 22;
+      constexpr int fiENDTIME = 23;
+      constexpr int fiFILE = 24;
+      constexpr int fiDIRECTORY = 25;
+      constexpr int fiPRIORITY = 26;
+      constexpr int fiLIFETIME = 27;
+      constexpr int fiVPS = 28;
+      constexpr int fiCHILDLOCK = 29;
+      constexpr int fiAUX = 30;
+      constexpr int fiAUTOTIMERNAME = 31;
+      constexpr int fiAUTOTIMERID = 32;
+      constexpr int fiAUTOTIMERINSSP = 33;
+      constexpr int fiDONEID = 34;
+      constexpr int fiEXPRESSION = 35;
+
+      constexpr int fieldCount = 36;
+   }
+
+   namespace searchtimers
+   {
+      constexpr int fiID = 0;
+      constexpr int fiINSSP = 1;
+      constexpr int fiUPDSP = 2;
+      constexpr int fiCHANNELIDS = 3;
+      constexpr int fiCHEXCLUDE = 4;
+      constexpr int fiCHFORMAT = 5;
+      constexpr int fiNAME = 6;
+      constexpr int fiEXPRESSION = 7;
+      constexpr int fiEXPRESSION1 = 8;
+      constexpr int fiSEARCHMODE = 9;
+      constexpr int fiSEARCHFIELDS = 10;
+      constexpr int fiSEARCHFIELDS1 = 11;
+      constexpr int fiCASESENSITIV = 12;
+      constexpr int fiREPEATFIELDS = 13;
+      constexpr int fiEPISODENAME = 14;
+      constexpr int fiSEASON = 15;
+      constexpr int fiSEASONPART = 16;
+      constexpr int fiCATEGORY = 17;
+      constexpr int fiGENRE = 18;
+      constexpr int fiYEAR = 19;
+      constexpr int fiTIPP = 20;
+      constexpr int fiNOEPGMATCH = 21;
+      constexpr int fiTYPE = 22;
+      constexpr int fiSTATE = 23;
+      constexpr int fiNAMINGMODE = 24;
+      constexpr int fiTEMPLATE = 25;
+      constexpr int fiACTIVE = 26;
+      constexpr int fiSOURCE = 27;
+      constexpr int fiHITS = 28;
+      constexpr int fiMODSP = 29;
+      constexpr int fiLASTRUN = 30;
+      constexpr int fiVDRUUID = 31;
+      constexpr int fiWEEKDAYS = 32;
+      constexpr int fiNEXTDAYS = 33;
+      constexpr int fiSTARTTIME = 34;
+      constexpr int fiENDTIME = 35;
+      constexpr int fiDIRECTORY = 36;
+      constexpr int fiPRIORITY = 37;
+      constexpr int fiLIFETIME = 38;
+      constexpr int fiVPS = 39;
+      constexpr int fiCHILDLOCK = 40;
+
+      constexpr int fieldCount = 41;
+   }
+
+   namespace timersdone
+   {
+      constexpr int fiID = 0;
+      constexpr int fiINSSP = 1;
+      constexpr int fiUPDSP = 2;
+      constexpr int fiSOURCE = 3;
+      constexpr int fiSTATE = 4;
+      constexpr int fiTIMERID = 5;
+      constexpr int fiAUTOTIMERID = 6;
+      constexpr int fiAUTOTIMERNAME = 7;
+      constexpr int fiTITLE = 8;
+      constexpr int fiCOMPTITLE = 9;
+      constexpr int fiSHORTTEXT = 10;
+      constexpr int fiCOMPSHORTTEXT = 11;
+      constexpr int fiLONGDESCRIPTION = 12;
+      constexpr int fiCOMPLONGDESCRIPTION = 13;
+      constexpr int fiEPISODECOMPNAME = 14;
+      constexpr int fiEPISODECOMPSHORTNAME = 15;
+      constexpr int fiEPISODECOMPPARTNAME = 16;
+      constexpr int fiEPISODELANG = 17;
+      constexpr int fiEPISODESEASON = 18;
+      constexpr int fiEPISODEPART = 19;
+      constexpr int fiCHANNELID = 20;
+      constexpr int fiCHANNELNAME = 21;
+      constexpr int fiEXPRESSION = 22;
+      constexpr int fiSTARTTIME = 23;
+      constexpr int fiDURATION = 24;
+      constexpr int fiAUX = 25;
+
+      constexpr int fieldCount = 26;
+   }
+
+   namespace messages
+   {
+      constexpr int fiID = 0;
+      constexpr int fiINSSP = 1;
+      constexpr int fiUPDSP = 2;
+      constexpr int fiTYPE = 3;
+      constexpr int fiTITLE = 4;
+      constexpr int fiSTATE = 5;
+      constexpr int fiTEXT = 6;
+
+      constexpr int fieldCount = 7;
+   }
+
+   namespace series
+   {
+      constexpr int fiSERIESID = 0;
+      constexpr int fiSERIESNAME = 1;
+      constexpr int fiSERIESLASTSCRAPED = 2;
+      constexpr int fiSERIESLASTUPDATED = 3;
+      constexpr int fiSERIESOVERVIEW = 4;
+      constexpr int fiSERIESFIRSTAIRED = 5;
+      constexpr int fiSERIESNETWORK = 6;
+      constexpr int fiSERIESIMDBID = 7;
+      constexpr int fiSERIESGENRE = 8;
+      constexpr int fiSERIESRATING = 9;
+      constexpr int fiSERIESSTATUS = 10;
+
+      constexpr int fieldCount = 11;
+   }
+
+   namespace series_episode
+   {
+      constexpr int fiEPISODEID = 0;
+      constexpr int fiEPISODENUMBER = 1;
+      constexpr int fiSEASONNUMBER = 2;
+      constexpr int fiEPISODENAME = 3;
+      constexpr int fiEPISODEOVERVIEW = 4;
+      constexpr int fiEPISODEFIRSTAIRED = 5;
+      constexpr int fiEPISODEGUESTSTARS = 6;
+      constexpr int fiEPISODERATING = 7;
+      constexpr int fiEPISODELASTUPDATED = 8;
+      constexpr int fiSERIESID = 9;
+
+      constexpr int fieldCount = 10;
+   }
+
+   namespace series_media
+   {
+      constexpr int fiSERIESID = 0;
+      constexpr int fiSEASONNUMBER = 1;
+      constexpr int fiEPISODEID = 2;
+      constexpr int fiACTORID = 3;
+      constexpr int fiMEDIATYPE = 4;
+      constexpr int fiINSSP = 5;
+      constexpr int fiUPDSP = 6;
+      constexpr int fiMEDIAURL = 7;
+      constexpr int fiMEDIAWIDTH = 8;
+      constexpr int fiMEDIAHEIGHT = 9;
+      constexpr int fiMEDIARATING = 10;
+      constexpr int fiMEDIACONTENT = 11;
+
+      constexpr int fieldCount = 12;
+   }
+
+   namespace series_actor
+   {
+      constexpr int fiACTORID = 0;
+      constexpr int fiACTORNAME = 1;
+      constexpr int fiACTORROLE = 2;
+      constexpr int fiSORTORDER = 3;
+
+      constexpr int fieldCount = 4;
+   }
+
+   namespace movie
+   {
+      constexpr int fiMOVIEID = 0;
+      constexpr int fiTITLE = 1;
+      constexpr int fiORIGINALTITLE = 2;
+      constexpr int fiTAGLINE = 3;
+      constexpr int fiOVERVIEW = 4;
+      constexpr int fiISADULT = 5;
+      constexpr int fiCOLLECTIONID = 6;
+      constexpr int fiCOLLECTIONNAME = 7;
+      constexpr int fiBUDGET = 8;
+      constexpr int fiREVENUE = 9;
+      constexpr int fiGENRES = 10;
+      constexpr int fiHOMEPAGE = 11;
+      constexpr int fiRELEAASEDATE = 12;
+      constexpr int fiRUNTIME = 13;
+      constexpr int fiPOPULARITY = 14;
+      constexpr int fiVOTEAVERAGE = 15;
+
+      constexpr int fieldCount = 16;
+   }
+
+   namespace movie_actor
+   {
+      constexpr int fiACTORID = 0;
+      constexpr int fiACTORNAME = 1;
+
+      constexpr int fieldCount = 2;
+   }
+
+   namespace movie_actors
+   {
+      constexpr int fiMOVIEID = 0;
+      constexpr int fiACTORID = 1;
+      constexpr int fiROLE = 2;
+
+      constexpr int fieldCount = 3;
+   }
+
+   namespace movie_media
+   {
+      constexpr int fiMOVIEID = 0;
+      constexpr int fiACTORID = 1;
+      constexpr int fiMEDIATYPE = 2;
+      constexpr int fiMEDIAURL = 3;
+      constexpr int fiMEDIAWIDTH = 4;
+      constexpr int fiMEDIAHEIGHT = 5;
+      constexpr int fiMEDIACONTENT = 6;
+
+      constexpr int fieldCount = 7;
+   }
+
+   //***************************************************************************
+   // Check
+   //  - the indices must match the dictionary loaded at runtime, only the
+   //    tables given (0 terminated) are checked, all if 0
+   //***************************************************************************
+
+   inline int check(const char* const* tables = 0)
+   {
+      static const cDbDict::FieldIndex indices[] =
+      {
+         { "events", "EVENTID", 0 },
+         { "events", "CHANNELID", 1 },
+         { "events", "MASTERID", 2 },
+         { "events", "USEID", 3 },
+         { "events", "SOURCE", 4 },
+         { "events", "FILEREF", 5 },
+         { "events", "INSSP", 6 },
+         { "events", "UPDSP", 7 },
+         { "events", "UPDFLG", 8 },
+         { "events", "DELFLG", 9 },
+         { "events", "TABLEID", 10 },
+         { "events", "VERSION", 11 },
+         { "events", "TITLE", 12 },
+         { "events", "COMPTITLE", 13 },
+         { "events", "SHORTTEXT", 14 },
+         { "events", "COMPSHORTTEXT", 15 },
+         { "events", "LONGDESCRIPTION", 16 },
+         { "events", "COMPLONGDESCRIPTION", 17 },
+         { "events", "STARTTIME", 18 },
+         { "events", "DURATION", 19 },
+         { "events", "PARENTALRATING", 20 },
+         { "events", "VPS", 21 },
+         { "events", "CONTENTS", 22 },
+         { "events", "SHORTDESCRIPTION", 23 },
+         { "events", "ACTOR", 24 },
+         { "events", "AUDIO", 25 },
+         { "events", "CATEGORY", 26 },
+         { "events", "COUNTRY", 27 },
+         { "events", "DIRECTOR", 28 },
+         { "events", "COMMENTATOR", 29 },
+         { "events", "FLAGS", 30 },
+         { "events", "GENRE", 31 },
+         { "events", "MUSIC", 32 },
+         { "events", "PRODUCER", 33 },
+         { "events", "SCREENPLAY", 34 },
+         { "events", "SHORTREVIEW", 35 },
+         { "events", "TIPP", 36 },
+         { "events", "TOPIC", 37 },
+         { "events", "YEAR", 38 },
+         { "events", "RATING", 39 },
+         { "events", "NUMRATING", 40 },
+         { "events", "TXTRATING", 41 },
+         { "events", "MOVIEID", 42 },
+         { "events", "MODERATOR", 43 },
+         { "events", "OTHER", 44 },
+         { "events", "GUEST", 45 },
+         { "events", "CAMERA", 46 },
+         { "events", "EXTEPNUM", 47 },
+         { "events", "IMAGECOUNT", 48 },
+         { "events", "EPISODECOMPNAME", 49 },
+         { "events", "EPISODECOMPSHORTNAME", 50 },
+         { "events", "EPISODECOMPPARTNAME", 51 },
+         { "events", "EPISODELANG", 52 },
+         { "events", "SCRSERIESID", 53 },
+         { "events", "SCRSERIESEPISODE", 54 },
+         { "events", "SCRMOVIEID", 55 },
+         { "events", "SCRSP", 56 },
+         { "components", "EVENTID", 0 },
+         { "components", "CHANNELID", 1 },
+         { "components", "STREAM", 2 },
+         { "components", "TYPE", 3 },
+         { "components", "LANG", 4 },
+         { "components", "DESCRIPTION", 5 },
+         { "components", "INSSP", 6 },
+         { "components", "UPDSP", 7 },
+         { "fileref", "NAME", 0 },
+         { "fileref", "SOURCE", 1 },
+         { "fileref", "INSSP", 2 },
+         { "fileref", "UPDSP", 3 },
+         { "fileref", "EXTERNALID", 4 },
+         { "fileref", "FILEREF", 5 },
+         { "fileref", "TAG", 6 },
+         { "imagerefs", "EVENTID", 0 },
+         { "imagerefs", "LFN", 1 },
+         { "imagerefs", "INSSP", 2 },
+         { "imagerefs", "UPDSP", 3 },
+         { "imagerefs", "SOURCE", 4 },
+         { "imagerefs", "FILEREF", 5 },
+         { "imagerefs", "IMGNAME", 6 },
+         { "imagerefs", "IMGNAMEFS", 7 },
+         { "images", "IMGNAME", 0 },
+         { "images", "INSSP", 1 },
+         { "images", "UPDSP", 2 },
+         { "images", "IMAGE", 3 },
+         { "episodes", "COMPNAME", 0 },
+         { "episodes", "COMPPARTNAME", 1 },
+         { "episodes", "LANG", 2 },
+         { "episodes", "INSSP", 3 },
+         { "episodes", "UPDSP", 4 },
+         { "episodes", "LINK", 5 },
+         { "episodes", "SHORTNAME", 6 },
+         { "episodes", "COMPSHORTNAME", 7 },
+         { "episodes", "EPISODENAME", 8 },
+         { "episodes", "PARTNAME", 9 },
+         { "episodes", "SEASON", 10 },
+         { "episodes", "PART", 11 },
+         { "episodes", "PARTS", 12 },
+         { "episodes", "NUMBER", 13 },
+         { "episodes", "EXTRACOL1", 14 },
+         { "episodes", "EXTRACOL2", 15 },
+         { "episodes", "EXTRACOL3", 16 },
+         { "episodes", "COMMENT", 17 },
+         { "channelmap", "EXTERNALID", 0 },
+         { "channelmap", "CHANNELID", 1 },
+         { "channelmap", "SOURCE", 2 },
+         { "channelmap", "ORDER", 3 },
+         { "channelmap", "VISIBLE", 4 },
+         { "channelmap", "CHANNELNAME", 5 },
+         { "channelmap", "VPS", 6 },
+         { "channelmap", "FORMAT", 7 },
+         { "channelmap", "UNKNOWNATVDR", 8 },
+         { "channelmap", "MERGE", 9 },
+         { "channelmap", "MERGESP", 10 },
+         { "channelmap", "INSSP", 11 },
+         { "channelmap", "UPDSP", 12 },
+         { "channelmap", "UPDFLG", 13 },
+         { "vdrs", "UUID", 0 },
+         { "vdrs", "INSSP", 1 },
+         { "vdrs", "UPDSP", 2 },
+         { "vdrs", "NAME", 3 },
+         { "vdrs", "VERSION", 4 },
+         { "vdrs", "DBAPI", 5 },
+         { "vdrs", "LASTUPDATE", 6 },
+         { "vdrs", "NEXTUPDATE", 7 },
+         { "vdrs", "LASTMERGE", 8 },
+         { "vdrs", "STATE", 9 },
+         { "vdrs", "MASTER", 10 },
+         { "vdrs", "IP", 11 },
+         { "vdrs", "MAC", 12 },
+         { "vdrs", "PID", 13 },
+         { "vdrs", "SVDRP", 14 },
+         { "vdrs", "OSD2WEBP", 15 },
+         { "vdrs", "TUNERCOUNT", 16 },
+         { "vdrs", "SHAREINWEB", 17 },
+         { "vdrs", "USECOMMONRECFOLDER", 18 },
+         { "vdrs", "VIDEODIR", 19 },
+         { "vdrs", "VIDEOTOTAL", 20 },
+         { "vdrs", "VIDEOFREE", 21 },
+         { "users", "USER", 0 },
+         { "users", "INSSP", 1 },
+         { "users", "UPDSP", 2 },
+         { "users", "PASSWD", 3 },
+         { "users", "ACTIVE", 4 },
+         { "users", "RIGHTS", 5 },
+         { "parameters", "OWNER", 0 },
+         { "parameters", "NAME", 1 },
+         { "parameters", "INSSP", 2 },
+         { "parameters", "UPDSP", 3 },
+         { "parameters", "VALUE", 4 },
+         { "analyse", "CHANNELID", 0 },
+         { "analyse", "VDRMASTERID", 1 },
+         { "analyse", "VDREVENTID", 2 },
+         { "analyse", "VDRSTARTTIME", 3 },
+         { "analyse", "VDRDURATION", 4 },
+         { "analyse", "VDRTITLE", 5 },
+         { "analyse", "VDRSHORTTEXT", 6 },
+         { "analyse", "EXTMASTERID", 7 },
+         { "analyse", "EXTEVENTID", 8 },
+         { "analyse", "EXTSTARTTIME", 9 },
+         { "analyse", "EXTDURATION", 10 },
+         { "analyse", "EXTTITLE", 11 },
+         { "analyse", "EXTSHORTTEXT", 12 },
+         { "analyse", "EXTEPISODE", 13 },
+         { "analyse", "EXTMERGE", 14 },
+         { "analyse", "EXIIMAGES", 15 },
+         { "analyse", "LVMIN", 16 },
+         { "analyse", "RANK", 17 },
+         { "snapshot", "CHANNELID", 0 },
+         { "snapshot", "SOURCE", 1 },
+         { "snapshot", "VDRMASTERID", 2 },
+         { "snapshot", "EVENTID", 3 },
+         { "snapshot", "USEID", 4 },
+         { "snapshot", "STARTTIME", 5 },
+         { "snapshot", "DURATION", 6 },
+         { "snapshot", "TITLE", 7 },
+         { "snapshot", "COMPTITLE", 8 },
+         { "snapshot", "SHORTTEXT", 9 },
+         { "snapshot", "COMPSHORTTEXT", 10 },
+         { "snapshot", "UPDSP", 11 },
+         { "snapshot", "EPISODE", 12 },
+         { "snapshot", "MERGE", 13 },
+         { "snapshot", "IMAGES", 14 },
+         { "useevents", "CNTSOURCE", 0 },
+         { "useevents", "CHANNELID", 1 },
+         { "useevents", "CNTEVENTID", 2 },
+         { "useevents", "MASTERID", 3 },
+         { "useevents", "USEID", 4 },
+         { "useevents", "SUBSOURCE", 5 },
+         { "useevents", "SUBEVENTID", 6 },
+         { "useevents", "UPDSP", 7 },
+         { "useevents", "UPDFLG", 8 },
+         { "useevents", "DELFLG", 9 },
+         { "useevents", "FILEREF", 10 },
+         { "useevents", "TABLEID", 11 },
+         { "useevents", "VERSION", 12 },
+         { "useevents", "TITLE", 13 },
+         { "useevents", "SHORTTEXT", 14 },
+         { "useevents", "COMPTITLE", 15 },
+         { "useevents", "COMPSHORTTEXT", 16 },
+         { "useevents", "GENRE", 17 },
+         { "useevents", "COUNTRY", 18 },
+         { "useevents", "YEAR", 19 },
+         { "useevents", "STARTTIME", 20 },
+         { "useevents", "DURATION", 21 },
+         { "useevents", "PARENTALRATING", 22 },
+         { "useevents", "VPS", 23 },
+         { "useevents", "CONTENTS", 24 },
+         { "useevents", "CATEGORY", 25 },
+         { "useevents", "SHORTDESCRIPTION", 26 },
+         { "useevents", "SHORTREVIEW", 27 },
+         { "useevents", "TIPP", 28 },
+         { "useevents", "RATING", 29 },
+         { "useevents", "NUMRATING", 30 },
+         { "useevents", "TXTRATING", 31 },
+         { "useevents", "TOPIC", 32 },
+         { "useevents", "LONGDESCRIPTION", 33 },
+         { "useevents", "COMPLONGDESCRIPTION", 34 },
+         { "useevents", "CNTLONGDESCRIPTION", 35 },
+         { "useevents", "MODERATOR", 36 },
+         { "useevents", "GUEST", 37 },
+         { "useevents", "ACTOR", 38 },
+         { "useevents", "PRODUCER", 39 },
+         { "useevents", "OTHER", 40 },
+         { "useevents", "DIRECTOR", 41 },
+         { "useevents", "COMMENTATOR", 42 },
+         { "useevents", "SCREENPLAY", 43 },
+         { "useevents", "CAMERA", 44 },
+         { "useevents", "MUSIC", 45 },
+         { "useevents", "AUDIO", 46 },
+         { "useevents", "FLAGS", 47 },
+         { "useevents", "IMAGECOUNT", 48 },
+         { "useevents", "SCRSERIESID", 49 },
+         { "useevents", "SCRSERIESEPISODE", 50 },
+         { "useevents", "SCRMOVIEID", 51 },
+         { "useevents", "SCRSP", 52 },
+         { "useevents", "EPISODECOMPNAME", 53 },
+         { "useevents", "EPISODECOMPSHORTNAME", 54 },
+         { "useevents", "EPISODECOMPPARTNAME", 55 },
+         { "useevents", "EPISODENAME", 56 },
+         { "useevents", "EPISODESHORTNAME", 57 },
+         { "useevents", "EPISODEPARTNAME", 58 },
+         { "useevents", "EPISODELANG", 59 },
+         { "useevents", "EPISODEEXTRACOL1", 60 },
+         { "useevents", "EPISODEEXTRACOL2", 61 },
+         { "useevents", "EPISODEEXTRACOL3", 62 },
+         { "useevents", "EPISODESEASON", 63 },
+         { "useevents", "EPISODEPART", 64 },
+         { "useevents", "EPISODEPARTS", 65 },
+         { "useevents", "EPISODENUMBER", 66 },
+         { "recordinglist", "MD5PATH", 0 },
+         { "recordinglist", "STARTTIME", 1 },
+         { "recordinglist", "OWNER", 2 },
+         { "recordinglist", "INSSP", 3 },
+         { "recordinglist", "UPDSP", 4 },
+         { "recordinglist", "LASTIFOUPD", 5 },
+         { "recordinglist", "IMGID", 6 },
+         { "recordinglist", "VDRUUID", 7 },
+         { "recordinglist", "PATH", 8 },
+         { "recordinglist", "NAME", 9 },
+         { "recordinglist", "FOLDER", 10 },
+         { "recordinglist", "TITLE", 11 },
+         { "recordinglist", "SHORTTEXT", 12 },
+         { "recordinglist", "LONGDESCRIPTION", 13 },
+         { "recordinglist", "DESCRIPTION", 14 },
+         { "recordinglist", "DURATION", 15 },
+         { "recordinglist", "FSK", 16 },
+         { "recordinglist", "EVENTID", 17 },
+         { "recordinglist", "CHANNELID", 18 },
+         { "recordinglist", "CHANNELNAME", 19 },
+         { "recordinglist", "STATE", 20 },
+         { "recordinglist", "INUSE", 21 },
+         { "recordinglist", "JOB", 22 },
+         { "recordinglist", "ACTOR", 23 },
+         { "recordinglist", "AUDIO", 24 },
+         { "recordinglist", "CATEGORY", 25 },
+         { "recordinglist", "COUNTRY", 26 },
+         { "recordinglist", "DIRECTOR", 27 },
+         { "recordinglist", "FLAGS", 28 },
+         { "recordinglist", "GENRE", 29 },
+         { "recordinglist", "MUSIC", 30 },
+         { "recordinglist", "PRODUCER", 31 },
+         { "recordinglist", "SCREENPLAY", 32 },
+         { "recordinglist", "SHORTREVIEW", 33 },
+         { "recordinglist", "TIPP", 34 },
+         { "recordinglist", "TOPIC", 35 },
+         { "recordinglist", "YEAR", 36 },
+         { "recordinglist", "RATING", 37 },
+         { "recordinglist", "NUMRATING", 38 },
+         { "recordinglist", "TXTRATING", 39 },
+         { "recordinglist", "MODERATOR", 40 },
+         { "recordinglist", "OTHER", 41 },
+         { "recordinglist", "GUEST", 42 },
+         { "recordinglist", "CAMERA", 43 },
+         { "recordinglist", "EPISODECOMPNAME", 44 },
+         { "recordinglist", "EPISODECOMPSHORTNAME", 45 },
+         { "recordinglist", "EPISODECOMPPARTNAME", 46 },
+         { "recordinglist", "EPISODELANG", 47 },
+         { "recordinglist", "SCRSERIESID", 48 },
+         { "recordinglist", "SCRSERIESEPISODE", 49 },
+         { "recordinglist", "SCRMOVIEID", 50 },
+         { "recordinglist", "SCRINFOMOVIEID", 51 },
+         { "recordinglist", "SCRINFOSERIESID", 52 },
+         { "recordinglist", "SCRINFOEPISODEID", 53 },
+         { "recordinglist", "SCRNEW", 54 },
+         { "recordinglist", "SCRSP", 55 },
+         { "recordingimages", "IMGID", 0 },
+         { "recordingimages", "LFN", 1 },
+         { "recordingimages", "INSSP", 2 },
+         { "recordingimages", "UPDSP", 3 },
+         { "recordingimages", "TITLE", 4 },
+         { "recordingimages", "SHORTTEXT", 5 },
+         { "recordingimages", "IMAGE", 6 },
+         { "recordingdirs", "VDRUUID", 0 },
+         { "recordingdirs", "DIRECTORY", 1 },
+         { "recordingdirs", "INSSP", 2 },
+         { "recordingdirs", "UPDSP", 3 },
+         { "timers", "ID", 0 },
+         { "timers", "VDRUUID", 1 },
+         { "timers", "INSSP", 2 },
+         { "timers", "UPDSP", 3 },
+         { "timers", "EVENTID", 4 },
+         { "timers", "CHANNELID", 5 },
+         { "timers", "EVTSTARTTIME", 6 },
+         { "timers", "_STARTTIME", 7 },
+         { "timers", "_ENDTIME", 8 },
+         { "timers", "SOURCE", 9 },
+         { "timers", "TYPE", 10 },
+         { "timers", "STATE", 11 },
+         { "timers", "INFO", 12 },
+         { "timers", "ACTION", 13 },
+         { "timers", "TCCMAILCNT", 14 },
+         { "timers", "WRNCOUNT", 15 },
+         { "timers", "RETRYS", 16 },
+         { "timers", "NAMINGMODE", 17 },
+         { "timers", "TEMPLATE", 18 },
+         { "timers", "ACTIVE", 19 },
+         { "timers", "DAY", 20 },
+         { "timers", "WEEKDAYS", 21 },
+         { "timers", "STARTTIME", 22 },
+         { "timers", "ENDTIME", 23 },
+         { "timers", "FILE", 24 },
+         { "timers", "DIRECTORY", 25 },
+         { "timers", "PRIORITY", 26 },
+         { "timers", "LIFETIME", 27 },
+         { "timers", "VPS", 28 },
+         { "timers", "CHILDLOCK", 29 },
+         { "timers", "AUX", 30 },
+         { "timers", "AUTOTIMERNAME", 31 },
+         { "timers", "AUTOTIMERID", 32 },
+         { "timers", "AUTOTIMERINSSP", 33 },
+         { "timers", "DONEID", 34 },
+         { "timers", "EXPRESSION", 35 },
+         { "searchtimers", "ID", 0 },
+         { "searchtimers", "INSSP", 1 },
+         { "searchtimers", "UPDSP", 2 },
+         { "searchtimers", "CHANNELIDS", 3 },
+         { "searchtimers", "CHEXCLUDE", 4 },
+         { "searchtimers", "CHFORMAT", 5 },
+         { "searchtimers", "NAME", 6 },
+         { "searchtimers", "EXPRESSION", 7 },
+         { "searchtimers", "EXPRESSION1", 8 },
+         { "searchtimers", "SEARCHMODE", 9 },
+         { "searchtimers", "SEARCHFIELDS", 10 },
+         { "searchtimers", "SEARCHFIELDS1", 11 },
+         { "searchtimers", "CASESENSITIV", 12 },
+         { "searchtimers", "REPEATFIELDS", 13 },
+         { "searchtimers", "EPISODENAME", 14 },
+         { "searchtimers", "SEASON", 15 },
+         { "searchtimers", "SEASONPART", 16 },
+         { "searchtimers", "CATEGORY", 17 },
+         { "searchtimers", "GENRE", 18 },
+         { "searchtimers", "YEAR", 19 },
+         { "searchtimers", "TIPP", 20 },
+         { "searchtimers", "NOEPGMATCH", 21 },
+         { "searchtimers", "TYPE", 22 },
+         { "searchtimers", "STATE", 23 },
+         { "searchtimers", "NAMINGMODE", 24 },
+         { "searchtimers", "TEMPLATE", 25 },
+         { "searchtimers", "ACTIVE", 26 },
+         { "searchtimers", "SOURCE", 27 },
+         { "searchtimers", "HITS", 28 },
+         { "searchtimers", "MODSP", 29 },
+         { "searchtimers", "LASTRUN", 30 },
+         { "searchtimers", "VDRUUID", 31 },
+         { "searchtimers", "WEEKDAYS", 32 },
+         { "searchtimers", "NEXTDAYS", 33 },
+         { "searchtimers", "STARTTIME", 34 },
+         { "searchtimers", "ENDTIME", 35 },
+         { "searchtimers", "DIRECTORY", 36 },
+         { "searchtimers", "PRIORITY", 37 },
+         { "searchtimers", "LIFETIME", 38 },
+         { "searchtimers", "VPS", 39 },
+         { "searchtimers", "CHILDLOCK", 40 },
+         { "timersdone", "ID", 0 },
+         { "timersdone", "INSSP", 1 },
+         { "timersdone", "UPDSP", 2 },
+         { "timersdone", "SOURCE", 3 },
+         { "timersdone", "STATE", 4 },
+         { "timersdone", "TIMERID", 5 },
+         { "timersdone", "AUTOTIMERID", 6 },
+         { "timersdone", "AUTOTIMERNAME", 7 },
+         { "timersdone", "TITLE", 8 },
+         { "timersdone", "COMPTITLE", 9 },
+         { "timersdone", "SHORTTEXT", 10 },
+         { "timersdone", "COMPSHORTTEXT", 11 },
+         { "timersdone", "LONGDESCRIPTION", 12 },
+         { "timersdone", "COMPLONGDESCRIPTION", 13 },
+         { "timersdone", "EPISODECOMPNAME", 14 },
+         { "timersdone", "EPISODECOMPSHORTNAME", 15 },
+         { "timersdone", "EPISODECOMPPARTNAME", 16 },
+         { "timersdone", "EPISODELANG", 17 },
+         { "timersdone", "EPISODESEASON", 18 },
+         { "timersdone", "EPISODEPART", 19 },
+         { "timersdone", "CHANNELID", 20 },
+         { "timersdone", "CHANNELNAME", 21 },
+         { "timersdone", "EXPRESSION", 22 },
+         { "timersdone", "STARTTIME", 23 },
+         { "timersdone", "DURATION", 24 },
+         { "timersdone", "AUX", 25 },
+         { "messages", "ID", 0 },
+         { "messages", "INSSP", 1 },
+         { "messages", "UPDSP", 2 },
+         { "messages", "TYPE", 3 },
+         { "messages", "TITLE", 4 },
+         { "messages", "STATE", 5 },
+         { "messages", "TEXT", 6 },
+         { "series", "SERIESID", 0 },
+         { "series", "SERIESNAME", 1 },
+         { "series", "SERIESLASTSCRAPED", 2 },
+         { "series", "SERIESLASTUPDATED", 3 },
+         { "series", "SERIESOVERVIEW", 4 },
+         { "series", "SERIESFIRSTAIRED", 5 },
+         { "series", "SERIESNETWORK", 6 },
+         { "series", "SERIESIMDBID", 7 },
+         { "series", "SERIESGENRE", 8 },
+         { "series", "SERIESRATING", 9 },
+         { "series", "SERIESSTATUS", 10 },
+         { "series_episode", "EPISODEID", 0 },
+         { "series_episode", "EPISODENUMBER", 1 },
+         { "series_episode", "SEASONNUMBER", 2 },
+         { "series_episode", "EPISODENAME", 3 },
+         { "series_episode", "EPISODEOVERVIEW", 4 },
+         { "series_episode", "EPISODEFIRSTAIRED", 5 },
+         { "series_episode", "EPISODEGUESTSTARS", 6 },
+         { "series_episode", "EPISODERATING", 7 },
+         { "series_episode", "EPISODELASTUPDATED", 8 },
+         { "series_episode", "SERIESID", 9 },
+         { "series_media", "SERIESID", 0 },
+         { "series_media", "SEASONNUMBER", 1 },
+         { "series_media", "EPISODEID", 2 },
+         { "series_media", "ACTORID", 3 },
+         { "series_media", "MEDIATYPE", 4 },
+         { "series_media", "INSSP", 5 },
+         { "series_media", "UPDSP", 6 },
+         { "series_media", "MEDIAURL", 7 },
+         { "series_media", "MEDIAWIDTH", 8 },
+         { "series_media", "MEDIAHEIGHT", 9 },
+         { "series_media", "MEDIARATING", 10 },
+         { "series_media", "MEDIACONTENT", 11 },
+         { "series_actor", "ACTORID", 0 },
+         { "series_actor", "ACTORNAME", 1 },
+         { "series_actor", "ACTORROLE", 2 },
+         { "series_actor", "SORTORDER", 3 },
+         { "movie", "MOVIEID", 0 },
+         { "movie", "TITLE", 1 },
+         { "movie", "ORIGINALTITLE", 2 },
+         { "movie", "TAGLINE", 3 },
+         { "movie", "OVERVIEW", 4 },
+         { "movie", "ISADULT", 5 },
+         { "movie", "COLLECTIONID", 6 },
+         { "movie", "COLLECTIONNAME", 7 },
+         { "movie", "BUDGET", 8 },
+         { "movie", "REVENUE", 9 },
+         { "movie", "GENRES", 10 },
+         { "movie", "HOMEPAGE", 11 },
+         { "movie", "RELEAASEDATE", 12 },
+         { "movie", "RUNTIME", 13 },
+         { "movie", "POPULARITY", 14 },
+         { "movie", "VOTEAVERAGE", 15 },
+         { "movie_actor", "ACTORID", 0 },
+         { "movie_actor", "ACTORNAME", 1 },
+         { "movie_actors", "MOVIEID", 0 },
+         { "movie_actors", "ACTORID", 1 },
+         { "movie_actors", "ROLE", 2 },
+         { "movie_media", "MOVIEID", 0 },
+         { "movie_media", "ACTORID", 1 },
+         { "movie_media", "MEDIATYPE", 2 },
+         { "movie_media", "MEDIAURL", 3 },
+         { "movie_media", "MEDIAWIDTH", 4 },
+         { "movie_media", "MEDIAHEIGHT", 5 },
+         { "movie_media", "MEDIACONTENT", 6 },
+         { 0, 0, 0 }
+      };
+
+      return dbDict.checkIndices(indices, tables);
+   }
+}
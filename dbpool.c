@@ -0,0 +1,383 @@
+/*
+ * dbpool.c: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include "lib/epgservice.h"
+
+#include "plgconfig.h"
+#include "dbpool.h"
+
+//***************************************************************************
+// Service Db
+//***************************************************************************
+
+int cServiceDb::initDb()
+{
+   int status = success;
+
+   exitDb();
+
+   connection = new cDbConnection();
+
+   timerDb = new cDbTable(connection, "timers");
+   if (timerDb->open() != success) return fail;
+
+   vdrDb = new cDbTable(connection, "vdrs");
+   if (vdrDb->open() != success) return fail;
+
+   useeventsDb = new cDbTable(connection, "useevents");
+   if (useeventsDb->open() != success) return fail;
+
+   recordingListDb = new cDbTable(connection, "recordinglist");
+   if (recordingListDb->open() != success) return fail;
+
+   // ----------
+   // select
+   //    t.*,
+   //    v.name, v.state
+   //    from timers t, vdrs v
+   //    where
+   //          (t.state in ('P','R') or t.state is null)
+   //      and t.vdruuid = v.uuid
+   //      and t.type = 'R'
+   //      and t.vdruuid = v.uuid
+   //     order by _starttime
+
+   selectTimers = new cDbStatement(timerDb);
+
+   selectTimers->build("select ");
+   selectTimers->setBindPrefix("t.");
+   selectTimers->bindAllOut();
+   selectTimers->setBindPrefix("v.");
+   selectTimers->bind(vdrDb, "NAME", cDBS::bndOut, ", ");
+   selectTimers->bind(vdrDb, "UUID", cDBS::bndOut, ", ");
+   selectTimers->bind(vdrDb, "STATE", cDBS::bndOut, ", ");
+   selectTimers->clrBindPrefix();
+   selectTimers->build(" from %s t, %s v where t.%s and (t.%s in ('P','R') or t.%s is null)",
+                       timerDb->TableName(), vdrDb->TableName(),
+                       timerDb->getField("ACTIVE")->getDbName(),
+                       timerDb->getField("STATE")->getDbName(),
+                       timerDb->getField("STATE")->getDbName());
+   selectTimers->build(" and t.%s = '%c'",
+                       timerDb->getField("TYPE")->getDbName(), ttRecord);
+   selectTimers->build(" and t.%s = v.%s order by t.%s",
+                       timerDb->getField("VDRUUID")->getDbName(),
+                       vdrDb->getField("UUID")->getDbName(),
+                       timerDb->getField("_STARTTIME")->getDbName());
+
+   status += selectTimers->prepare();
+
+   // select id, eventid, channelid, starttime, state, endtime
+   //   from timers where
+   //     eventid = ? and channelid = ? and vdruuid = ?
+
+   selectTimerByEvent = new cDbStatement(timerDb);
+
+   selectTimerByEvent->build("select ");
+   selectTimerByEvent->bindAllOut();
+   selectTimerByEvent->build(" from %s where %s and (%s in ('P','R') or %s is null)",
+                             timerDb->TableName(),
+                             timerDb->getField("ACTIVE")->getDbName(),
+                             timerDb->getField("STATE")->getDbName(),
+                             timerDb->getField("STATE")->getDbName());
+   selectTimerByEvent->bind("EVENTID", cDBS::bndIn | cDBS::bndSet, " and ");
+
+   status += selectTimerByEvent->prepare();
+
+   // select event by useid
+   // select * from eventsview
+   //      where useid = ?
+   //        and updflg in (.....)
+
+   selectEventById = new cDbStatement(useeventsDb);
+
+   selectEventById->build("select ");
+   selectEventById->bindAllOut();
+   selectEventById->build(" from %s where ", useeventsDb->TableName());
+   selectEventById->bind("USEID", cDBS::bndIn | cDBS::bndSet);
+   selectEventById->build(" and %s in (%s)",
+                          useeventsDb->getField("UPDFLG")->getDbName(),
+                          Us::getNeeded());
+
+   status += selectEventById->prepare();
+
+   ready = status == success;
+
+   return status;
+}
+
+int cServiceDb::exitDb()
+{
+   ready = no;
+
+   if (connection)
+   {
+      delete selectEventById;      selectEventById = 0;
+      delete selectTimers;         selectTimers = 0;
+      delete selectTimerByEvent;   selectTimerByEvent = 0;
+
+      delete useeventsDb;          useeventsDb = 0;
+      delete timerDb;              timerDb = 0;
+      delete vdrDb;                vdrDb = 0;
+      delete recordingListDb;      recordingListDb = 0;
+
+      delete connection;           connection = 0;
+   }
+
+   return done;
+}
+
+int cServiceDb::check()
+{
+   if (!ready || !connection)
+      return fail;
+
+   if (connection->check() != success)
+   {
+      exitDb();
+      return fail;
+   }
+
+   return success;
+}
+
+//***************************************************************************
+// Service Db Pool
+//***************************************************************************
+
+cServiceDbPool::cServiceDbPool(int aSize)
+   : cThread("epg2vdr-dbpool", true)
+{
+   size = std::max(aSize, 1);
+}
+
+cServiceDbPool::~cServiceDbPool()
+{
+   stop();
+}
+
+//***************************************************************************
+// Start / Stop
+//***************************************************************************
+
+int cServiceDbPool::start()
+{
+   stopped = no;
+   loopActive = yes;
+   Start();
+
+   return success;
+}
+
+void cServiceDbPool::stop()
+{
+   if (stopped)                     // called by Stop() of the plugin and the dtor
+      return;
+
+   stopped = yes;
+
+   if (loopActive)
+   {
+      loopActive = no;
+      waitCondition.Broadcast();    // wakeup thread
+      Cancel(5);
+   }
+
+   mutex.Lock();
+
+   // all connections should be released by now, delete the idle ones
+
+   while (!idle.empty())
+   {
+      delete idle.front();
+      idle.pop_front();
+      count--;
+   }
+
+   if (count)
+      tell(0, "Warning: Service db pool stopped with %d connection(s) still in use", count);
+
+   mutex.Unlock();
+
+   showStat();
+}
+
+//***************************************************************************
+// Acquire
+//  - returns a ready (connected and prepared) cServiceDb or 0 on error,
+//    waits up to timeoutMs if all connections are in use
+//***************************************************************************
+
+cServiceDb* cServiceDbPool::acquire(int timeoutMs)
+{
+   cServiceDb* db {};
+   uint64_t start = cTimeMs::Now();
+   uint64_t waited {0};
+
+   mutex.Lock();
+
+   acquires++;
+
+   while (idle.empty() && count >= size)
+   {
+      int left = timeoutMs - (int)(cTimeMs::Now() - start);
+
+      if (left <= 0)
+      {
+         timeouts++;
+         mutex.Unlock();
+
+         tell(0, "Warning: No free service db connection after %d ms", timeoutMs);
+
+         return 0;
+      }
+
+      freeCondition.TimedWait(mutex, left);
+   }
+
+   if ((waited = cTimeMs::Now() - start) > 0)
+   {
+      waits++;
+      waitTotal += waited;
+      waitMax = std::max(waitMax, waited);
+   }
+
+   if (!idle.empty())
+   {
+      db = idle.front();
+      idle.pop_front();
+   }
+   else
+   {
+      db = new cServiceDb();
+      count++;
+   }
+
+   mutex.Unlock();
+
+   // connect and prepare outside of the pool lock,
+   //   a dropped connection is re-established in place by check()
+
+   if (db->isReady() || db->check() == success)
+   {
+      mutex.Lock();
+      hits++;
+      mutex.Unlock();
+   }
+   else if (db->initDb() != success)
+   {
+      db->exitDb();
+      release(db);
+
+      return 0;
+   }
+
+   return db;
+}
+
+//***************************************************************************
+// Release
+//***************************************************************************
+
+void cServiceDbPool::release(cServiceDb* db)
+{
+   if (!db)
+      return;
+
+   // a dropped connection will be reconnected by the next acquire
+
+   mutex.Lock();
+   idle.push_front(db);             // reuse the most recently used first
+   mutex.Unlock();
+
+   freeCondition.Broadcast();
+}
+
+//***************************************************************************
+// Check Idle
+//  - ping the idle connections, drop the broken ones and warm up one
+//    connection in advance
+//***************************************************************************
+
+int cServiceDbPool::checkIdle()
+{
+   std::list<cServiceDb*> checking;
+   int failed {0};
+
+   mutex.Lock();
+
+   if (!count)
+   {
+      idle.push_back(new cServiceDb());
+      count++;
+   }
+
+   checking.swap(idle);
+   mutex.Unlock();
+
+   for (auto db : checking)
+   {
+      if (db->connection)          // ready or dropped, check() reconnects
+      {
+         if (db->check() != success)
+            failed++;
+      }
+      else if (db == checking.front())
+      {
+         db->initDb();              // warm up
+      }
+   }
+
+   mutex.Lock();
+   idle.splice(idle.end(), checking);
+   mutex.Unlock();
+
+   freeCondition.Broadcast();
+
+   if (failed)
+      tell(1, "Service db pool: Dropped %d broken connection(s)", failed);
+
+   return failed ? fail : success;
+}
+
+//***************************************************************************
+// Action
+//***************************************************************************
+
+void cServiceDbPool::Action()
+{
+   cMutex waitMutex;
+
+   waitMutex.Lock();
+
+   while (loopActive && Running())
+   {
+      checkIdle();
+
+      if (Epg2VdrConfig.loglevel > 1)
+         showStat();
+
+      waitCondition.TimedWait(waitMutex, checkInterval * 1000);
+   }
+
+   waitMutex.Unlock();
+}
+
+//***************************************************************************
+// Show Statistic
+//***************************************************************************
+
+void cServiceDbPool::showStat()
+{
+   cMutexLock lock(&mutex);
+
+   tell(1, "Service db pool: %d/%d connection(s), %ld requests, hit rate %.1f%%, "
+        "%ld waits (%.1f ms avg, %lu ms max), %ld timeouts",
+        count, size, acquires,
+        acquires ? hits * 100.0 / acquires : 0.0,
+        waits, waits ? (double)waitTotal / waits : 0.0,
+        (unsigned long)waitMax, timeouts);
+}
@@ -0,0 +1,96 @@
+/*
+ * dbpool.h: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#pragma once
+
+#include <list>
+
+#include <vdr/thread.h>
+
+#include "lib/db.h"
+
+//***************************************************************************
+// Service Db
+//  - one connection with the tables and statements needed by the
+//    plugin services (EPG2VDR_TIMER_SERVICE, ...), prepared once
+//***************************************************************************
+
+class cServiceDb
+{
+   public:
+
+      cServiceDb() {}
+      ~cServiceDb() { exitDb(); }
+
+      int initDb();
+      int exitDb();
+      int check();
+
+      int isReady()  { return ready && connection && connection->isConnected(); }
+
+      cDbConnection* connection {};
+      cDbTable* timerDb {};
+      cDbTable* vdrDb {};
+      cDbTable* useeventsDb {};
+      cDbTable* recordingListDb {};
+      cDbStatement* selectTimers {};
+      cDbStatement* selectTimerByEvent {};
+      cDbStatement* selectEventById {};
+
+   private:
+
+      int ready {no};
+};
+
+//***************************************************************************
+// Service Db Pool
+//  - hands out warm cServiceDb objects and health-checks the idle
+//    ones in background
+//***************************************************************************
+
+class cServiceDbPool : public cThread
+{
+   public:
+
+      cServiceDbPool(int aSize = 2);
+      virtual ~cServiceDbPool();
+
+      int start();
+      void stop();
+
+      cServiceDb* acquire(int timeoutMs = 2000);
+      void release(cServiceDb* db);
+
+      void showStat();
+
+   protected:
+
+      void Action();
+      int checkIdle();
+
+   private:
+
+      int size {2};
+      int count {0};                  // number of created cServiceDb objects
+      int loopActive {no};
+      int stopped {no};
+      int checkInterval {60};         // seconds
+
+      std::list<cServiceDb*> idle;
+      cMutex mutex;
+      cCondVar freeCondition;
+      cCondVar waitCondition;
+
+      // statistic
+
+      long acquires {0};
+      long hits {0};                  // got a warm connection
+      long waits {0};                 // had to wait on a free connection
+      long timeouts {0};
+      uint64_t waitTotal {0};         // ms
+      uint64_t waitMax {0};           // ms
+};
@@ -0,0 +1,664 @@
+/*
+ * eitrecorder.c: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include <vector>
+
+#include "lib/common.h"
+
+#include "handler.h"
+#include "eitrecorder.h"
+
+const char* cEitRecorder::magic = "EPGEITR";
+
+//***************************************************************************
+// Serialization
+//***************************************************************************
+
+static void putU8(std::string& buf, uint8_t v)   { buf.append((const char*)&v, sizeof(v)); }
+static void putU16(std::string& buf, uint16_t v) { buf.append((const char*)&v, sizeof(v)); }
+static void putU32(std::string& buf, uint32_t v) { buf.append((const char*)&v, sizeof(v)); }
+static void putI64(std::string& buf, int64_t v)  { buf.append((const char*)&v, sizeof(v)); }
+
+static void putStr(std::string& buf, const char* s)
+{
+   uint32_t len = s ? strlen(s) : 0;
+
+   putU32(buf, len);
+   buf.append(s ? s : "", len);
+}
+
+class cRecordReader
+{
+   public:
+
+      cRecordReader(const char* aData, size_t aSize) : p(aData), end(aData + aSize) {}
+
+      int eof()     { return p >= end; }
+      int failed()  { return error; }
+      void abort()  { error = yes; }
+
+      uint8_t u8()   { uint8_t v {0};  get(&v, sizeof(v)); return v; }
+      uint16_t u16() { uint16_t v {0}; get(&v, sizeof(v)); return v; }
+      uint32_t u32() { uint32_t v {0}; get(&v, sizeof(v)); return v; }
+      int64_t i64()  { int64_t v {0};  get(&v, sizeof(v)); return v; }
+
+      std::string str()
+      {
+         uint32_t len = u32();
+
+         if (error || len > (size_t)(end - p))
+         {
+            error = yes;
+            return "";
+         }
+
+         std::string s(p, len);
+         p += len;
+
+         return s;
+      }
+
+   private:
+
+      void get(void* v, size_t size)
+      {
+         if (error || size > (size_t)(end - p))
+         {
+            error = yes;
+            return;
+         }
+
+         memcpy(v, p, size);
+         p += size;
+      }
+
+      const char* p;
+      const char* end;
+      int error {no};
+};
+
+//***************************************************************************
+// EIT Recorder
+//***************************************************************************
+
+const char* cEitRecorder::toName(int call)
+{
+   static const char* names[] =
+   {
+      "Channel",
+      "IgnoreChannel",
+      "HandledExternally",
+      "BeginSegmentTransfer",
+      "IsUpdate",
+      "HandleEvent",
+      "DropOutdated",
+      "EndSegmentTransfer",
+
+      0
+   };
+
+   return call >= 0 && call < ctCount ? names[call] : "unknown";
+}
+
+int cEitRecorder::open(const char* file)
+{
+   cMutexLock lock(&mutex);
+   std::string buf;
+
+   if (fp)
+      return fail;
+
+   if (!(fp = fopen(file, "w")))
+   {
+      tell(0, "Handler: Can't open EIT recording '%s', error was '%s'", file, strerror(errno));
+      return fail;
+   }
+
+   buf.append(magic, strlen(magic) + 1);
+   putU32(buf, fileVersion);
+   fwrite(buf.data(), 1, buf.size(), fp);
+
+   fileName = file;
+   startAt = usNow();
+   threads.clear();
+   channels.clear();
+   records = 0;
+   active = yes;
+
+   tell(0, "Handler: Recording the EIT handler calls to '%s'", file);
+
+   return success;
+}
+
+int cEitRecorder::close()
+{
+   cMutexLock lock(&mutex);
+
+   if (!fp)
+      return done;
+
+   active = no;
+   fclose(fp);
+   fp = 0;
+
+   tell(0, "Handler: Stopped EIT recording '%s', %ld calls of %d threads for %d channels recorded",
+        fileName.c_str(), records, (int)threads.size(), (int)channels.size());
+
+   return success;
+}
+
+//***************************************************************************
+// Record
+//  - head() and channelRef() are called with locked mutex
+//***************************************************************************
+
+void cEitRecorder::head(std::string& buf, int call)
+{
+   auto it = threads.find(cThread::ThreadId());
+   uint16_t thread = it != threads.end() ? it->second : threads.size();
+
+   if (it == threads.end())
+      threads[cThread::ThreadId()] = thread;
+
+   putU8(buf, call);
+   putU16(buf, thread);
+   putU32(buf, (usNow() - startAt) / 1000);
+}
+
+int cEitRecorder::channelRef(const cChannel* channel)
+{
+   std::string id = (const char*)channel->GetChannelID().ToString();
+   auto it = channels.find(id);
+
+   if (it != channels.end())
+      return it->second;
+
+   // define the channel
+
+   std::string buf;
+   uint16_t ref = channels.size();
+
+   channels[id] = ref;
+
+   head(buf, ctChannel);
+   putU16(buf, ref);
+   putStr(buf, channel->ToText());
+   write(buf);
+
+   return ref;
+}
+
+void cEitRecorder::channelCall(int call, const cChannel* channel, int flag)
+{
+   std::string buf;
+   cMutexLock lock(&mutex);
+
+   if (!fp)
+      return;
+
+   uint16_t ref = channelRef(channel);
+
+   head(buf, call);
+   putU16(buf, ref);
+
+   if (flag != -1)
+      putU8(buf, flag);
+
+   write(buf);
+}
+
+void cEitRecorder::ignoreChannel(const cChannel* channel)
+{
+   channelCall(ctIgnoreChannel, channel);
+}
+
+void cEitRecorder::handledExternally(const cChannel* channel)
+{
+   channelCall(ctHandledExternally, channel);
+}
+
+void cEitRecorder::begin(const cChannel* channel, bool dummy)
+{
+   channelCall(ctBegin, channel, dummy);
+}
+
+void cEitRecorder::isUpdate(tEventID eventId, time_t startTime, uchar tableId, uchar version)
+{
+   std::string buf;
+   cMutexLock lock(&mutex);
+
+   if (!fp)
+      return;
+
+   head(buf, ctIsUpdate);
+   putU32(buf, eventId);
+   putI64(buf, startTime);
+   putU8(buf, tableId);
+   putU8(buf, version);
+   write(buf);
+}
+
+void cEitRecorder::handleEvent(const cEvent* event)
+{
+   std::string buf;
+   cMutexLock lock(&mutex);
+
+   if (!fp || !event)
+      return;
+
+   head(buf, ctHandleEvent);
+   putU32(buf, event->EventID());
+   putI64(buf, event->StartTime());
+   putU32(buf, event->Duration());
+   putU8(buf, event->TableID());
+   putU8(buf, event->Version());
+   putU32(buf, event->ParentalRating());
+   putI64(buf, event->Vps());
+   putStr(buf, event->Title());
+   putStr(buf, event->ShortText());
+   putStr(buf, event->Description());
+
+   putU8(buf, MaxEventContents);
+
+   for (int i = 0; i < MaxEventContents; i++)
+      putU8(buf, event->Contents(i));
+
+   int count = event->Components() ? event->Components()->NumComponents() : 0;
+
+   putU8(buf, count);
+
+   for (int i = 0; i < count; i++)
+   {
+      tComponent* c = event->Components()->Component(i);
+
+      putU8(buf, c->stream);
+      putU8(buf, c->type);
+      putStr(buf, c->language);
+      putStr(buf, c->description);
+   }
+
+   write(buf);
+}
+
+void cEitRecorder::dropOutdated(time_t segmentStart, time_t segmentEnd, uchar tableId, uchar version)
+{
+   std::string buf;
+   cMutexLock lock(&mutex);
+
+   if (!fp)
+      return;
+
+   head(buf, ctDropOutdated);
+   putI64(buf, segmentStart);
+   putI64(buf, segmentEnd);
+   putU8(buf, tableId);
+   putU8(buf, version);
+   write(buf);
+}
+
+void cEitRecorder::end(bool modified, bool dummy)
+{
+   std::string buf;
+   cMutexLock lock(&mutex);
+
+   if (!fp)
+      return;
+
+   head(buf, ctEnd);
+   putU8(buf, modified);
+   putU8(buf, dummy);
+   write(buf);
+}
+
+void cEitRecorder::write(const std::string& buf)
+{
+   if (!fp)
+      return;
+
+   if (fwrite(buf.data(), 1, buf.size(), fp) != buf.size())
+   {
+      tell(0, "Handler: Error writing EIT recording '%s', error was '%s', stopping",
+           fileName.c_str(), strerror(errno));
+      active = no;
+      fclose(fp);
+      fp = 0;
+      return;
+   }
+
+   records++;
+}
+
+//***************************************************************************
+// EIT Replay
+//***************************************************************************
+
+int cEitReplay::start(const char* aFile, const char* aDatabase)
+{
+   cMutexLock lock(&mutex);
+
+   if (Active())
+      return fail;
+
+   file = aFile;
+   database = aDatabase;
+   report = "Replay of '" + file + "' into database '" + database + "' running";
+   Start();
+
+   return success;
+}
+
+void cEitReplay::stop()
+{
+   Cancel(30);
+}
+
+std::string cEitReplay::getReport()
+{
+   cMutexLock lock(&mutex);
+
+   return report;
+}
+
+//***************************************************************************
+// Action
+//  - own handler db (connection, event index, channel map) and writer on
+//    the replay database
+//***************************************************************************
+
+void cEitReplay::Action()
+{
+   cEpgHandlerDb db;
+   cEpgWriter writer;
+   std::string result;
+
+   db.setDatabase(database.c_str());
+   writer.setDatabase(database.c_str());
+   writer.start();
+
+   replay(&db, &writer, result);
+
+   writer.stop();
+
+   cMutexLock lock(&mutex);
+   report = result;
+}
+
+//***************************************************************************
+// Replay
+//***************************************************************************
+
+int cEitReplay::replay(cEpgHandlerDb* db, cEpgWriter* writer, std::string& report)
+{
+   const char* file = this->file.c_str();
+
+   std::vector<char> data;
+   std::map<uint16_t,cChannel*> channels;
+   std::map<uint16_t,cEpgHandlerInstance*> instances;
+   cDbStatementStat* stats[cEitRecorder::ctCount] {};
+   long calls = 0, events = 0;
+   char line[400];
+   FILE* fp;
+
+   // read the recording
+
+   if (!(fp = fopen(file, "r")))
+   {
+      report = "Error: Can't open '" + std::string(file) + "', " + strerror(errno);
+      return fail;
+   }
+
+   while (!feof(fp))
+   {
+      char buf[64*1024];
+      size_t n = fread(buf, 1, sizeof(buf), fp);
+
+      data.insert(data.end(), buf, buf + n);
+   }
+
+   fclose(fp);
+
+   if (data.size() < strlen(cEitRecorder::magic) + 1 + sizeof(uint32_t) ||
+       strcmp(data.data(), cEitRecorder::magic) != 0)
+   {
+      report = "Error: '" + std::string(file) + "' is no EIT recording";
+      return fail;
+   }
+
+   cRecordReader reader(data.data() + strlen(cEitRecorder::magic) + 1,
+                        data.size() - strlen(cEitRecorder::magic) - 1);
+
+   if (reader.u32() != cEitRecorder::fileVersion)
+   {
+      report = "Error: Unsupported version of EIT recording '" + std::string(file) + "'";
+      return fail;
+   }
+
+   for (int c = 0; c < cEitRecorder::ctCount; c++)
+      stats[c] = new cDbStatementStat(cEitRecorder::toName(c));
+
+   tell(0, "Handler: Starting replay of EIT recording '%s' (%zu bytes)", file, data.size());
+
+   unsigned long dbCallsAt = cDbStatistic::totalCalls();
+   double startAt = usNow();
+
+   // replay the calls
+
+   while (!reader.eof() && !reader.failed() && Running())
+   {
+      int call = reader.u8();
+      uint16_t thread = reader.u16();
+      reader.u32();                      // ms since start of the recording, not used for the benchmark
+
+      if (reader.failed())
+         break;
+
+      if (instances.find(thread) == instances.end())
+         instances[thread] = new cEpgHandlerInstance(db, writer);
+
+      cEpgHandlerInstance* h = instances[thread];
+      double us = usNow();
+
+      switch (call)
+      {
+         case cEitRecorder::ctChannel:
+         {
+            uint16_t ref = reader.u16();
+            std::string text = reader.str();
+
+            cChannel* channel = new cChannel;
+
+            if (reader.failed() || !channel->Parse(text.c_str()))
+            {
+               tell(0, "Handler: Replay, can't parse channel '%s'", text.c_str());
+               delete channel;
+               reader.abort();
+               break;
+            }
+
+            delete channels[ref];
+            channels[ref] = channel;
+            continue;                    // not a call of the handler
+         }
+
+         case cEitRecorder::ctIgnoreChannel:
+         case cEitRecorder::ctHandledExternally:
+         case cEitRecorder::ctBegin:
+         {
+            uint16_t ref = reader.u16();
+            int dummy = call == cEitRecorder::ctBegin ? reader.u8() : no;
+
+            if (reader.failed() || channels.find(ref) == channels.end())
+            {
+               reader.abort();
+               break;
+            }
+
+            if (call == cEitRecorder::ctIgnoreChannel)
+               h->IgnoreChannel(channels[ref]);
+            else if (call == cEitRecorder::ctHandledExternally)
+               h->HandledExternally(channels[ref]);
+            else
+               h->BeginSegmentTransfer(channels[ref], dummy);
+
+            break;
+         }
+
+         case cEitRecorder::ctIsUpdate:
+         {
+            tEventID eventId = reader.u32();
+            time_t startTime = reader.i64();
+            uchar tableId = reader.u8();
+            uchar version = reader.u8();
+
+            if (!reader.failed())
+               h->IsUpdate(eventId, startTime, tableId, version);
+
+            break;
+         }
+
+         case cEitRecorder::ctHandleEvent:
+         {
+            cEvent* event = new cEvent(reader.u32());
+            uchar contents[MaxEventContents] {};
+
+            event->SetStartTime(reader.i64());
+            event->SetDuration(reader.u32());
+            event->SetTableID(reader.u8());
+            event->SetVersion(reader.u8());
+            event->SetParentalRating(reader.u32());
+            event->SetVps(reader.i64());
+            event->SetTitle(reader.str().c_str());
+            event->SetShortText(reader.str().c_str());
+            event->SetDescription(reader.str().c_str());
+
+            int count = reader.u8();
+
+            for (int i = 0; i < count; i++)
+            {
+               uchar content = reader.u8();
+
+               if (i < MaxEventContents)
+                  contents[i] = content;
+            }
+
+            event->SetContents(contents);
+
+            if ((count = reader.u8()) > 0)
+            {
+               cComponents* components = new cComponents;
+
+               for (int i = 0; i < count; i++)
+               {
+                  uchar stream = reader.u8();
+                  uchar type = reader.u8();
+                  std::string language = reader.str();
+                  std::string description = reader.str();
+
+                  components->SetComponent(i, stream, type, language.c_str(), description.c_str());
+               }
+
+               event->SetComponents(components);
+            }
+
+            us = usNow();                // without the decoding
+
+            if (!reader.failed())
+            {
+               h->HandleEvent(event);
+               events++;
+            }
+
+            delete event;
+            break;
+         }
+
+         case cEitRecorder::ctDropOutdated:
+         {
+            time_t segmentStart = reader.i64();
+            time_t segmentEnd = reader.i64();
+            uchar tableId = reader.u8();
+            uchar version = reader.u8();
+
+            if (!reader.failed())
+               h->DropOutdated(0, segmentStart, segmentEnd, tableId, version);
+
+            break;
+         }
+
+         case cEitRecorder::ctEnd:
+         {
+            int modified = reader.u8();
+            int dummy = reader.u8();
+
+            if (!reader.failed())
+               h->EndSegmentTransfer(modified, dummy);
+
+            break;
+         }
+
+         default:
+         {
+            tell(0, "Handler: Replay, unexpected call %d, aborting", call);
+            reader.abort();
+            break;
+         }
+      }
+
+      if (call > cEitRecorder::ctChannel && call < cEitRecorder::ctCount)
+      {
+         cDbStatistic::record(stats[call], usNow() - us, 0, no);
+         calls++;
+      }
+   }
+
+   int status = reader.failed() || !Running() ? fail : success;
+   double callsDone = usNow();
+
+   // wait for the writer to get the db round trips of the whole replay
+
+   if (writer->waitIdle(60 * 1000) != success)
+      tell(0, "Handler: Replay, writer still busy after 60 seconds");
+
+   double writerDone = usNow();
+   unsigned long dbCalls = cDbStatistic::totalCalls() - dbCallsAt;
+
+   // report
+
+   double seconds = (callsDone - startAt) / 1000000;
+
+   snprintf(line, sizeof(line), "Replay of '%s' into '%s' %s: %ld calls, %ld events in %.2f s (%.0f events/s), "
+            "written after %.2f s", file, database.c_str(), status == success ? "done" : Running() ? "aborted (invalid recording)" : "stopped",
+            calls, events, seconds, seconds > 0 ? events / seconds : 0.0, (writerDone - startAt) / 1000000);
+   report = line;
+
+   snprintf(line, sizeof(line), "\n%-22s %9s %8s %8s %8s %9s", "call", "calls", "p50[ms]", "p95[ms]", "p99[ms]", "max[ms]");
+   report += line;
+
+   for (int c = cEitRecorder::ctIgnoreChannel; c < cEitRecorder::ctCount; c++)
+   {
+      cDbStatementStat* stat = stats[c];
+
+      snprintf(line, sizeof(line), "\n%-22s %9lu %8.2f %8.2f %8.2f %9.2f", cEitRecorder::toName(c), stat->calls,
+               stat->percentile(0.50), stat->percentile(0.95), stat->percentile(0.99), stat->max / 1000);
+      report += line;
+      delete stat;
+   }
+
+   snprintf(line, sizeof(line), "\ndb round trips %lu (%.1f per event), incl. the writer and other threads",
+            dbCalls, events ? (double)dbCalls / events : 0.0);
+   report += line;
+
+   tell(0, "Handler: %s", report.c_str());
+
+   for (auto& i : instances)
+      delete i.second;
+
+   for (auto& c : channels)
+      delete c.second;
+
+   return status;
+}
@@ -0,0 +1,123 @@
+/*
+ * eitrecorder.h: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <string>
+#include <map>
+#include <atomic>
+
+#include <vdr/thread.h>
+#include <vdr/channels.h>
+#include <vdr/epg.h>
+
+class cEpgHandlerDb;
+class cEpgWriter;
+
+//***************************************************************************
+// EIT Recorder
+//  - records the calls of the EIT handler to a file, to replay them
+//    offline by cEitReplay (without DVB reception)
+//  - file: header (magic, version), then one record per call
+//      u8 call, u16 thread, u32 ms since start, the arguments of the call
+//    a channel is defined once by a ctChannel record (reference, channels.conf line)
+//***************************************************************************
+
+class cEitRecorder
+{
+   public:
+
+      enum Call
+      {
+         ctChannel,
+         ctIgnoreChannel,
+         ctHandledExternally,
+         ctBegin,
+         ctIsUpdate,
+         ctHandleEvent,
+         ctDropOutdated,
+         ctEnd,
+
+         ctCount
+      };
+
+      cEitRecorder() {}
+      ~cEitRecorder() { close(); }
+
+      int open(const char* file);
+      int close();
+      int isActive()  { return active; }
+
+      void ignoreChannel(const cChannel* channel);
+      void handledExternally(const cChannel* channel);
+      void begin(const cChannel* channel, bool dummy);
+      void isUpdate(tEventID eventId, time_t startTime, uchar tableId, uchar version);
+      void handleEvent(const cEvent* event);
+      void dropOutdated(time_t segmentStart, time_t segmentEnd, uchar tableId, uchar version);
+      void end(bool modified, bool dummy);
+
+      static const char* toName(int call);
+      static const char* magic;
+
+      enum Misc
+      {
+         fileVersion = 1
+      };
+
+   private:
+
+      void head(std::string& buf, int call);
+      int channelRef(const cChannel* channel);
+      void channelCall(int call, const cChannel* channel, int flag = -1);
+      void write(const std::string& buf);
+
+      std::atomic<int> active {false};
+      cMutex mutex;
+      FILE* fp {};
+      std::string fileName;
+      double startAt {0};                        // us
+      std::map<tThreadId,uint16_t> threads;
+      std::map<std::string,uint16_t> channels;
+      long records {0};
+};
+
+//***************************************************************************
+// EIT Replay
+//  - drives handler instances (one per recorded thread) by a recording,
+//    as fast as possible, and reports the events per second, the latency
+//    of the calls and the db round trips (incl. the writer)
+//  - runs in it's own thread against the given database with it's own
+//    event index and writer, the live handler and database stay untouched
+//***************************************************************************
+
+class cEitReplay : public cThread
+{
+   public:
+
+      cEitReplay() : cThread("epg2vdr-replay", true) {}
+      ~cEitReplay() { stop(); }
+
+      int start(const char* aFile, const char* aDatabase);   // fail if a replay is running
+      void stop();
+      int isRunning()  { return Active(); }
+      std::string getReport();
+
+   protected:
+
+      void Action();
+      int replay(cEpgHandlerDb* db, cEpgWriter* writer, std::string& report);
+
+   private:
+
+      cMutex mutex;
+      std::string file;
+      std::string database;
+      std::string report;                        // of the last replay
+};
@@ -419,122 +419,10 @@ cPluginEPG2VDR::cPluginEPG2VDR()
 
 cPluginEPG2VDR::~cPluginEPG2VDR()
 {
-   exitDb();
+   delete servicePool;
    delete oUpdate;
 }
 
-int cPluginEPG2VDR::initDb()
-{
-   int status = success;
-
-   exitDb();
-
-   connection = new cDbConnection();
-
-   timerDb = new cDbTable(connection, "timers");
-   if (timerDb->open() != success) return fail;
-
-   vdrDb = new cDbTable(connection, "vdrs");
-   if (vdrDb->open() != success) return fail;
-
-   useeventsDb = new cDbTable(connection, "useevents");
-   if (useeventsDb->open() != success) return fail;
-
-   recordingListDb = new cDbTable(connection, "recordinglist");
-   if (recordingListDb->open() != success) return fail;
-
-   // ----------
-   // select
-   //    t.*,
-   //    v.name, v.state
-   //    from timers t, vdrs v
-   //    where
-   //          (t.state in ('P','R') or t.state is null)
-   //      and t.vdruuid = v.uuid
-   //      and t.type = 'R'
-   //      and t.vdruuid = v.uuid
-   //     order by _starttime
-
-   selectTimers = new cDbStatement(timerDb);
-
-   selectTimers->build("select ");
-   selectTimers->setBindPrefix("t.");
-   selectTimers->bindAllOut();
-   selectTimers->setBindPrefix("v.");
-   selectTimers->bind(vdrDb, "NAME", cDBS::bndOut, ", ");
-   selectTimers->bind(vdrDb, "UUID", cDBS::bndOut, ", ");
-   selectTimers->bind(vdrDb, "STATE", cDBS::bndOut, ", ");
-   selectTimers->clrBindPrefix();
-   selectTimers->build(" from %s t, %s v where t.%s and (t.%s in ('P','R') or t.%s is null)",
-                       timerDb->TableName(), vdrDb->TableName(),
-                       timerDb->getField("ACTIVE")->getDbName(),
-                       timerDb->getField("STATE")->getDbName(),
-                       timerDb->getField("STATE")->getDbName());
-   selectTimers->build(" and t.%s = '%c'",
-                       timerDb->getField("TYPE")->getDbName(), ttRecord);
-   selectTimers->build(" and t.%s = v.%s order by t.%s",
-                       timerDb->getField("VDRUUID")->getDbName(),
-                       vdrDb->getField("UUID")->getDbName(),
-                       timerDb->getField("_STARTTIME")->getDbName());
-
-   status += selectTimers->prepare();
-
-   // select id, eventid, channelid, starttime, state, endtime
-   //   from timers where
-   //     eventid = ? and channelid = ? and vdruuid = ?
-
-   selectTimerByEvent = new cDbStatement(timerDb);
-
-   selectTimerByEvent->build("select ");
-   selectTimerByEvent->bindAllOut();
-   selectTimerByEvent->build(" from %s where %s and (%s in ('P','R') or %s is null)",
-                             timerDb->TableName(),
-                             timerDb->getField("ACTIVE")->getDbName(),
-                             timerDb->getField("STATE")->getDbName(),
-                             timerDb->getField("STATE")->getDbName());
-   selectTimerByEvent->bind("EVENTID", cDBS::bndIn | cDBS::bndSet, " and ");
-
-   status += selectTimerByEvent->prepare();
-
-   // select event by useid
-   // select * from eventsview
-   //      where useid = ?
-   //        and updflg in (.....)
-
-   selectEventById = new cDbStatement(useeventsDb);
-
-   selectEventById->build("select ");
-   selectEventById->bindAllOut();
-   selectEventById->build(" from %s where ", useeventsDb->TableName());
-   selectEventById->bind("USEID", cDBS::bndIn | cDBS::bndSet);
-   selectEventById->build(" and %s in (%s)",
-                          useeventsDb->getField("UPDFLG")->getDbName(),
-                          Us::getNeeded());
-
-   status += selectEventById->prepare();
-
-   return status;
-}
-
-int cPluginEPG2VDR::exitDb()
-{
-   if (connection)
-   {
-      delete selectEventById;      selectEventById = 0;
-      delete selectTimers;         selectTimers = 0;
-      delete selectTimerByEvent;   selectTimerByEvent = 0;
-
-      delete useeventsDb;          useeventsDb = 0;
-      delete timerDb;              timerDb = 0;
-      delete vdrDb;                vdrDb = 0;
-      delete recordingListDb;      recordingListDb = 0;
-
-      delete connection;           connection = 0;
-   }
-
-   return done;
-}
-
 void cPluginEPG2VDR::DisplayMessage(const char *s)
 {
    tell(0, "%s", s);
@@ -564,6 +452,16 @@ const char **cPluginEPG2VDR::SVDRPHelpPages()
       "    Trigger update of recordings",
       "STOREIFO\n"
       "    Trigger store of recordin info files",
+      "DBSTAT [RESET | SLOW [<ms>]]\n"
+      "    Show latency statistic of the db statements,\n"
+      "    RESET the statistic, show the captured SLOW statements\n"
+      "    or capture statements slower than <ms> (0 = off)",
+      "EITREC <file> | STOP\n"
+      "    Record the calls of the EIT handler to <file>, or STOP the recording",
+      "EITREPLAY <file> <database> | STATUS\n"
+      "    Replay a EIT recording in background into <database> (not the\n"
+      "    configured one) and report events per second, the latency of\n"
+      "    the calls and the db round trips, STATUS shows the report",
       0
    };
 
@@ -608,6 +506,100 @@ cString cPluginEPG2VDR::SVDRPCommand(const char* cmd, const char* Option, int &R
       return "EPG2VDR store of info files triggert.";
    }
 
+   // ------------------------------------
+   // db statement statistic
+
+   else if (strcasecmp(cmd, "DBSTAT") == 0)
+   {
+      if (isEmpty(Option))
+         return cDbStatistic::report().c_str();
+
+      if (strcasecmp(Option, "RESET") == 0)
+      {
+         cDbStatistic::reset();
+         return "EPG2VDR db statistic reset";
+      }
+
+      if (strncasecmp(Option, "SLOW", 4) == 0)
+      {
+         const char* ms = skipspace(Option + 4);
+
+         if (isEmpty(ms))
+            return cDbStatistic::reportSlow().c_str();
+
+         cDbStatistic::slowThreshold = std::max(atoi(ms), 0);
+
+         if (!cDbStatistic::slowThreshold)
+            return "EPG2VDR slow statement capture off";
+
+         return cString::sprintf("EPG2VDR slow statement capture at %d ms", cDbStatistic::slowThreshold);
+      }
+
+      ReplyCode = 901;
+      return "Error: Unexpected option";
+   }
+
+   // ------------------------------------
+   // record / replay the EIT handler calls
+
+   else if (strcasecmp(cmd, "EITREC") == 0)
+   {
+      if (isEmpty(Option))
+      {
+         ReplyCode = 901;
+         return "Error: Missing option";
+      }
+
+      if (strcasecmp(Option, "STOP") == 0)
+      {
+         cEpg2VdrEpgHandler::getSingleton()->stopRecording();
+         return "EPG2VDR EIT recording stopped";
+      }
+
+      if (cEpg2VdrEpgHandler::getSingleton()->startRecording(Option) != success)
+      {
+         ReplyCode = 550;
+         return cString::sprintf("Error: Can't start recording to '%s', see syslog", Option);
+      }
+
+      return cString::sprintf("EPG2VDR recording the EIT handler calls to '%s'", Option);
+   }
+
+   else if (strcasecmp(cmd, "EITREPLAY") == 0)
+   {
+      char file[512+TB] = "";
+      char database[100+TB] = "";
+
+      if (isEmpty(Option))
+      {
+         ReplyCode = 901;
+         return "Error: Missing option";
+      }
+
+      if (strcasecmp(Option, "STATUS") == 0)
+         return cString::sprintf("%s", cEpg2VdrEpgHandler::getSingleton()->replayReport().c_str());
+
+      if (sscanf(Option, "%512s %100s", file, database) != 2)
+      {
+         ReplyCode = 901;
+         return "Error: Missing database";
+      }
+
+      if (strcasecmp(database, Epg2VdrConfig.dbName) == 0)
+      {
+         ReplyCode = 550;
+         return "Error: Replay into the configured database denied";
+      }
+
+      if (cEpg2VdrEpgHandler::getSingleton()->startReplay(file, database) != success)
+      {
+         ReplyCode = 550;
+         return "Error: A replay is already running";
+      }
+
+      return cString::sprintf("EPG2VDR replay of '%s' into '%s' started, see EITREPLAY STATUS", file, database);
+   }
+
    // ------------------------------------
    // inform about epgd's state change
 
@@ -885,36 +877,24 @@ bool cPluginEPG2VDR::Service(const char* id, void* data)
 
    if (strcmp(id, EPG2VDR_TIMER_SERVICE) == 0 || strcmp(id, EPG2VDR_REC_DETAIL_SERVICE) == 0 || strcmp(id, EPG2VDR_TIMER_DETAIL_SERVICE) == 0)
    {
-      // Services with direct db access
+      // Services with direct db access, use a prepared connection of the pool
 
-      cMutexLock lock(&mutexServiceWithDb);
+      int result = false;
+      cServiceDb* db = servicePool->acquire();
 
-      if (initDb() == success)
-      {
-         if (strcmp(id, EPG2VDR_TIMER_SERVICE) == 0)
-         {
-            cEpgTimer_Service_V1* ts = (cEpgTimer_Service_V1*)data;
+      if (!db)
+         return false;
 
-            if (ts)
-               return timerService(ts);
-         }
-         if (strcmp(id, EPG2VDR_TIMER_DETAIL_SERVICE) == 0)
-         {
-            cTimer_Detail_V1* d = (cTimer_Detail_V1*)data;
+      if (strcmp(id, EPG2VDR_TIMER_SERVICE) == 0)
+         result = timerService(db, (cEpgTimer_Service_V1*)data);
+      else if (strcmp(id, EPG2VDR_TIMER_DETAIL_SERVICE) == 0)
+         result = hasTimerService(db, (cTimer_Detail_V1*)data);
+      else if (strcmp(id, EPG2VDR_REC_DETAIL_SERVICE) == 0)
+         result = recordingDetails(db, (cEpgRecording_Details_Service_V1*)data);
 
-            if (d)
-               return hasTimerService(d);
-         }
-         else if (strcmp(id, EPG2VDR_REC_DETAIL_SERVICE) == 0)
-         {
-            cEpgRecording_Details_Service_V1* rd = (cEpgRecording_Details_Service_V1*)data;
-
-            if (rd)
-               return recordingDetails(rd);
-         }
+      servicePool->release(db);
 
-         exitDb();
-      }
+      return result;
    }
 
    return false;
@@ -924,28 +904,26 @@ bool cPluginEPG2VDR::Service(const char* id, void* data)
 // Has Timer Service
 //***************************************************************************
 
-int cPluginEPG2VDR::hasTimerService(cTimer_Detail_V1* d)
+int cPluginEPG2VDR::hasTimerService(cServiceDb* db, cTimer_Detail_V1* d)
 {
-   cMutexLock lock(&mutexTimerService);
-
    d->hastimer = no;
    d->local = yes;
    d->type = ttRecord;
 
-   timerDb->clear();
-   timerDb->setValue("EVENTID", d->eventid);
+   db->timerDb->clear();
+   db->timerDb->setValue("EVENTID", d->eventid);
 
-   if (selectTimerByEvent->find())
+   if (db->selectTimerByEvent->find())
    {
       d->hastimer = yes;
-      d->local = timerDb->hasValue("VDRUUID", Epg2VdrConfig.uuid);
-      d->type = timerDb->getValue("TYPE")->getCharValue();
+      d->local = db->timerDb->hasValue("VDRUUID", Epg2VdrConfig.uuid);
+      d->type = db->timerDb->getValue("TYPE")->getCharValue();
 
       tell(3, "timer service found '%s' timer (%ld) for event (%ld) type '%c'",
-           d->local ? "local" : "remote", timerDb->getIntValue("ID"), d->eventid, d->type);
+           d->local ? "local" : "remote", db->timerDb->getIntValue("ID"), d->eventid, d->type);
    }
 
-   selectTimerByEvent->freeResult();
+   db->selectTimerByEvent->freeResult();
 
    return true;
 }
@@ -954,19 +932,18 @@ int cPluginEPG2VDR::hasTimerService(cTimer_Detail_V1* d)
 // Timer Service
 //***************************************************************************
 
-int cPluginEPG2VDR::timerService(cEpgTimer_Service_V1* ts)
+int cPluginEPG2VDR::timerService(cServiceDb* db, cEpgTimer_Service_V1* ts)
 {
-   cMutexLock lock(&mutexTimerService);
    uint64_t start = cTimeMs::Now();
 
-   timerDb->clear();
-   vdrDb->clear();
+   db->timerDb->clear();
+   db->vdrDb->clear();
 
    ts->epgTimers.clear();
 
-   for (int f = selectTimers->find(); f && connection->check() == success; f = selectTimers->fetch())
+   for (int f = db->selectTimers->find(); f && db->connection->check() == success; f = db->selectTimers->fetch())
    {
-      cEpgTimer* epgTimer = newTimerObjectFromRow(timerDb->getRow(), vdrDb->getRow());
+      cEpgTimer* epgTimer = newTimerObjectFromRow(db->timerDb->getRow(), db->vdrDb->getRow());
 
       if (Epg2VdrConfig.shareInWeb || epgTimer->isLocal())
          ts->epgTimers.push_back(epgTimer);
@@ -974,7 +951,7 @@ int cPluginEPG2VDR::timerService(cEpgTimer_Service_V1* ts)
          delete epgTimer;
    }
 
-   selectTimers->freeResult();
+   db->selectTimers->freeResult();
 
    tell(1, "Answer '%s' call with %zd timers, duration was (%s)",
         EPG2VDR_TIMER_SERVICE,
@@ -990,7 +967,7 @@ int cPluginEPG2VDR::timerService(cEpgTimer_Service_V1* ts)
 
 #include <vdr/videodir.h>
 
-int cPluginEPG2VDR::recordingDetails(cEpgRecording_Details_Service_V1* rd)
+int cPluginEPG2VDR::recordingDetails(cServiceDb* db, cEpgRecording_Details_Service_V1* rd)
 {
    int found = false;
 
@@ -1016,24 +993,24 @@ int cPluginEPG2VDR::recordingDetails(cEpgRecording_Details_Service_V1* rd)
 
    createMd5(recording->FileName()+pathOffset, md5path);
 
-   recordingListDb->clear();
+   db->recordingListDb->clear();
 
-   recordingListDb->setValue("MD5PATH", md5path);
-   recordingListDb->setValue("STARTTIME", recording->Start());
-   recordingListDb->setValue("OWNER", Epg2VdrConfig.useCommonRecFolder ? "" : Epg2VdrConfig.uuid);
+   db->recordingListDb->setValue("MD5PATH", md5path);
+   db->recordingListDb->setValue("STARTTIME", recording->Start());
+   db->recordingListDb->setValue("OWNER", Epg2VdrConfig.useCommonRecFolder ? "" : Epg2VdrConfig.uuid);
 
    cXml xml;
 
-   found = recordingListDb->find();
+   found = db->recordingListDb->find();
 
    xml.create("epg2vdr");
 
    if (found)
-      cEventDetails::row2Xml(recordingListDb->getRow(), &xml);
+      cEventDetails::row2Xml(db->recordingListDb->getRow(), &xml);
 
    rd->details = xml.toText();
 
-   recordingListDb->reset();
+   db->recordingListDb->reset();
 
 #endif
 
@@ -1066,6 +1043,12 @@ bool cPluginEPG2VDR::Start()
    if (oUpdate->init() == success)
    {
       oUpdate->Start();                 // start plugin thread
+
+      servicePool = new cServiceDbPool();
+      servicePool->start();             // start health check thread of the service connections
+
+      cEpg2VdrEpgHandler::getSingleton()->getWriter()->start();   // write behind of the EIT handler
+
       pluginInitialized = yes;
    }
    else
@@ -1146,6 +1129,9 @@ bool cPluginEPG2VDR::SetupParse(const char *Name, const char *Value)
    else if (!strcasecmp(Name, "User"))                 sstrcpy(Epg2VdrConfig.user, Value, sizeof(Epg2VdrConfig.user));
    else if (!strcasecmp(Name, "ExtendedEpgData2Aux"))  Epg2VdrConfig.extendedEpgData2Aux = atoi(Value);
    else if (!strcasecmp(Name, "SwTimerNotifyTime"))    Epg2VdrConfig.switchTimerNotifyTime = atoi(Value);
+   else if (!strcasecmp(Name, "SlowQueryMs"))          cDbStatistic::slowThreshold = Epg2VdrConfig.slowQueryMs = atoi(Value);
+   else if (!strcasecmp(Name, "FetchWorkers"))         Epg2VdrConfig.fetchWorkers = atoi(Value);
+   else if (!strcasecmp(Name, "LazyPrepare"))          cDbStatement::lazyPrepare = Epg2VdrConfig.lazyPrepare = atoi(Value);
 
    else
       return false;
@@ -1157,6 +1143,11 @@ void cPluginEPG2VDR::Stop()
 {
    oUpdate->Stop();
 
+   if (servicePool)
+      servicePool->stop();
+
+   cEpg2VdrEpgHandler::getSingleton()->stop();
+
    Mysql_Init_Exit_v1_0 req;
 
    req.action = mieaExit;
@@ -15,6 +15,7 @@
 #include "HISTORY.h"
 
 #include "lib/db.h"
+#include "dbpool.h"
 
 class cUpdate;
 class cEpg2VdrEpgHandler;
@@ -59,24 +60,12 @@ class cPluginEPG2VDR : public cPlugin
 
    protected:
 
-      int initDb();
-      int exitDb();
-
-      int timerService(cEpgTimer_Service_V1* ts);
-      int hasTimerService(cTimer_Detail_V1* d);
-      int recordingDetails(cEpgRecording_Details_Service_V1* rd);
+      int timerService(cServiceDb* db, cEpgTimer_Service_V1* ts);
+      int hasTimerService(cServiceDb* db, cTimer_Detail_V1* d);
+      int recordingDetails(cServiceDb* db, cEpgRecording_Details_Service_V1* rd);
 
    private:
 
       int pluginInitialized {false};
-      cDbConnection* connection {};
-      cDbTable* timerDb {};
-      cDbTable* vdrDb {};
-      cDbTable* useeventsDb {};
-      cDbTable* recordingListDb {};
-      cDbStatement* selectTimers {};
-      cDbStatement* selectTimerByEvent {};
-      cDbStatement* selectEventById {};
-      cMutex mutexTimerService {};
-      cMutex mutexServiceWithDb {};
+      cServiceDbPool* servicePool {};
 };
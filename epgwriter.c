@@ -0,0 +1,850 @@
+/*
+ * epgwriter.c: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include "lib/epgservice.h"
+
+#include "plgconfig.h"
+#include "epgwriter.h"
+
+//***************************************************************************
+// EPG Record
+//***************************************************************************
+
+uint64_t cEpgRecord::contentHash() const
+{
+   uint64_t hash = 0xcbf29ce484222325ULL;
+
+   auto add = [&hash](const void* data, size_t size)
+   {
+      for (size_t i = 0; i < size; i++)
+      {
+         hash ^= ((const uint8_t*)data)[i];
+         hash *= 0x100000001b3ULL;
+      }
+   };
+
+   auto addStr = [&add](const std::string& s) { add(s.c_str(), s.length() + 1); };
+
+   add(&eventId, sizeof(eventId));
+   add(&duration, sizeof(duration));
+   add(&parentalRating, sizeof(parentalRating));
+   add(&vps, sizeof(vps));
+   add(&hasTitle, sizeof(hasTitle));
+   add(&hasDescription, sizeof(hasDescription));
+   addStr(title);
+   addStr(shortText);
+   addStr(description);
+   addStr(contents);
+
+   for (const auto& c : components)
+   {
+      add(&c.stream, sizeof(c.stream));
+      add(&c.type, sizeof(c.type));
+      addStr(c.lang);
+      addStr(c.description);
+   }
+
+   return hash ? hash : 1;         // 0 is reserved for 'unknown'
+}
+
+uint32_t cEpgRecord::componentsHash() const
+{
+   uint32_t hash = 0x811c9dc5;
+
+   auto add = [&hash](const void* data, size_t size)
+   {
+      for (size_t i = 0; i < size; i++)
+      {
+         hash ^= ((const uint8_t*)data)[i];
+         hash *= 0x01000193;
+      }
+   };
+
+   for (const auto& c : components)
+   {
+      add(&c.stream, sizeof(c.stream));
+      add(&c.type, sizeof(c.type));
+      add(c.lang.c_str(), c.lang.length() + 1);
+      add(c.description.c_str(), c.description.length() + 1);
+   }
+
+   return hash ? hash : 1;         // 0 is reserved for 'unknown'
+}
+
+//***************************************************************************
+// EPG Segment
+//***************************************************************************
+
+void cEpgSegment::revertIndex()
+{
+   if (!index)
+      return;
+
+   for (const auto& r : records)
+   {
+      if (r.type != cEpgRecord::rtDrop)
+         index->removeLater(channel, r.startTime);
+   }
+}
+
+//***************************************************************************
+// EPG Writer
+//***************************************************************************
+
+int cEpgWriter::maxQueued = 2000;
+int cEpgWriter::maxBatch = 50;
+int cEpgWriter::maxTries = 3;
+
+cEpgWriter::cEpgWriter()
+   : cThread("epg2vdr-writer", true)
+{
+}
+
+cEpgWriter::~cEpgWriter()
+{
+   stop();
+}
+
+//***************************************************************************
+// Start / Stop
+//***************************************************************************
+
+int cEpgWriter::start()
+{
+   if (loopActive)
+      return done;
+
+   loopActive = yes;
+   statAt = time(0);
+   Start();
+
+   return success;
+}
+
+void cEpgWriter::stop()
+{
+   if (!loopActive)
+      return;
+
+   // the thread writes the queued segments before it ends
+
+   mutex.Lock();
+   loopActive = no;
+   condition.Broadcast();
+   mutex.Unlock();
+
+   for (int i = 0; i < 200 && Active(); i++)
+      cCondWait::SleepMs(50);
+
+   Cancel(1);
+
+   mutex.Lock();
+
+   if (queue.size())
+      tell(0, "Handler: Writer stopped with %d unwritten segments", (int)queue.size());
+
+   for (auto s : queue)
+   {
+      s->revertIndex();
+      delete s;
+   }
+
+   queue.clear();
+   mutex.Unlock();
+
+   exitDb();
+   showStat();
+}
+
+//***************************************************************************
+// Enqueue
+//  - called by the EIT thread, never waits on the database
+//***************************************************************************
+
+int cEpgWriter::enqueue(cEpgSegment* segment)
+{
+   cMutexLock lock(&mutex);
+
+   if (!loopActive || (int)queue.size() >= maxQueued)
+   {
+      dropped++;
+      return fail;
+   }
+
+   segment->queuedAt = cTimeMs::Now();
+   queue.push_back(segment);
+   maxDepth = std::max(maxDepth, queue.size());
+   condition.Broadcast();
+
+   return success;
+}
+
+//***************************************************************************
+// Wait Idle
+//***************************************************************************
+
+int cEpgWriter::waitIdle(int timeoutMs)
+{
+   cTimeMs timeout(timeoutMs);
+   cMutexLock lock(&mutex);
+
+   while ((!queue.empty() || inWork) && loopActive && !timeout.TimedOut())
+      condition.TimedWait(mutex, 100);
+
+   return queue.empty() && !inWork ? success : fail;
+}
+
+//***************************************************************************
+// Action
+//***************************************************************************
+
+void cEpgWriter::Action()
+{
+   std::vector<cEpgSegment*> batch;
+
+   while (Running())
+   {
+      // wait for work
+
+      mutex.Lock();
+
+      while (queue.empty() && loopActive)
+         condition.TimedWait(mutex, 1000);
+
+      if (queue.empty() && !loopActive)
+      {
+         mutex.Unlock();
+         break;
+      }
+
+      // database down, back off until the next connect attempt
+
+      if (!dbConnected() && time(0) < reconnectAt)
+      {
+         if (loopActive)
+            condition.TimedWait(mutex, 1000);
+
+         int stopping = !loopActive;
+         mutex.Unlock();
+
+         if (stopping)
+            break;
+
+         continue;
+      }
+
+      for (int i = 0; i < maxBatch && !queue.empty(); i++)
+      {
+         batch.push_back(queue.front());
+         queue.pop_front();
+      }
+
+      inWork = batch.size();
+      mutex.Unlock();
+
+      // connect
+
+      int status = success;
+
+      if (!dbConnected() && initDb() != success)
+      {
+         exitDb();
+         status = fail;
+
+         reconnectDelay = reconnectDelay ? std::min(reconnectDelay * 2, 60) : 2;
+         reconnectAt = time(0) + reconnectDelay;
+         tell(0, "Handler: Writer can't connect to the database, retrying in %d seconds", reconnectDelay);
+      }
+      else
+      {
+         reconnectDelay = 0;
+      }
+
+      // write the batch in one transaction, if it fails write the segments
+      //   one by one, so only the failing segments count against maxTries.
+      //   The later segments of a channel with a failed segment are deferred
+      //   to keep the order of the updates of the channel
+
+      std::vector<int> failed(batch.size(), status == success ? wsWritten : wsDeferred);
+
+      if (status == success && writeTransaction(batch) != success)
+      {
+         std::set<std::string> failedChannels;
+
+         failed.assign(batch.size(), batch.size() > 1 ? wsDeferred : wsFailed);
+
+         for (size_t i = 0; i < batch.size() && batch.size() > 1 && dbConnected(); i++)
+         {
+            std::vector<cEpgSegment*> single { batch[i] };
+
+            if (failedChannels.count(batch[i]->channelId))
+               continue;
+
+            if (writeTransaction(single) == success)
+               failed[i] = wsWritten;
+            else
+            {
+               failed[i] = wsFailed;
+               failedChannels.insert(batch[i]->channelId);
+            }
+         }
+      }
+
+      // a failed segment is queued again, the drop records of the segments are
+      //   already gone from the event index and would be lost otherwise.
+      //   While the database is down the segments wait (the queue is bounded),
+      //   else they are tried maxTries times
+
+      uint64_t now = cTimeMs::Now();
+      int down = !dbConnected();
+      int givenUp = 0;                   // dropped after maxTries
+      std::vector<cEpgSegment*> retry;
+
+      for (size_t i = 0; i < batch.size(); i++)
+      {
+         cEpgSegment* s = batch[i];
+
+         if (failed[i] == wsWritten)
+         {
+            segments++;
+            events += s->records.size();
+            lagTotal += now - s->queuedAt;
+            lagMax = std::max(lagMax, now - s->queuedAt);
+         }
+         else if (down || failed[i] == wsDeferred || ++s->tries < maxTries)
+         {
+            retry.push_back(s);
+            continue;
+         }
+         else
+         {
+            lost++;
+            givenUp++;
+            s->revertIndex();
+         }
+
+         delete s;
+      }
+
+      if (retry.size() || givenUp)
+         tell(0, "Handler: Writer failed, %d segments queued again, %d dropped", (int)retry.size(), givenUp);
+
+      batch.clear();
+
+      mutex.Lock();
+
+      for (auto it = retry.rbegin(); it != retry.rend(); ++it)
+         queue.push_front(*it);
+
+      inWork = 0;
+      condition.Broadcast();
+      mutex.Unlock();
+
+      if (Epg2VdrConfig.loglevel > 1 && time(0) > statAt + 5*tmeSecondsPerMinute)
+      {
+         showStat();
+         statAt = time(0);
+      }
+   }
+}
+
+//***************************************************************************
+// Write Transaction
+//  - the counters of the transaction are added to the statistic on commit
+//***************************************************************************
+
+int cEpgWriter::writeTransaction(const std::vector<cEpgSegment*>& list)
+{
+   int status = success;
+
+   txCounts = Counts {};
+   connection->startTransaction();
+
+   for (auto s : list)
+   {
+      if ((status = write(s)) != success)
+         break;
+   }
+
+   if (status == success)
+      status = compWriter->flush();
+
+   compWriter->clear();
+   compEventIds.clear();
+
+   if (status == success)
+      status = connection->commit();
+   else
+      connection->rollback();
+
+   if (status != success)
+      return fail;
+
+   counts.versionOnly += txCounts.versionOnly;
+   counts.versionMissed += txCounts.versionMissed;
+   counts.compSkipped += txCounts.compSkipped;
+   counts.compWritten += txCounts.compWritten;
+   transactions++;
+
+   return success;
+}
+
+//***************************************************************************
+// Init / Exit Database
+//***************************************************************************
+
+int cEpgWriter::initDb()
+{
+   int status = success;
+
+   exitDb();
+
+   connection = new cDbConnection(dbName.empty() ? 0 : dbName.c_str());
+
+   mapDb = new cDbTable(connection, "channelmap");
+   if (mapDb->open() != success) return fail;
+
+   eventsDb = new cDbTable(connection, "events");
+   if (eventsDb->open() != success) return fail;
+
+   compDb = new cDbTable(connection, "components");
+   if (compDb->open() != success) return fail;
+
+   // select
+   //   * from events
+   // where
+   //   source = 'vdr'
+   //   and starttime = ?
+   //   and channelid = ?
+
+   selectEventByStarttime = new cDbStatement(eventsDb);
+
+   selectEventByStarttime->build("select ");
+   selectEventByStarttime->bindAllOut(0, cDBS::ftAll);
+   selectEventByStarttime->build(" from %s where source = 'vdr'", eventsDb->TableName());
+   selectEventByStarttime->bind("STARTTIME", cDBS::bndIn | cDBS::bndSet, " and ");
+   selectEventByStarttime->bind("CHANNELID", cDBS::bndIn | cDBS::bndSet, " and ");
+
+   status += selectEventByStarttime->prepare();
+
+   // update events set version = ?, tableid = ?, updsp = ?
+   //   where source = 'vdr' and starttime = ? and channelid = ? and delflg is null
+
+   updateVersion = new cDbStatement(eventsDb);
+
+   updateVersion->build("update %s set ", eventsDb->TableName());
+   updateVersion->bind("VERSION", cDBS::bndIn | cDBS::bndSet);
+   updateVersion->bind("TABLEID", cDBS::bndIn | cDBS::bndSet, ", ");
+   updateVersion->bind("UPDSP", cDBS::bndIn | cDBS::bndSet, ", ");
+   updateVersion->build(" where source = 'vdr'");
+   updateVersion->bind("STARTTIME", cDBS::bndIn | cDBS::bndSet, " and ");
+   updateVersion->bind("CHANNELID", cDBS::bndIn | cDBS::bndSet, " and ");
+   updateVersion->build(" and delflg is null");
+
+   status += updateVersion->prepare();
+
+   // update events set delflg = ?, updsp = ?
+   //   where channelid = ? and source = ?
+   //      and starttime+duration > ?
+   //      and starttime < ?
+   //      and (tableid > ? or (tableid = ? and version <> ?))
+
+   endTime = new cDbValue("starttime+duration", cDBS::ffInt, 10);
+   updateDelFlg = new cDbStatement(eventsDb);
+
+   updateDelFlg->build("update %s set ", eventsDb->TableName());
+   updateDelFlg->bind("DelFlg", cDBS::bndIn | cDBS::bndSet);
+   updateDelFlg->bind("UpdFlg", cDBS::bndIn | cDBS::bndSet, ", ");
+   updateDelFlg->bind("UpdSp", cDBS::bndIn | cDBS::bndSet, ", ");
+   updateDelFlg->build(" where ");
+   updateDelFlg->bind("ChannelId", cDBS::bndIn | cDBS::bndSet);
+   updateDelFlg->bind("Source", cDBS::bndIn | cDBS::bndSet, " and ");
+   updateDelFlg->bindCmp(0, endTime, ">" , " and ");
+   updateDelFlg->bindCmp(0, "StartTime", 0, "<" ,  " and ");
+   updateDelFlg->bindCmp(0, "TableId",   0, ">" ,  " and (");
+   updateDelFlg->bindCmp(0, "TableId",   0, "=" ,  " or (");
+   updateDelFlg->bindCmp(0, "Version",   0, "<>" , " and ");
+   updateDelFlg->build("));");
+
+   status += updateDelFlg->prepare();
+
+   // delete from components where eventid = ?;
+
+   delCompOf = new cDbStatement(compDb);
+
+   delCompOf->build("delete from %s where ", compDb->TableName());
+   delCompOf->bind("EventId", cDBS::bndIn | cDBS::bndSet);
+   delCompOf->build(";");
+
+   status += delCompOf->prepare();
+
+   // components are written in batches, flushed before each commit
+
+   compWriter = new cDbBatchWriter(compDb, 200);
+
+   return status;
+}
+
+int cEpgWriter::exitDb()
+{
+   if (connection)
+   {
+      delete endTime;                  endTime = 0;
+      delete updateDelFlg;             updateDelFlg = 0;
+      delete delCompOf;                delCompOf = 0;
+      delete compWriter;               compWriter = 0;
+      delete selectEventByStarttime;   selectEventByStarttime = 0;
+      delete updateVersion;            updateVersion = 0;
+
+      delete eventsDb;                 eventsDb = 0;
+      delete compDb;                   compDb = 0;
+      delete mapDb;                    mapDb = 0;
+
+      delete connection;               connection = 0;
+   }
+
+   compEventIds.clear();
+
+   return done;
+}
+
+//***************************************************************************
+// Find Merge Stamp
+//  - of the first external (non 'vdr') channelmap entry of the channel,
+//    looked up in memory (channelmap is held in memory)
+//***************************************************************************
+
+int cEpgWriter::findMergeSp(const char* channelId, time_t& mergesp)
+{
+   int found = no;
+
+   mapDb->clear();
+   mapDb->setValue("CHANNELID", channelId);
+
+   for (int f = mapDb->findBy("CHANNELID"); f; f = mapDb->fetchBy())
+   {
+      if (strcasecmp(mapDb->getStrValue("SOURCE"), "vdr") != 0)
+      {
+         mergesp = mapDb->getIntValue("MERGESP");
+         found = yes;
+         break;
+      }
+   }
+
+   mapDb->resetBy();
+
+   return found;
+}
+
+//***************************************************************************
+// Write Segment
+//***************************************************************************
+
+int cEpgWriter::write(cEpgSegment* segment)
+{
+   for (const auto& r : segment->records)
+   {
+      int status;
+
+      if (r.type == cEpgRecord::rtDrop)
+         status = dropOutdated(segment, &r);
+      else if (r.type == cEpgRecord::rtVersion)
+         status = writeVersion(segment, &r);
+      else
+         status = writeEvent(segment, &r);
+
+      if (status != success)
+         return status;
+   }
+
+   return success;
+}
+
+//***************************************************************************
+// Write Version
+//  - the content of the event is unchanged (same content hash), update only
+//    version and table id. If the row isn't found (anymore) the event is
+//    written completely
+//***************************************************************************
+
+int cEpgWriter::writeVersion(cEpgSegment* segment, const cEpgRecord* r)
+{
+   eventsDb->clear();
+   eventsDb->setValue("VERSION", r->version);
+   eventsDb->setValue("TABLEID", r->tableId);
+   eventsDb->setValue("UPDSP", time(0));
+   eventsDb->setValue("STARTTIME", r->startTime);
+   eventsDb->setValue("CHANNELID", segment->channelId.c_str());
+
+   if (updateVersion->execute() != success)
+      return fail;
+
+   if (updateVersion->getAffected() > 0)
+   {
+      txCounts.versionOnly++;
+      return success;
+   }
+
+   txCounts.versionMissed++;
+
+   return writeEvent(segment, r);
+}
+
+//***************************************************************************
+// Write Event
+//***************************************************************************
+
+int cEpgWriter::writeEvent(cEpgSegment* segment, const cEpgRecord* r)
+{
+   const char* channelId = segment->channelId.c_str();
+   int oldStartTime = 0;
+   std::string comp;
+
+   // lookup the event ..
+   //   first try by starttime
+
+   eventsDb->clear();
+   eventsDb->setValue("CHANNELID", channelId);
+   eventsDb->setValue("STARTTIME", r->startTime);
+
+   int insert = !selectEventByStarttime->find();
+
+   if (insert)
+   {
+      // try lookup by eventid
+
+      eventsDb->setValue("CHANNELID", channelId);
+      eventsDb->setBigintValue("EVENTID", (long)r->eventId);
+
+      if (eventsDb->find())
+      {
+         // fount => NOT a insert, just a update of the starttime
+
+         insert = no;
+         oldStartTime = eventsDb->getIntValue("STARTTIME");
+         eventsDb->setValue("STARTTIME", r->startTime);
+      }
+   }
+
+   // reinstate ??
+
+   int reinstated = eventsDb->hasValue("DELFLG", "Y");
+
+   if (reinstated)
+   {
+      char updFlg = Us::usPassthrough;
+
+      time_t mergesp;
+
+      if (findMergeSp(channelId, mergesp))
+      {
+         long masterid = eventsDb->getIntValue("MASTERID");
+         long useid = eventsDb->getIntValue("USEID");
+
+         if (r->startTime > mergesp)
+            updFlg = Us::usRemove;
+         else if (r->startTime <= mergesp && masterid == useid)
+            updFlg = Us::usActive;
+         else if (r->startTime <= mergesp && masterid != useid)
+            updFlg = Us::usLink;
+      }
+
+      eventsDb->setCharValue("UPDFLG", updFlg);
+      eventsDb->getValue("DELFLG")->setNull();
+   }
+
+   if (!insert && std::abs(r->startTime - eventsDb->getIntValue("StartTime")) > 6*tmeSecondsPerHour)
+   {
+      tell(3, "Handler: Info: Start time of %d/%s - '%s' moved %ld hours from %s to %s - '%s'",
+           r->eventId, channelId,
+           eventsDb->getStrValue("Title"),
+           (r->startTime - eventsDb->getIntValue("StartTime")) / tmeSecondsPerHour,
+           l2pTime(eventsDb->getIntValue("StartTime")).c_str(),
+           l2pTime(r->startTime).c_str(),
+           r->title.c_str());
+   }
+
+   time_t end = r->startTime + r->duration;
+
+   if (!insert
+       && end < time(0) - 2*tmeSecondsPerHour
+       && eventsDb->getIntValue("StartTime") >  time(0)
+       && r->startTime < eventsDb->getIntValue("StartTime"))
+   {
+      tell(1, "Handler: Info: Got update of %d/%s with startime more than 2h in past "
+           "(%s/%d) before (%s), ignoring update, set delflg instead",
+           r->eventId, channelId,
+           l2pTime(r->startTime).c_str(), r->duration,
+           l2pTime(eventsDb->getIntValue("StartTime")).c_str());
+
+      eventsDb->setValue("DelFlg", "Y");
+      eventsDb->setCharValue("UpdFlg", Us::usDelete);
+   }
+   else
+   {
+      eventsDb->setValue("StartTime", r->startTime);
+   }
+
+   if (!insert && eventsDb->getIntValue("VPS") != r->vps)
+      tell(1, "Handler: Toggle vps flag for '%s' at '%s' from %s to %s",
+           r->title.c_str(), channelId,
+           l2pTime(eventsDb->getIntValue("VPS")).c_str(), l2pTime(r->vps).c_str());
+
+   eventsDb->setValue("Source", "vdr");
+   eventsDb->setValue("TableId", r->tableId);
+   eventsDb->setValue("Version", r->version);
+
+   if (r->hasTitle)
+      eventsDb->setValue("Title", r->title.c_str());
+
+   if (r->hasDescription)
+      eventsDb->setValue("LongDescription", r->description.c_str());
+
+   eventsDb->setValue("Duration", r->duration);
+   eventsDb->setValue("ParentalRating", r->parentalRating);
+   eventsDb->setValue("Vps", r->vps);
+
+   if (!r->shortText.empty())
+      eventsDb->setValue("ShortText", r->shortText.c_str());
+
+   if (!r->contents.empty())
+      eventsDb->setValue("CONTENTS", r->contents.c_str());
+
+   // components ..
+   //   unchanged since the last write -> nothing to do, except the row is
+   //   new or reinstated (the components may be gone with the event)
+
+   if (r->componentsUnchanged && !insert && !reinstated)
+   {
+      txCounts.compSkipped++;
+   }
+   else
+   {
+      // write pending components of this event before deleting them
+
+      if (!compEventIds.insert(eventsDb->getBigintValue("EVENTID")).second && compWriter->flush() != success)
+         return fail;
+
+      compDb->clear();
+      compDb->setBigintValue("EVENTID", eventsDb->getBigintValue("EVENTID"));
+      delCompOf->execute();
+
+      for (const auto& c : r->components)
+      {
+         compDb->clear();
+         compDb->setBigintValue("EventId", eventsDb->getBigintValue("EVENTID"));
+         compDb->setValue("ChannelId", channelId);
+         compDb->setValue("Stream", c.stream);
+         compDb->setValue("Type", c.type);
+         compDb->setValue("Lang", c.lang.c_str());
+         compDb->setValue("Description", c.description.c_str());
+         if (compWriter->append() != success)
+            return fail;
+      }
+
+      txCounts.compWritten++;
+   }
+
+   // compressed ..
+
+   if (r->hasTitle)
+   {
+      comp = r->title;
+      prepareCompressed(comp);
+      eventsDb->setValue("COMPTITLE", comp.c_str());
+   }
+
+   if (!r->shortText.empty())
+   {
+      comp = r->shortText;
+      prepareCompressed(comp);
+      eventsDb->setValue("COMPSHORTTEXT", comp.c_str());
+   }
+
+   if (!r->description.empty())
+   {
+      comp = r->description;
+      prepareCompressed(comp);
+      eventsDb->setValue("COMPLONGDESCRIPTION", comp.c_str());
+   }
+
+   int status;
+
+   if (insert)
+   {
+      eventsDb->setValue("UseId", 0L);
+      eventsDb->setCharValue("UpdFlg", Us::usPassthrough); // default (vdr:000 events)
+
+      time_t mergesp;
+
+      if (findMergeSp(channelId, mergesp))
+      {
+         // vdr event for merge with external event
+
+         eventsDb->setCharValue("UpdFlg", r->startTime > mergesp ? Us::usInactive : Us::usActive);
+      }
+
+      status = eventsDb->insert();
+   }
+   else
+   {
+      status = eventsDb->update();
+   }
+
+   selectEventByStarttime->freeResult();
+
+   // the event moved, forget the old start time
+
+   if (!insert && oldStartTime && segment->index)
+   {
+      segment->index->removeLater(segment->channel, oldStartTime);
+      tell(4, "Handler: cRemove: '%ld:%s'  (due to starttime update)", (long)oldStartTime, channelId);
+   }
+
+   return status == success && dbConnected() ? success : fail;
+}
+
+//***************************************************************************
+// Drop Outdated
+//***************************************************************************
+
+int cEpgWriter::dropOutdated(cEpgSegment* segment, const cEpgRecord* r)
+{
+   eventsDb->clear();
+   eventsDb->setValue("ChannelId", segment->channelId.c_str());
+   eventsDb->setValue("Source", "vdr");
+   eventsDb->setValue("UpdSp", time(0));
+   eventsDb->setValue("StartTime", r->endTime);
+   eventsDb->setValue("TableId", r->tableId);
+   eventsDb->setValue("Version", r->version);
+   endTime->setValue(r->startTime);
+   eventsDb->setValue("DELFLG", "Y");
+   eventsDb->setCharValue("UPDFLG", Us::usDelete);
+
+   // mark segment as deleted, the handler already removed
+   //   the events from the event index (cEventIndex::dropSegment())
+
+   return updateDelFlg->execute();
+}
+
+//***************************************************************************
+// Show Statistic
+//***************************************************************************
+
+void cEpgWriter::showStat()
+{
+   cMutexLock lock(&mutex);
+
+   tell(1, "Handler: Writer queue %d/%d (max %zu), %ld segments with %ld records in %ld transactions, "
+        "%ld dropped (queue full), %ld lost (write failed), lag %.1f ms avg, %lu ms max",
+        (int)queue.size(), maxQueued, maxDepth, segments, events, transactions,
+        dropped, lost, segments ? (double)lagTotal / segments : 0.0, (unsigned long)lagMax);
+   tell(1, "Handler: Writer updated %ld events by version only (%ld not found, written completely)",
+        counts.versionOnly, counts.versionMissed);
+   tell(1, "Handler: Writer components of %ld events written, of %ld events unchanged",
+        counts.compWritten, counts.compSkipped);
+}
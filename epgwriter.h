@@ -0,0 +1,179 @@
+/*
+ * epgwriter.h: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#pragma once
+
+#include <deque>
+#include <set>
+
+#include <vdr/thread.h>
+
+#include "lib/db.h"
+
+#include "evtindex.h"
+
+//***************************************************************************
+// EPG Record
+//  - compact copy of a DVB event (or a drop request) of the EIT handler
+//***************************************************************************
+
+struct cEpgRecord
+{
+   enum Type
+   {
+      rtEvent,
+      rtVersion,                   // content unchanged, only version and table id
+      rtDrop
+   };
+
+   struct Component
+   {
+      uint8_t stream;
+      uint8_t type;
+      std::string lang;
+      std::string description;
+   };
+
+   int type {rtEvent};
+
+   uint32_t eventId {0};
+   time_t startTime {0};           // the segment start for rtDrop
+   time_t endTime {0};             // the segment end for rtDrop
+   int duration {0};
+   uint8_t tableId {0};
+   uint8_t version {0};
+   int parentalRating {0};
+   time_t vps {0};
+   std::string title;
+   std::string shortText;
+   std::string description;
+   int hasTitle {no};              // absent (NULL) title and description keep the
+   int hasDescription {no};        //   value of the row, empty ones overwrite it
+   std::string contents;
+   std::vector<Component> components;
+   int componentsUnchanged {no};   // same components as written before
+
+   uint64_t contentHash() const;
+   uint32_t componentsHash() const;
+};
+
+//***************************************************************************
+// EPG Segment
+//  - the records of one segment transfer, written in one transaction
+//***************************************************************************
+
+struct cEpgSegment
+{
+   std::string channelId;
+   cEventIndex* index {};          // event index of the handler
+   int channel {0};                //   and the channel there
+   uint64_t queuedAt {0};          // ms
+   int tries {0};                  // failed writes
+   std::vector<cEpgRecord> records;
+
+   void revertIndex();             // forget the events, to handle them again on next transfer
+};
+
+//***************************************************************************
+// EPG Writer
+//  - write behind of the DVB events, the EIT thread only queues the
+//    segments, the writer thread drains the queue in batched transactions
+//  - the segments are written in the order they are queued, so the
+//    order of the updates of each channel is kept
+//  - if the queue is full, or a write failed maxTries times, the segment
+//    is dropped and it's events removed from the event index, so they will
+//    be handled again when the next EIT data arrives. While the database is
+//    down the segments stay queued
+//***************************************************************************
+
+class cEpgWriter : public cThread
+{
+   public:
+
+      cEpgWriter();
+      virtual ~cEpgWriter();
+
+      int start();
+      void stop();
+
+      int enqueue(cEpgSegment* segment);    // takes ownership on success
+      int waitIdle(int timeoutMs);          // until the queued segments are written
+      void setDatabase(const char* name)    { dbName = name; }   // before start()
+      void showStat();
+
+      static int maxQueued;                 // segments
+      static int maxBatch;                  // segments per transaction
+      static int maxTries;                  // writes of a segment before it's dropped
+
+   protected:
+
+      void Action();
+
+      int initDb();
+      int exitDb();
+      int dbConnected() { return connection && connection->isConnected(); }
+
+      int writeTransaction(const std::vector<cEpgSegment*>& list);
+      int write(cEpgSegment* segment);
+      int writeEvent(cEpgSegment* segment, const cEpgRecord* r);
+      int writeVersion(cEpgSegment* segment, const cEpgRecord* r);
+      int dropOutdated(cEpgSegment* segment, const cEpgRecord* r);
+      int findMergeSp(const char* channelId, time_t& mergesp);
+
+   private:
+
+      enum WriteState
+      {
+         wsWritten,
+         wsFailed,
+         wsDeferred                         // not tried, a earlier segment of the channel failed
+      };
+
+      struct Counts
+      {
+         long versionOnly {0};              // events with only version/tableid updated
+         long versionMissed {0};            //   of them written completely (row not found)
+         long compSkipped {0};              // events with unchanged components
+         long compWritten {0};
+      };
+
+      int loopActive {no};
+      std::deque<cEpgSegment*> queue;
+      int inWork {0};                      // segments of the current batch
+      cMutex mutex;
+      cCondVar condition;
+      time_t reconnectAt {0};              // back off while the database is down
+      int reconnectDelay {0};              // seconds
+
+      std::string dbName;                  // empty for the configured database
+      cDbConnection* connection {};
+      cDbTable* eventsDb {};
+      cDbTable* mapDb {};
+      cDbTable* compDb {};
+
+      cDbValue* endTime {};
+      cDbStatement* updateDelFlg {};
+      cDbStatement* delCompOf {};
+      cDbStatement* selectEventByStarttime {};
+      cDbStatement* updateVersion {};
+      cDbBatchWriter* compWriter {};
+      std::set<int64_t> compEventIds;      // events with batched components of this transaction
+
+      // statistic
+
+      size_t maxDepth {0};
+      long segments {0};                   // written
+      long events {0};
+      Counts counts;                       // of the committed transactions
+      Counts txCounts;                     // of the current transaction
+      long transactions {0};
+      long dropped {0};                    // queue full
+      long lost {0};                       // write failed
+      uint64_t lagTotal {0};               // ms from queue to commit
+      uint64_t lagMax {0};
+      time_t statAt {0};
+};
@@ -0,0 +1,576 @@
+/*
+ * evtindex.c: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include <fcntl.h>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lib/common.h"
+
+#include "evtindex.h"
+
+static const char* fileMagic = "EPGEIDX";
+
+//***************************************************************************
+// Event Index
+//***************************************************************************
+
+cEventIndex::cEventIndex()
+{
+   resize(minCapacity);
+}
+
+//***************************************************************************
+// Channel Of
+//***************************************************************************
+
+int cEventIndex::channelOf(const char* channelId)
+{
+   auto it = channels.find(channelId);
+
+   if (it != channels.end())
+      return it->second;
+
+   if (channelNames.size() + 1 >= chRemoved)
+   {
+      tell(0, "Handler: Error, too many channels for the event index, ignoring '%s'", channelId);
+      return chEmpty;
+   }
+
+   channelNames.push_back(channelId);
+   channels[channelId] = channelNames.size();
+   timelines.emplace_back();
+
+   return channelNames.size();
+}
+
+const char* cEventIndex::channelName(int channel)
+{
+   if (channel <= 0 || channel > (int)channelNames.size())
+      return "";
+
+   return channelNames[channel-1].c_str();
+}
+
+//***************************************************************************
+// Slot Of
+//  - the slot of the entry, or the slot to insert it if not found
+//***************************************************************************
+
+size_t cEventIndex::slotOf(int channel, time_t start)
+{
+   uint64_t h = (uint64_t)channel << 32 | (uint32_t)start;
+   size_t free = (size_t)-1;
+
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+
+   for (size_t i = h & mask; ; i = (i + 1) & mask)
+   {
+      const Entry& e = entries[i];
+
+      probes++;
+
+      if (e.channel == chEmpty)
+         return free != (size_t)-1 ? free : i;
+
+      if (e.channel == chRemoved)
+      {
+         if (free == (size_t)-1)
+            free = i;
+      }
+      else if (e.channel == channel && e.start == (uint32_t)start)
+      {
+         return i;
+      }
+   }
+}
+
+//***************************************************************************
+// Find / Put / Remove
+//***************************************************************************
+
+const cEventIndex::Entry* cEventIndex::find(int channel, time_t start)
+{
+   lookups++;
+   accesses++;
+
+   if (channel == chEmpty)
+      return 0;
+
+   const Entry* e = &entries[slotOf(channel, start)];
+
+   if (e->channel != channel)
+      return 0;
+
+   hits++;
+
+   return e;
+}
+
+void cEventIndex::put(int channel, time_t start, int duration, uint8_t tableid, uint8_t version,
+                      uint64_t hash, uint32_t compHash)
+{
+   accesses++;
+
+   if (channel == chEmpty)
+      return;
+
+   // keep at least a quarter of the slots empty, grow or only drop the tombstones
+
+   if ((count + removed + 1) * 4 > entries.size() * 3)
+      resize((count + 1) * 2 > entries.size() ? entries.size() * 2 : entries.size());
+
+   Entry* e = &entries[slotOf(channel, start)];
+   Timeline& timeline = timelines[channel-1];
+   Span span { (uint32_t)start, (uint32_t)(start + std::max(duration, 0)) };
+
+   if (e->channel != channel)
+   {
+      if (e->channel == chRemoved)
+         removed--;
+
+      count++;
+      e->channel = channel;
+      e->start = (uint32_t)start;
+
+      timeline.spans.insert(std::lower_bound(timeline.spans.begin(), timeline.spans.end(), span,
+                                             [](const Span& a, const Span& b) { return a.start < b.start; }),
+                            span);
+   }
+   else
+   {
+      spanOf(channel, span.start)->end = span.end;
+   }
+
+   timeline.maxDuration = std::max(timeline.maxDuration, span.end - span.start);
+
+   e->tableid = tableid;
+   e->version = version;
+   e->hash = hash;
+   e->compHash = compHash;
+}
+
+int cEventIndex::remove(int channel, time_t start)
+{
+   accesses++;
+
+   if (channel == chEmpty)
+      return no;
+
+   Entry* e = &entries[slotOf(channel, start)];
+
+   if (e->channel != channel)
+      return no;
+
+   timelines[channel-1].spans.erase(spanOf(channel, (uint32_t)start));
+   removeSlot(e);
+
+   return yes;
+}
+
+void cEventIndex::removeSlot(Entry* e)
+{
+   e->channel = chRemoved;
+   count--;
+   removed++;
+}
+
+std::vector<cEventIndex::Span>::iterator cEventIndex::spanOf(int channel, uint32_t start)
+{
+   std::vector<Span>& spans = timelines[channel-1].spans;
+
+   return std::lower_bound(spans.begin(), spans.end(), start,
+                           [](const Span& s, uint32_t t) { return s.start < t; });
+}
+
+void cEventIndex::clear()
+{
+   entries.assign(minCapacity, Entry {});
+   mask = minCapacity - 1;
+   count = 0;
+   removed = 0;
+
+   for (auto& timeline : timelines)
+      timeline = Timeline {};
+}
+
+//***************************************************************************
+// Drop Segment
+//  - remove the events of the segment with other table id or version, like
+//    the handler marks them as deleted in the database
+//***************************************************************************
+
+int cEventIndex::dropSegment(int channel, time_t segmentStart, time_t segmentEnd,
+                             uint8_t tableid, uint8_t version)
+{
+   int n = 0;
+
+   if (channel == chEmpty)
+      return 0;
+
+   Timeline& timeline = timelines[channel-1];
+   uint32_t from = (uint32_t)segmentStart > timeline.maxDuration ? segmentStart - timeline.maxDuration : 0;
+
+   for (auto s = spanOf(channel, from); s != timeline.spans.end() && s->start < (uint32_t)segmentEnd; )
+   {
+      Entry* e = &entries[slotOf(channel, s->start)];
+
+      accesses++;
+
+      if (s->end > (uint32_t)segmentStart &&
+          (e->tableid > tableid || (e->tableid == tableid && e->version != version)))
+      {
+         removeSlot(e);
+         s = timeline.spans.erase(s);
+         n++;
+      }
+      else
+      {
+         ++s;
+      }
+   }
+
+   return n;
+}
+
+//***************************************************************************
+// Remove Ended Before
+//***************************************************************************
+
+int cEventIndex::removeEndedBefore(time_t time)
+{
+   int n = 0;
+
+   for (size_t c = 0; c < timelines.size(); c++)
+   {
+      std::vector<Span>& spans = timelines[c].spans;
+      size_t keep = 0;
+
+      for (size_t i = 0; i < spans.size(); i++)
+      {
+         if (spans[i].end < (uint32_t)time)
+         {
+            removeSlot(&entries[slotOf(c+1, spans[i].start)]);
+            n++;
+         }
+         else
+         {
+            spans[keep++] = spans[i];
+         }
+      }
+
+      spans.resize(keep);
+   }
+
+   return n;
+}
+
+//***************************************************************************
+// Save
+//***************************************************************************
+
+int cEventIndex::save(const char* file, time_t stamp, const char* origin)
+{
+   std::string tmp = std::string(file) + ".tmp";
+   std::string names;
+   FileHeader header {};
+   FILE* fp;
+
+   for (const auto& name : channelNames)
+      names.append(name.c_str(), name.length() + 1);
+
+   names.resize((names.size() + 7) & ~(size_t)7, '\0');
+
+   strcpy(header.magic, fileMagic);
+   header.version = fileVersion;
+   header.entrySize = sizeof(Entry);
+   header.stamp = stamp;
+   snprintf(header.origin, sizeof(header.origin), "%s", origin);
+   header.capacity = entries.size();
+   header.count = count;
+   header.removed = removed;
+   header.channelCount = channelNames.size();
+   header.namesSize = names.size();
+
+   if (!(fp = fopen(tmp.c_str(), "w")))
+   {
+      tell(1, "Handler: Info: Can't write event index '%s', error was '%s'", tmp.c_str(), strerror(errno));
+      return fail;
+   }
+
+   if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+       fwrite(names.data(), 1, names.size(), fp) != names.size() ||
+       fwrite(entries.data(), sizeof(Entry), entries.size(), fp) != entries.size() ||
+       !saveTimelines(fp))
+   {
+      tell(0, "Handler: Error writing event index '%s', error was '%s'", tmp.c_str(), strerror(errno));
+      fclose(fp);
+      unlink(tmp.c_str());
+      return fail;
+   }
+
+   fclose(fp);
+
+   if (rename(tmp.c_str(), file) != 0)
+   {
+      tell(0, "Handler: Error renaming event index to '%s', error was '%s'", file, strerror(errno));
+      unlink(tmp.c_str());
+      return fail;
+   }
+
+   tell(1, "Handler: Saved event index with %zu events to '%s'", count, file);
+
+   return success;
+}
+
+int cEventIndex::saveTimelines(FILE* fp)
+{
+   for (const auto& timeline : timelines)
+   {
+      uint32_t head[2] = { (uint32_t)timeline.spans.size(), timeline.maxDuration };
+
+      if (fwrite(head, sizeof(head), 1, fp) != 1 ||
+          fwrite(timeline.spans.data(), sizeof(Span), timeline.spans.size(), fp) != timeline.spans.size())
+         return no;
+   }
+
+   return yes;
+}
+
+//***************************************************************************
+// Load
+//  - the file is mapped, the slots are copied as they are (no rehash)
+//***************************************************************************
+
+int cEventIndex::load(const char* file, time_t& stamp, std::string& origin)
+{
+   struct stat sb;
+   int fd;
+
+   if (!channelNames.empty())
+      return fail;
+
+   if ((fd = open(file, O_RDONLY)) < 0)
+      return fail;
+
+   if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(FileHeader))
+   {
+      close(fd);
+      return fail;
+   }
+
+   void* data = mmap(0, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+
+   if (data == MAP_FAILED)
+      return fail;
+
+   const FileHeader* header = (const FileHeader*)data;
+   const char* names = (const char*)data + sizeof(FileHeader);
+   const Entry* slots = (const Entry*)(names + header->namesSize);
+
+   if (strncmp(header->magic, fileMagic, sizeof(header->magic)) != 0 ||
+       header->version != fileVersion || header->entrySize != sizeof(Entry) ||
+       header->capacity < minCapacity || (header->capacity & (header->capacity - 1)) ||
+       header->channelCount >= chRemoved || header->namesSize % 8 ||
+       header->count > header->capacity ||
+       (size_t)sb.st_size != sizeof(FileHeader) + header->namesSize + header->capacity * sizeof(Entry)
+       + header->channelCount * 2 * sizeof(uint32_t) + header->count * sizeof(Span))
+   {
+      tell(1, "Handler: Event index '%s' invalid or outdated, ignoring", file);
+      munmap(data, sb.st_size);
+      return fail;
+   }
+
+   // every used slot has to reference a known channel and the counters have
+   //   to match, otherwise put() and find() index the timelines out of range
+
+   size_t used = 0, tombstones = 0, invalid = 0;
+
+   for (uint64_t i = 0; i < header->capacity && !invalid; i++)
+   {
+      if (slots[i].channel == chRemoved)
+         tombstones++;
+      else if (slots[i].channel > header->channelCount)
+         invalid++;
+      else if (slots[i].channel != chEmpty)
+         used++;
+   }
+
+   if (invalid || used != header->count || tombstones != header->removed || used + tombstones >= header->capacity)
+   {
+      tell(1, "Handler: Event index '%s' has invalid slots, ignoring", file);
+      munmap(data, sb.st_size);
+      return fail;
+   }
+
+   const char* namesEnd = names + header->namesSize;
+
+   for (uint32_t i = 0; i < header->channelCount && names < namesEnd; i++)
+   {
+      size_t len = strnlen(names, namesEnd - names);
+
+      channelNames.push_back(std::string(names, len));
+      channels[channelNames.back()] = channelNames.size();
+      names += len + 1;
+   }
+
+   // the timelines
+
+   const uint32_t* p = (const uint32_t*)(slots + header->capacity);
+   const uint32_t* end = (const uint32_t*)((const char*)data + sb.st_size);
+
+   for (uint32_t i = 0; i < channelNames.size() && p + 2 <= end; i++)
+   {
+      Timeline timeline;
+      const Span* spans = (const Span*)(p + 2);
+
+      if ((const uint32_t*)(spans + p[0]) > end)
+         break;
+
+      timeline.spans.assign(spans, spans + p[0]);
+      timeline.maxDuration = p[1];
+      timelines.push_back(std::move(timeline));
+      p = (const uint32_t*)(spans + p[0]);
+   }
+
+   if (channelNames.size() != header->channelCount || timelines.size() != header->channelCount)
+   {
+      tell(1, "Handler: Event index '%s' invalid, ignoring", file);
+      channelNames.clear();
+      channels.clear();
+      timelines.clear();
+      munmap(data, sb.st_size);
+      return fail;
+   }
+
+   entries.assign(slots, slots + header->capacity);
+   mask = header->capacity - 1;
+   count = header->count;
+   removed = header->removed;
+
+   time_t fileStamp = header->stamp;
+   std::string fileOrigin(header->origin, strnlen(header->origin, sizeof(header->origin)));
+
+   munmap(data, sb.st_size);
+
+   // each span has to find it's slot, the spans of a channel are distinct
+   //   (sorted strictly) and as many as used slots, so each slot has it's span
+
+   for (size_t c = 0; c < timelines.size(); c++)
+   {
+      const std::vector<Span>& spans = timelines[c].spans;
+
+      for (size_t i = 0; i < spans.size(); i++)
+      {
+         if ((i && spans[i].start <= spans[i-1].start) || spans[i].end < spans[i].start ||
+             entries[slotOf(c+1, spans[i].start)].channel != c+1)
+         {
+            tell(1, "Handler: Event index '%s' has inconsistent timelines, ignoring", file);
+            channelNames.clear();
+            channels.clear();
+            timelines.clear();
+            clear();
+            return fail;
+         }
+      }
+   }
+
+   stamp = fileStamp;
+   origin = fileOrigin;
+
+   return success;
+}
+
+//***************************************************************************
+// Remove Later
+//***************************************************************************
+
+void cEventIndex::removeLater(int channel, time_t start)
+{
+   pendingMutex.Lock();
+   pending.push_back(std::make_pair(channel, start));
+   hasPending = true;
+   pendingMutex.Unlock();
+}
+
+int cEventIndex::applyPending()
+{
+   std::vector<std::pair<int,time_t>> removals;
+
+   if (!hasPending)
+      return 0;
+
+   pendingMutex.Lock();
+   removals.swap(pending);
+   hasPending = false;
+   pendingMutex.Unlock();
+
+   for (const auto& r : removals)
+      remove(r.first, r.second);
+
+   return removals.size();
+}
+
+//***************************************************************************
+// Resize
+//***************************************************************************
+
+void cEventIndex::resize(size_t newCapacity)
+{
+   std::vector<Entry> old(newCapacity, Entry {});
+   unsigned long accessProbes = probes;
+
+   old.swap(entries);
+   mask = newCapacity - 1;
+   count = 0;
+   removed = 0;
+
+   for (const Entry& e : old)
+   {
+      if (e.channel != chEmpty && e.channel != chRemoved)
+      {
+         entries[slotOf(e.channel, e.start)] = e;
+         count++;
+      }
+   }
+
+   probes = accessProbes;      // count only the probes of the accesses
+
+   if (!old.empty())
+      resizes++;
+}
+
+//***************************************************************************
+// Statistic
+//***************************************************************************
+
+size_t cEventIndex::memUsage()
+{
+   size_t bytes = entries.capacity() * sizeof(Entry);
+
+   for (const auto& name : channelNames)
+      bytes += 2 * (name.capacity() + sizeof(std::string)) + sizeof(uint16_t);
+
+   for (const auto& timeline : timelines)
+      bytes += sizeof(Timeline) + timeline.spans.capacity() * sizeof(Span);
+
+   return bytes;
+}
+
+void cEventIndex::showStat(const char* prefix)
+{
+   tell(1, "%s: Event index with %zu events of %zu channels, %zu slots (%zu removed), %zu kB; "
+        "%lu lookups, %.1f%% hits, %.2f probes/access, %lu resizes",
+        prefix, count, channelNames.size(), entries.size(), removed, memUsage() / 1024,
+        lookups, lookups ? hits * 100.0 / lookups : 0.0,
+        accesses ? (double)probes / accesses : 0.0, resizes);
+}
@@ -0,0 +1,139 @@
+/*
+ * evtindex.h: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+
+#include "lib/common.h"
+
+//***************************************************************************
+// Event Index
+//  - version, table id, content hash and components hash of the known DVB
+//    events by channel and start time
+//  - open addressing hash (linear probing) with 24 byte entries, the channels
+//    are interned to a 16 bit index once per channel
+//  - not thread safe, the handler serializes the access (indexMutex). The
+//    writer only queues removals by removeLater(), the handler applies
+//    them by applyPending()
+//  - additionally the time spans (start, end) of the events are kept sorted
+//    by start per channel (timeline), to find the events of a EIT segment
+//    and the ended events without a scan of the whole table
+//  - save() / load() persist the index to a file (header, channel names,
+//    the slots as they are and the timelines), to start without reading
+//    all events from the db. The header names the database (origin), the
+//    caller has to check it and the content against the db
+//***************************************************************************
+
+class cEventIndex
+{
+   public:
+
+      struct Entry
+      {
+         uint64_t hash;        // content hash, 0 -> unknown
+         uint32_t start;
+         uint32_t compHash;    // hash of the components written to the db, 0 -> unknown
+         uint16_t channel;     // 0 -> empty, 0xFFFF -> removed
+         uint8_t version;
+         uint8_t tableid;
+      };
+
+      cEventIndex();
+
+      int channelOf(const char* channelId);       // interned index of the channel, 0 on overflow
+      const char* channelName(int channel);
+
+      const Entry* find(int channel, time_t start);
+      void put(int channel, time_t start, int duration, uint8_t tableid, uint8_t version,
+               uint64_t hash = 0, uint32_t compHash = 0);
+      int remove(int channel, time_t start);
+      void clear();
+
+      int dropSegment(int channel, time_t segmentStart, time_t segmentEnd, uint8_t tableid, uint8_t version);
+      int removeEndedBefore(time_t time);
+
+      int save(const char* file, time_t stamp, const char* origin);
+      int load(const char* file, time_t& stamp, std::string& origin);   // only on a empty index (no channels)
+
+      void removeLater(int channel, time_t start);   // thread safe
+      int applyPending();
+
+      size_t size()      { return count; }
+      size_t memUsage();
+      void showStat(const char* prefix = "Handler");
+
+   private:
+
+      enum Misc
+      {
+         chEmpty = 0,
+         chRemoved = 0xFFFF,
+         minCapacity = 1024,
+         fileVersion = 4
+      };
+
+      struct Span
+      {
+         uint32_t start;
+         uint32_t end;
+      };
+
+      struct Timeline
+      {
+         std::vector<Span> spans;       // sorted by start
+         uint32_t maxDuration {0};      // to find the events which started before a segment
+      };
+
+      struct FileHeader
+      {
+         char magic[8];
+         uint32_t version;
+         uint32_t entrySize;
+         int64_t stamp;                 // max updsp of the events known by the index
+         char origin[128];              // the database the index was read from (host:port/name)
+         uint64_t capacity;
+         uint64_t count;
+         uint64_t removed;
+         uint32_t channelCount;
+         uint32_t namesSize;            // '\0' separated names, padded to 8 bytes
+      };
+
+      size_t slotOf(int channel, time_t start);
+      void resize(size_t newCapacity);
+      void removeSlot(Entry* e);
+      int saveTimelines(FILE* fp);
+      std::vector<Span>::iterator spanOf(int channel, uint32_t start);
+
+      std::vector<Entry> entries;
+      size_t mask {0};
+      size_t count {0};
+      size_t removed {0};         // slots marked as removed (tombstones)
+
+      std::unordered_map<std::string,uint16_t> channels;
+      std::vector<std::string> channelNames;
+      std::vector<Timeline> timelines;           // by channel - 1
+
+      cMyMutex pendingMutex;
+      std::vector<std::pair<int,time_t>> pending;
+      std::atomic<bool> hasPending {false};
+
+      // statistic
+
+      unsigned long lookups {0};
+      unsigned long hits {0};
+      unsigned long accesses {0};
+      unsigned long probes {0};
+      unsigned long resizes {0};
+};
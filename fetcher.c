@@ -0,0 +1,794 @@
+/*
+ * fetcher.c: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include "lib/epgservice.h"
+#include "lib/xml.h"
+
+#include "plgconfig.h"
+#include "dbfields.h"
+#include "fetcher.h"
+
+//***************************************************************************
+// EPG Sanitizer
+//***************************************************************************
+
+static void stripControlCharacters(char* s)
+{
+   if (s)
+   {
+      int len = strlen(s);
+
+      while (len > 0)
+      {
+         int l = Utf8CharLen(s);
+         uchar* p = (uchar*)s;
+
+         if (l == 2 && *p == 0xC2) // UTF-8 sequence
+            p++;
+
+         if (*p == 0x86 || *p == 0x87 || *p == 0x0D)
+         {
+            memmove(s, p + 1, len - l + 1); // we also copy the terminating 0!
+            len -= l;
+            l = 0;
+         }
+
+         s += l;
+         len -= l;
+      }
+   }
+}
+
+//***************************************************************************
+// Events AUX Fields - stored as XML in cEvent:aux
+//***************************************************************************
+
+const char* cEpgFetcher::auxFields[] =
+{
+// field name                type    max size
+
+   "imagecount",          // int
+   "scrseriesid",         // int
+   "scrseriesepisode",    // int
+   "scrmovieid",          // int
+   "numrating",           // int
+
+   "year",                // ascii     10
+   "category",            // ascii     50
+   "country",             // ascii     50
+   "audio",               // ascii     50
+
+   "txtrating",           // ascii    100
+   "genre",               // ascii    100
+   "flags",               // ascii    100
+   "commentator",         // ascii    200
+   "tipp",                // ascii    250
+   "rating",              // ascii    250
+   "moderator",           // ascii    250
+   "music",               // ascii    250
+   "screenplay",          // ascii    500
+   "shortreview",         // ascii    500
+
+   "guest",               // text    1000
+   "producer",            // text    1000
+   "camera",              // text    1000
+   "director",            // text    1000
+   "topic",               // ascii   1000
+
+   "other",               // text    2000
+   "shortdescription",    // mtext   3000
+   "shorttext",           // ascii    300
+   "actor",               // mtext   5000
+
+   "episodename",         // ascii    100
+   "episodeshortname",    // ascii    100
+   "episodepartname",     // ascii    300
+   "episodeextracol1",    // ascii    250
+   "episodeextracol2",    // ascii    250
+   "episodeextracol3",    // ascii    250
+   "episodeseason",       // int
+   "episodepart",         // int
+   "episodeparts",        // int
+   "episodenumber",       // int
+
+   0
+};
+
+//***************************************************************************
+// Init / Exit
+//***************************************************************************
+
+int cEpgFetcher::initDb(cDbConnection* aConnection)
+{
+   int status = success;
+
+   exitDb();
+
+   ownConnection = !aConnection;
+   connection = aConnection ? aConnection : new cDbConnection();
+
+   eventsDb = new cDbTable(connection, "events");
+   if (eventsDb->open() != success) return fail;
+
+   useeventsDb = new cDbTable(connection, "useevents");
+   if (useeventsDb->open() != success) return fail;
+
+   compDb = new cDbTable(connection, "components");
+   if (compDb->open() != success) return fail;
+
+   // -------------------------------------------
+   // init db values
+
+   viewDescription = new cDbValue("description", cDBS::ffText, 50000);
+   viewMergeSource = new cDbValue("mergesource", cDBS::ffAscii, 25);
+   viewLongDescription = new cDbValue("longdescription", cDBS::ffText, 50000);
+
+   // select changed events
+
+   selectUpdEvents = new cDbStatement(eventsDb);
+
+   // select useid, eventid, source, delflg, updflg, fileref,
+   //        tableid, version, title, shorttext, starttime,
+   //        duration, parentalrating, vps, description
+   //    from eventsview
+   //      where
+   //        channelid = ?
+   //        and updsp > ?
+   //        and updflg in (.....)
+
+   selectUpdEvents->build("select ");
+   selectUpdEvents->bind("USEID", cDBS::bndOut);
+   // selectUpdEvents->bind("MASTERID", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("EVENTID", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("SOURCE", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("DELFLG", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("UPDFLG", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("FILEREF", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("TABLEID", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("VERSION", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("TITLE", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("SHORTTEXT", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("STARTTIME", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("DURATION", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("PARENTALRATING", cDBS::bndOut, ", ");
+   selectUpdEvents->bind("VPS",  cDBS::bndOut, ", ");
+   selectUpdEvents->bind("CONTENTS",  cDBS::bndOut, ", ");
+   selectUpdEvents->bind(viewDescription, cDBS::bndOut, ", ");
+   selectUpdEvents->bind(viewMergeSource, cDBS::bndOut, ", ");
+   selectUpdEvents->bind(viewLongDescription, cDBS::bndOut, ", ");
+   selectUpdEvents->build(" from eventsview where ");
+   selectUpdEvents->bind("CHANNELID", cDBS::bndIn | cDBS::bndSet);
+   selectUpdEvents->bindCmp(0, "UPDSP", 0, ">", " and ");
+   selectUpdEvents->build(" and UPDFLG in (%s)", Us::getNeeded());
+
+   status += selectUpdEvents->prepare();
+
+   // select event by useid
+
+   selectEventById = new cDbStatement(useeventsDb);
+
+   // select * from eventsview
+   //      where useid = ?
+   //        and updflg in (.....)
+
+   selectEventById->build("select ");
+   selectEventById->bindAllOut();
+   selectEventById->build(" from %s where ", useeventsDb->TableName());
+   selectEventById->bind("USEID", cDBS::bndIn | cDBS::bndSet);
+   selectEventById->build(" and %s in (%s)",
+                          useeventsDb->getField("UPDFLG")->getDbName(),
+                          Us::getNeeded());
+
+   status += selectEventById->prepare();
+
+   // select stream, type, lang, description
+   //  from components where
+   // eventid = ?;
+   // channelid = ?;
+
+   selectComponentsOf = new cDbStatement(compDb);
+
+   selectComponentsOf->build("select ");
+   selectComponentsOf->bind("Stream", cDBS::bndOut);
+   selectComponentsOf->bind("Type", cDBS::bndOut, ", ");
+   selectComponentsOf->bind("Lang", cDBS::bndOut, ", ");
+   selectComponentsOf->bind("Description", cDBS::bndOut, ", ");
+   selectComponentsOf->build(" from %s where ", compDb->TableName());
+   selectComponentsOf->bind("EventId", cDBS::bndIn | cDBS::bndSet);
+   selectComponentsOf->bind("ChannelId", cDBS::bndIn | cDBS::bndSet, " and ");
+
+   status += selectComponentsOf->prepare();
+
+   // components of the changed 'vdr' events of a channel, events without
+   // components are delivered with null values (prefetch of refreshEpg)
+   //
+   // select e.eventid, c.stream, c.type, c.lang, c.description
+   //   from eventsview e
+   //     left join components c on (c.eventid = e.eventid and c.channelid = e.channelid)
+   //   where
+   //     e.channelid = ?
+   //     and e.updsp > ?
+   //     and e.source = 'vdr'
+   //     and e.updflg in (.....)
+
+   selectComponentsOfChannel = new cDbStatement(compDb);
+
+   selectComponentsOfChannel->build("select ");
+   selectComponentsOfChannel->setBindPrefix("e.");
+   selectComponentsOfChannel->bind("EventId", cDBS::bndOut);
+   selectComponentsOfChannel->setBindPrefix("c.");
+   selectComponentsOfChannel->bind("Stream", cDBS::bndOut, ", ");
+   selectComponentsOfChannel->bind("Type", cDBS::bndOut, ", ");
+   selectComponentsOfChannel->bind("Lang", cDBS::bndOut, ", ");
+   selectComponentsOfChannel->bind("Description", cDBS::bndOut, ", ");
+   selectComponentsOfChannel->clrBindPrefix();
+   selectComponentsOfChannel->build(" from eventsview e left join %s c on (c.%s = e.%s and c.%s = e.%s)",
+                                    compDb->TableName(),
+                                    compDb->getField("EventId")->getDbName(), eventsDb->getField("EventId")->getDbName(),
+                                    compDb->getField("ChannelId")->getDbName(), eventsDb->getField("ChannelId")->getDbName());
+   selectComponentsOfChannel->bindCmp("e", eventsDb->getValue("CHANNELID"), "=", " where ");
+   selectComponentsOfChannel->bindCmp("e", eventsDb->getValue("UPDSP"), ">", " and ");
+   selectComponentsOfChannel->build(" and e.%s = 'vdr' and e.%s in (%s)",
+                                    eventsDb->getField("SOURCE")->getDbName(),
+                                    eventsDb->getField("UPDFLG")->getDbName(),
+                                    Us::getNeeded());
+
+   status += selectComponentsOfChannel->prepare();
+
+   // aux fields of the changed events of a channel (prefetch of refreshEpg)
+   //
+   // select u.useid, u.imagecount, ...
+   //   from useevents u
+   //   where
+   //     u.channelid = ?
+   //     and u.updflg in (.....)
+   //     and u.useid in (select e.useid from eventsview e
+   //                       where e.channelid = ? and e.updsp > ? and e.updflg in (.....))
+
+   selectAuxOfChannel = new cDbStatement(useeventsDb);
+
+   selectAuxOfChannel->build("select ");
+   selectAuxOfChannel->setBindPrefix("u.");
+   selectAuxOfChannel->bind("USEID", cDBS::bndOut);
+
+   for (int i = 0; auxFields[i]; i++)
+   {
+      if (useeventsDb->getValue(auxFields[i]))
+         selectAuxOfChannel->bind(auxFields[i], cDBS::bndOut, ", ");
+   }
+
+   selectAuxOfChannel->clrBindPrefix();
+   selectAuxOfChannel->build(" from %s u where ", useeventsDb->TableName());
+   selectAuxOfChannel->bindCmp("u", useeventsDb->getField("CHANNELID"), eventsDb->getValue("CHANNELID"), "=");
+   selectAuxOfChannel->build(" and u.%s in (%s)", useeventsDb->getField("UPDFLG")->getDbName(), Us::getNeeded());
+   selectAuxOfChannel->build(" and u.%s in (select e.%s from eventsview e",
+                             useeventsDb->getField("USEID")->getDbName(),
+                             eventsDb->getField("USEID")->getDbName());
+   selectAuxOfChannel->bindCmp("e", eventsDb->getValue("CHANNELID"), "=", " where ");
+   selectAuxOfChannel->bindCmp("e", eventsDb->getValue("UPDSP"), ">", " and ");
+   selectAuxOfChannel->build(" and e.%s in (%s))", eventsDb->getField("UPDFLG")->getDbName(), Us::getNeeded());
+
+   status += selectAuxOfChannel->prepare();
+
+   return status;
+}
+
+int cEpgFetcher::exitDb()
+{
+   if (connection)
+   {
+      delete selectUpdEvents;           selectUpdEvents = 0;
+      delete selectEventById;           selectEventById = 0;
+      delete selectComponentsOf;        selectComponentsOf = 0;
+      delete selectComponentsOfChannel; selectComponentsOfChannel = 0;
+      delete selectAuxOfChannel;        selectAuxOfChannel = 0;
+
+      delete eventsDb;                  eventsDb = 0;
+      delete useeventsDb;               useeventsDb = 0;
+      delete compDb;                    compDb = 0;
+
+      delete viewDescription;           viewDescription = 0;
+      delete viewMergeSource;           viewMergeSource = 0;
+      delete viewLongDescription;       viewLongDescription = 0;
+
+      if (ownConnection)
+         delete connection;
+
+      connection = 0;
+   }
+
+   prefetchedComponents.clear();
+   prefetchedAux.clear();
+
+   return done;
+}
+
+//***************************************************************************
+// Stage Channel
+//  - fetch and build the events of the channel changed since 'since'
+//    without holding any vdr lock, refreshEpg() applies them later
+//  - removed events are staged without event
+//***************************************************************************
+
+int cEpgFetcher::stageChannel(const char* channelId, time_t since, std::vector<StagedEvent>& staged)
+{
+   int status = success;
+   int found;
+
+   eventsDb->clear();
+   eventsDb->setValue("UPDSP", since);
+   eventsDb->setValue("CHANNELID", channelId);
+
+   if (prefetchChannel() != success || (found = selectUpdEvents->find()) == fail)
+      found = fail;
+
+   for (; found == yes && isConnected(); found = selectUpdEvents->fetch())
+   {
+      char updFlg = toupper(eventsDb->getValueAt(dbf::events::fiUPDFLG)->getStrValue()[0]);
+
+      updFlg = updFlg == 0 ? 'P' : updFlg;               // fix missing flag
+
+      // ignore unneded event rows ..
+
+      if (!Us::isNeeded(updFlg))
+         continue;
+
+      StagedEvent st { (tEventID)eventsDb->getValueAt(dbf::events::fiUSEID)->getIntValue(), updFlg, 0 };
+
+      if (!Us::isRemove(updFlg))
+         st.event = createEventFromRow(eventsDb->getRow());
+
+      staged.push_back(st);
+   }
+
+   if (found == fail || !isConnected() || selectUpdEvents->fetchFailed())
+      status = fail;
+
+   selectUpdEvents->freeResult();
+
+   // a partial result isn't applied, drop it
+
+   if (status != success)
+   {
+      tell(0, "Error: Fetching the events of channel '%s' failed", channelId);
+
+      for (auto& st : staged)
+         delete st.event;
+
+      staged.clear();
+   }
+
+   return status;
+}
+
+//***************************************************************************
+// Prefetch Channel
+//  - components and aux values of the changed events of the channel
+//    (eventsDb CHANNELID, UPDSP) with one query each, createEventFromRow()
+//    falls back to the single event queries for events not prefetched
+//***************************************************************************
+
+int cEpgFetcher::prefetchChannel()
+{
+   int comps = 0;
+   int auxs = 0;
+
+   prefetchedComponents.clear();
+   prefetchedAux.clear();
+
+   int status = success;
+   int f;
+
+   for (f = selectComponentsOfChannel->find(); f == yes && isConnected(); f = selectComponentsOfChannel->fetch())
+   {
+      std::vector<Component>& components = prefetchedComponents[compDb->getValueAt(dbf::components::fiEVENTID)->getBigintValue()];
+
+      if (compDb->getValueAt(dbf::components::fiSTREAM)->isNull())
+         continue;                  // event without components
+
+      components.push_back({ (int)compDb->getValueAt(dbf::components::fiSTREAM)->getIntValue(),
+                             (int)compDb->getValueAt(dbf::components::fiTYPE)->getIntValue(),
+                             compDb->getValueAt(dbf::components::fiLANG)->getStrValue(),
+                             compDb->getValueAt(dbf::components::fiDESCRIPTION)->getStrValue() });
+      comps++;
+   }
+
+   if (f == fail || !isConnected() || selectComponentsOfChannel->fetchFailed())
+      status = fail;
+
+   selectComponentsOfChannel->freeResult();
+
+#if (defined (APIVERSNUM) && (APIVERSNUM >= 20304)) || (WITH_AUX_PATCH)
+
+   if (Epg2VdrConfig.extendedEpgData2Aux)
+   {
+      for (f = selectAuxOfChannel->find(); f == yes && isConnected(); f = selectAuxOfChannel->fetch())
+      {
+         getAuxValues(prefetchedAux[useeventsDb->getValueAt(dbf::useevents::fiUSEID)->getIntValue()]);
+         auxs++;
+      }
+
+      if (f == fail || !isConnected() || selectAuxOfChannel->fetchFailed())
+         status = fail;
+
+      selectAuxOfChannel->freeResult();
+   }
+
+#endif // WITH_AUX_PATCH
+
+   tell(3, "Prefetched %d components of %zu events and aux values of %d events for channel '%s'",
+        comps, prefetchedComponents.size(), auxs, eventsDb->getStrValue("CHANNELID"));
+
+   return status;
+}
+
+//***************************************************************************
+// Get Aux Values (of the current useeventsDb row)
+//***************************************************************************
+
+void cEpgFetcher::getAuxValues(std::vector<AuxValue>& values)
+{
+   values.clear();
+
+   for (int i = 0; auxFields[i]; i++)
+   {
+      cDbValue* value = useeventsDb->getValue(auxFields[i]);
+
+      if (!value || value->isEmpty())
+         continue;
+
+      if (value->getField()->hasFormat(cDBS::ffAscii) || value->getField()->hasFormat(cDBS::ffText) || value->getField()->hasFormat(cDBS::ffMText))
+         values.push_back({ i, yes, 0, value->getStrValue() });
+      else
+         values.push_back({ i, no, value->getIntValue(), "" });
+   }
+}
+
+//***************************************************************************
+// To/From Row
+//***************************************************************************
+
+cEvent* cEpgFetcher::createEventFromRow(const cDbRow* row)
+{
+   using namespace dbf::events;   // row of eventsDb
+
+   cEvent* e = new cEvent(row->getValueAt(fiUSEID)->getIntValue());
+
+   e->SetTableID(row->getValueAt(fiTABLEID)->getIntValue());
+   e->SetVersion(row->getValueAt(fiVERSION)->getIntValue());
+
+   // e->SetTitle(row->getStrValue("TITLE"));
+   char* title = strdup(row->getValueAt(fiTITLE)->getStrValue());
+   strreplace(title, '\n', ' ');
+   stripControlCharacters(title);
+   e->SetTitle(title);
+   free(title);
+
+   // e->SetShortText(row->getStrValue("SHORTTEXT"));
+   char* shortText = strdup(row->getValueAt(fiSHORTTEXT)->getStrValue());
+   strreplace(shortText, '\n', ' ');
+   stripControlCharacters(shortText);
+   e->SetShortText(shortText);
+   free(shortText);
+
+   e->SetStartTime(row->getValueAt(fiSTARTTIME)->getIntValue());
+   e->SetDuration(row->getValueAt(fiDURATION)->getIntValue());
+   e->SetParentalRating(row->getValueAt(fiPARENTALRATING)->getIntValue());
+   e->SetVps(row->getValueAt(fiVPS)->getIntValue());
+
+   // e->SetDescription(viewDescription->getStrValue());
+   char* description = strdup(viewDescription->getStrValue());
+   stripControlCharacters(description);
+   e->SetDescription(description);
+   free(description);
+
+   e->SetComponents(0);
+
+   // ------------
+   // contents
+
+   uchar contents[MaxEventContents] = { 0 };
+   int numContents = 0;
+
+   for (const char* p = row->getValueAt(fiCONTENTS)->getStrValue(); p && numContents < MaxEventContents; p = strchr(p, ','))
+   {
+      if (*p == ',') p++;
+
+      if (*p)
+         contents[numContents++] = strtol(p, 0, 0);
+   }
+
+   e->SetContents(contents);
+
+   // ------------
+   // components
+
+   if (row->getValueAt(fiSOURCE)->hasValue("vdr"))
+   {
+      cComponents* components = new cComponents;
+      auto it = prefetchedComponents.find(row->getValueAt(fiEVENTID)->getBigintValue());
+
+      if (it != prefetchedComponents.end())
+      {
+         for (const auto& c : it->second)
+            components->SetComponent(components->NumComponents(), c.stream, c.type,
+                                     c.lang.c_str(), c.description.c_str());
+      }
+      else
+      {
+         compDb->clear();
+         compDb->setBigintValue("EVENTID", row->getValueAt(fiEVENTID)->getBigintValue());
+         compDb->setValue("CHANNELID", row->getValueAt(fiCHANNELID)->getStrValue());
+
+         for (int f = selectComponentsOf->find(); f; f = selectComponentsOf->fetch())
+         {
+            components->SetComponent(components->NumComponents(),
+                                     compDb->getValueAt(dbf::components::fiSTREAM)->getIntValue(),
+                                     compDb->getValueAt(dbf::components::fiTYPE)->getIntValue(),
+                                     compDb->getValueAt(dbf::components::fiLANG)->getStrValue(),
+                                     compDb->getValueAt(dbf::components::fiDESCRIPTION)->getStrValue());
+         }
+
+         selectComponentsOf->freeResult();
+      }
+
+      if (components->NumComponents())
+         e->SetComponents(components);      // event take ownership of components!
+      else
+         delete components;
+   }
+
+#if (defined (APIVERSNUM) && (APIVERSNUM >= 20304)) || (WITH_AUX_PATCH)
+
+   // ------------
+   // aux
+
+   if (Epg2VdrConfig.extendedEpgData2Aux)
+   {
+      std::vector<AuxValue> fetched;
+      const std::vector<AuxValue>* values = 0;
+      auto it = prefetchedAux.find(row->getValueAt(fiUSEID)->getIntValue());
+
+      if (it != prefetchedAux.end())
+      {
+         values = &it->second;
+      }
+      else
+      {
+         useeventsDb->clear();
+         useeventsDb->setValue("USEID", row->getValueAt(fiUSEID)->getIntValue());
+
+         if (selectEventById->find())
+         {
+            getAuxValues(fetched);
+            values = &fetched;
+         }
+
+         selectEventById->freeResult();
+      }
+
+      if (values)
+      {
+         cXml xml;
+
+         xml.create("epg2vdr");
+
+         for (const auto& v : *values)
+         {
+            if (v.text)
+               xml.appendElement(auxFields[v.field], v.strValue.c_str());
+            else
+               xml.appendElement(auxFields[v.field], (int)v.intValue);
+         }
+
+         // finally add some fields of the view
+
+         xml.appendElement("source", viewMergeSource->getStrValue());
+         xml.appendElement("longdescription", viewLongDescription->getStrValue()); // the real original without view additions
+
+         // set to events aux field
+
+         e->SetAux(xml.toText());
+      }
+   }
+
+#endif // WITH_AUX_PATCH
+
+   return e;
+}
+
+
+//***************************************************************************
+// Epg Fetch Pool - Start / Stop
+//***************************************************************************
+
+int cEpgFetchPool::start(const std::vector<Job>& aJobs, time_t aSince)
+{
+   stop();
+
+   jobs = aJobs;
+   since = aSince;
+   jobIndex = 0;
+   consumed = 0;
+   loopActive = yes;
+   running = std::min(size, (int)jobs.size());
+
+   tell(1, "Starting %d fetch worker(s) for %zu channels", running, jobs.size());
+
+   for (int i = 0; i < running; i++)
+   {
+      workers.push_back(new cWorker(this));
+      workers.back()->Start();
+   }
+
+   return success;
+}
+
+void cEpgFetchPool::stop()
+{
+   mutex.Lock();
+   loopActive = no;
+   mutex.Unlock();
+
+   spaceCondition.Broadcast();           // wakeup the waiting workers
+
+   for (auto w : workers)
+   {
+      w->Cancel(10);
+      delete w;
+   }
+
+   workers.clear();
+
+   while (!results.empty())
+   {
+      for (auto& st : results.front()->staged)
+         delete st.event;
+
+      delete results.front();
+      results.pop_front();
+   }
+
+   running = 0;
+}
+
+//***************************************************************************
+// Next
+//  - waits for the next result, the staged events are owned by the caller
+//***************************************************************************
+
+int cEpgFetchPool::next(Result& result)
+{
+   cMutexLock lock(&mutex);
+
+   while (results.empty())
+   {
+      if (consumed >= jobs.size())
+         return done;
+
+      if (!running)
+      {
+         tell(0, "Error: All fetch workers finished, %zu channels left", jobs.size() - consumed);
+         return fail;
+      }
+
+      resultCondition.Wait(mutex);
+   }
+
+   Result* r = results.front();
+   results.pop_front();
+   consumed++;
+
+   result.job = r->job;
+   result.fetchMs = r->fetchMs;
+   result.status = r->status;
+   result.staged.swap(r->staged);
+   delete r;
+
+   spaceCondition.Broadcast();
+
+   return success;
+}
+
+//***************************************************************************
+// Remaining Jobs
+//  - the jobs not taken by a worker (after next() failed)
+//***************************************************************************
+
+int cEpgFetchPool::remainingJobs(std::vector<Job>& remaining)
+{
+   cMutexLock lock(&mutex);
+
+   remaining.clear();
+
+   while (jobIndex < jobs.size())
+      remaining.push_back(jobs[jobIndex++]);
+
+   consumed += remaining.size();
+
+   return remaining.size();
+}
+
+//***************************************************************************
+// Next Job / Push
+//***************************************************************************
+
+int cEpgFetchPool::nextJob()
+{
+   cMutexLock lock(&mutex);
+
+   if (!loopActive || jobIndex >= jobs.size())
+      return -1;
+
+   return jobIndex++;
+}
+
+int cEpgFetchPool::push(Result* result)
+{
+   cMutexLock lock(&mutex);
+
+   while (loopActive && results.size() >= (size_t)size * 2)
+      spaceCondition.Wait(mutex);
+
+   if (!loopActive)
+      return fail;
+
+   results.push_back(result);
+   resultCondition.Broadcast();
+
+   return success;
+}
+
+//***************************************************************************
+// Worker
+//***************************************************************************
+
+void cEpgFetchPool::cWorker::Action()
+{
+   cEpgFetcher fetcher;
+   int index;
+
+   if (fetcher.initDb() != success)
+      tell(0, "Error: Fetch worker can't prepare its database connection");
+   else
+   {
+      fetcher.setStreaming(yes);
+
+      while ((index = pool->nextJob()) >= 0)
+      {
+         Result* result = new Result;
+         uint64_t start = cTimeMs::Now();
+
+         result->job = pool->jobs[index];
+         result->status = fetcher.stageChannel(result->job.channelId.c_str(), pool->since, result->staged);
+         result->fetchMs = cTimeMs::Now() - start;
+
+         int status = result->status;       // the result is owned by the pool after push()
+
+         if (pool->push(result) != success)
+         {
+            for (auto& st : result->staged)
+               delete st.event;
+
+            delete result;
+            break;
+         }
+
+         // the connection of the worker is broken, leave the rest to the others
+
+         if (status != success)
+            break;
+      }
+   }
+
+   fetcher.exitDb();
+
+   pool->mutex.Lock();
+   pool->running--;
+   pool->resultCondition.Broadcast();
+   pool->mutex.Unlock();
+}
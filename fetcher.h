@@ -0,0 +1,166 @@
+/*
+ * fetcher.h: EPG2VDR plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+#include <vdr/thread.h>
+#include <vdr/epg.h>
+
+#include "lib/db.h"
+
+//***************************************************************************
+// Epg Fetcher
+//  - fetches and builds the changed events of a channel, without any vdr lock
+//  - the tables and statements work on the given connection, or on a own
+//    connection if none is given (fetch worker)
+//***************************************************************************
+
+class cEpgFetcher
+{
+   public:
+
+      // event of a channel, applied later to the schedule by cUpdate::refreshEpg()
+
+      struct StagedEvent
+      {
+         tEventID id;
+         char updFlg;
+         cEvent* event;            // 0 -> remove
+      };
+
+      cEpgFetcher() {}
+      ~cEpgFetcher() { exitDb(); }
+
+      int initDb(cDbConnection* aConnection = 0);
+      int exitDb();
+      int isConnected()  { return connection && connection->isConnected(); }
+
+      void setStreaming(int on)  { selectUpdEvents->setStreaming(on); }
+      int stageChannel(const char* channelId, time_t since, std::vector<StagedEvent>& staged);  // fail -> nothing staged
+
+      static const char* auxFields[];
+
+   private:
+
+      // components and aux values of the changed events of a channel, prefetched
+      // with one query each instead of one query per event
+
+      struct Component
+      {
+         int stream;
+         int type;
+         std::string lang;
+         std::string description;
+      };
+
+      struct AuxValue
+      {
+         int field;                // index in auxFields
+         int text;
+         long intValue;
+         std::string strValue;
+      };
+
+      int prefetchChannel();
+      void getAuxValues(std::vector<AuxValue>& values);
+      cEvent* createEventFromRow(const cDbRow* row);
+
+      cDbConnection* connection {};
+      int ownConnection {no};
+
+      cDbTable* eventsDb {};
+      cDbTable* useeventsDb {};
+      cDbTable* compDb {};
+
+      cDbStatement* selectUpdEvents {};
+      cDbStatement* selectEventById {};
+      cDbStatement* selectComponentsOf {};
+      cDbStatement* selectComponentsOfChannel {};
+      cDbStatement* selectAuxOfChannel {};
+
+      cDbValue* viewDescription {};
+      cDbValue* viewMergeSource {};
+      cDbValue* viewLongDescription {};
+
+      std::unordered_map<uint64_t,std::vector<Component>> prefetchedComponents;  // by eventid
+      std::unordered_map<long,std::vector<AuxValue>> prefetchedAux;              // by useid
+};
+
+//***************************************************************************
+// Epg Fetch Pool
+//  - worker threads with own db connections fetch and build the events of
+//    the given channels in parallel, one channel is handled completely by
+//    one worker
+//  - the results are consumed by next() in the thread which owns the vdr
+//    locks, at most 2 results per worker are queued
+//  - a worker which fails to fetch a channel (e.g. lost connection) queues
+//    the failed result and ends, the caller fetches the channel itself
+//***************************************************************************
+
+class cEpgFetchPool
+{
+   public:
+
+      struct Job
+      {
+         std::string channelId;
+         std::string channelName;
+      };
+
+      struct Result
+      {
+         Job job;
+         uint64_t fetchMs {0};
+         int status {success};                  // fail -> fetch failed, nothing staged
+         std::vector<cEpgFetcher::StagedEvent> staged;
+      };
+
+      cEpgFetchPool(int aSize) : size(std::max(aSize, 1)) {}
+      ~cEpgFetchPool() { stop(); }
+
+      int start(const std::vector<Job>& aJobs, time_t aSince);
+      int next(Result& result);              // success, done if all jobs consumed or fail
+      int remainingJobs(std::vector<Job>& remaining);
+      void stop();
+
+   private:
+
+      class cWorker : public cThread
+      {
+         public:
+
+            cWorker(cEpgFetchPool* aPool) : cThread("epg2vdr-fetch", true), pool(aPool) {}
+
+         protected:
+
+            void Action();
+
+            cEpgFetchPool* pool {};
+      };
+
+      int nextJob();                         // index of the next job, -1 if none left
+      int push(Result* result);              // waits for space in the queue
+
+      int size {1};
+      std::vector<Job> jobs;
+      time_t since {0};
+      std::vector<cWorker*> workers;
+
+      cMutex mutex;
+      cCondVar resultCondition;              // result queued or worker finished
+      cCondVar spaceCondition;               // result consumed
+      std::deque<Result*> results;
+      size_t jobIndex {0};
+      size_t consumed {0};
+      int running {0};
+      int loopActive {no};
+};
@@ -7,8 +7,15 @@
 
 #pragma once
 
+#include <set>
+#include <atomic>
+
 #include "lib/vdrlocks.h"
 #include "update.h"
+#include "evtindex.h"
+#include "epgwriter.h"
+#include "chanmap.h"
+#include "eitrecorder.h"
 
 #define CHANNELMARKOBSOLETE "OBSOLETE"
 
@@ -44,6 +51,7 @@ class cMutexTry
          if (pthread_mutex_trylock(&mutex) == 0)
          {
             locked++;
+            owner = cThread::ThreadId();
             // tell(0, "[%d] got lock (%d) [%p]", cThread::ThreadId(), locked, this);
 
             return yes;
@@ -60,12 +68,40 @@ class cMutexTry
          locked++;
       }
 
+      // wait at most ms for the lock
+
+      int timedLock(int ms)
+      {
+         struct timespec abstime;
+
+         clock_gettime(CLOCK_REALTIME, &abstime);
+         abstime.tv_sec += ms / 1000;
+         abstime.tv_nsec += (ms % 1000) * 1000000L;
+
+         if (abstime.tv_nsec >= 1000000000L)
+         {
+            abstime.tv_sec++;
+            abstime.tv_nsec -= 1000000000L;
+         }
+
+         if (pthread_mutex_timedlock(&mutex, &abstime) != 0)
+            return no;
+
+         locked++;
+         owner = cThread::ThreadId();
+
+         return yes;
+      }
+
+      int isOwnedByMe()  { return owner == cThread::ThreadId(); }
+
       void unlock()
       {
          if (locked)
          {
             // tell(0, "[%d] unlock (%d) [%p]", cThread::ThreadId(), locked, this);
             locked--;
+            owner = 0;
             pthread_mutex_unlock(&mutex);
          }
       }
@@ -74,55 +110,68 @@ class cMutexTry
 
       pthread_mutex_t mutex;
       int locked {0};
+      std::atomic<tThreadId> owner {0};     // thread holding the lock
 };
 
 //***************************************************************************
-// EPG Handler
+// EPG Handler Db
+//  - database connection, event index and channel map shared by the handler
+//    instances of all EIT threads (one per DVB device)
+//  - the connection is used only by checkConnection() (guarded by dbMutex),
+//    the segment transfers use only the index (indexMutex) and the channel
+//    map (lock free), the events are written by the writer on it's own connection
+//  - the segment transfers of different channels run concurrently, the
+//    channels are locked by a striped lock table
 //***************************************************************************
 
-class cEpgHandlerInstance
+class cEpgHandlerDb
 {
    public:
 
-      cEpgHandlerInstance()
-      {
-         tell(0, "Handler: Init handler instance for thread %d", cThread::ThreadId());
-      }
+      cEpgHandlerDb()  {}
+      ~cEpgHandlerDb() { saveIndex(); exitDb(); }
 
-      virtual ~cEpgHandlerInstance() { exitDb(); }
+      int dbConnected() { return initialized; }
 
-      virtual int dbConnected(int force = no)
-      {
-         return initialized
-            && connection
-            && (!force || connection->check() == success);
-      }
+      // a other database (EIT replay), the index isn't loaded from or saved
+      //   to the snapshot file then
+
+      void setDatabase(const char* name) { dbName = name; persistIndex = no; }
 
       int checkConnection()
       {
-         static int retry = 0;
+         cMutexLock lock(&dbMutex);
+
+         if (!initialized && time(0) < nextRetryAt)
+            return fail;
 
-         // check connection
+         // check connection, a dropped connection is re-established
+         //   in place (with all statements) by check()
 
-         if (!dbConnected(yes))
+         if (!initialized || connection->check() != success)
          {
             // try to connect
 
             tell(0, "Handler: Trying to re-connect to database!");
-            retry++;
 
             if (initDb() != success)
             {
                exitDb();
+               nextRetryAt = time(0) + 60;
 
                tell(0, "Handler: Database re-connect failed!");
                return fail;
             }
 
-            retry = 0;
             tell(0, "Handler: Connection established successfull!");
          }
 
+         if (!hasExternalIds())
+         {
+            nextRetryAt = time(0) + 60;
+            return fail;
+         }
+
          return success;
       }
 
@@ -130,7 +179,9 @@ class cEpgHandlerInstance
       {
          int busy = no;
 
-         if (!dbConnected())
+         cMutexLock lock(&dbMutex);
+
+         if (!initialized)
             return true;
 
          vdrDb->clear();
@@ -147,115 +198,160 @@ class cEpgHandlerInstance
          return busy;
       }
 
-      int initDb()
+      int mappingOfChannel(const tChannelID& channelId)   // cChannelMap::Mapping
       {
-         int status = success;
+         return channelMap.mappingOf(channelId);
+      }
 
-         exitDb();
+      int hasExternalIds()
+      {
+         return channelMap.size() > 0;
+      }
 
-         connection = new cDbConnection();
+      //***************************************************************************
+      // Channel Lock
+      //  - serializes the segment transfers of a channel (of different devices)
+      //  - the stripes aren't recursive, if the calling thread holds the stripe
+      //    already (a other instance driven by the same thread, as by the
+      //    replay) or the lock isn't got in time the segment is skipped (0)
+      //***************************************************************************
 
-         vdrDb = new cDbTable(connection, "vdrs");
-         if (vdrDb->open() != success) return fail;
+      cMutexTry* lockChannel(int channel)
+      {
+         cMutexTry* stripe = &stripes[channel % stripeCount];
 
-         mapDb = new cDbTable(connection, "channelmap");
-         if (mapDb->open() != success) return fail;
+         if (stripe->isOwnedByMe())
+         {
+            segSkipped++;
+            return 0;
+         }
 
-         eventsDb = new cDbTable(connection, "events");
-         if (eventsDb->open() != success) return fail;
+         if (!stripe->tryLock())
+         {
+            segContended++;
+
+            if (!stripe->timedLock(lockTimeoutMs))
+            {
+               segSkipped++;
+               return 0;
+            }
+         }
 
-         compDb = new cDbTable(connection, "components");
-         if (compDb->open() != success) return fail;
+         segProcessed++;
 
-         // select
-         //   * from events
-         // where
-         //   source = 'vdr'
-         //   and starttime = ?
-         //   and channelid = ?
+         return stripe;
+      }
 
-         selectEventByStarttime = new cDbStatement(eventsDb);
+      //***************************************************************************
+      // Event Index
+      //***************************************************************************
 
-         selectEventByStarttime->build("select ");
-         selectEventByStarttime->bindAllOut(0, cDBS::ftAll);
-         selectEventByStarttime->build(" from %s where source = 'vdr'", eventsDb->TableName());
-         selectEventByStarttime->bind("STARTTIME", cDBS::bndIn | cDBS::bndSet, " and ");
-         selectEventByStarttime->bind("CHANNELID", cDBS::bndIn | cDBS::bndSet, " and ");
+      int channelOf(const char* channelId)
+      {
+         cMutexLock lock(&indexMutex);
 
-         status += selectEventByStarttime->prepare();
+         // apply the removals reported by the writer
 
-         // prepare statement to get mapsp
-         // select
-         //   mergesp from channelmap
-         // where
-         //   source != 'vdr'
-         //   and channelid = ? limit 1
+         evtIndex.applyPending();
 
-         selectMergeSp = new cDbStatement(mapDb);
+         // forget the ended events
 
-         selectMergeSp->build("select ");
-         selectMergeSp->bind("MergeSp", cDBS::bndOut);
-         selectMergeSp->build(" from %s where source != 'vdr'", mapDb->TableName());
-         selectMergeSp->bind("ChannelId", cDBS::bndIn | cDBS::bndSet, " and ");
-         selectMergeSp->build(" limit 1");
+         if (time(0) >= nextPruneAt)
+         {
+            int n = evtIndex.removeEndedBefore(time(0) - tmeSecondsPerHour);
+
+            tell(2, "Handler: Removed %d ended events from the event index", n);
+            nextPruneAt = time(0) + 10 * tmeSecondsPerMinute;
+         }
+
+         return evtIndex.channelOf(channelId);
+      }
+
+      int findEvent(int channel, time_t start, cEventIndex::Entry* entry)
+      {
+         cMutexLock lock(&indexMutex);
+         const cEventIndex::Entry* e = evtIndex.find(channel, start);
 
-         status += selectMergeSp->prepare();
+         if (!e)
+            return no;
 
-         // prepare statement to mark wasted DVB events
+         *entry = *e;
 
-         // update events set delflg = ?, updsp = ?
-         //   where channelid = ? and source = ?
-         //      and starttime+duration > ?
-         //      and starttime < ?
-         //      and (tableid > ? or (tableid = ? and version <> ?))
+         return yes;
+      }
 
-         endTime = new cDbValue("starttime+duration", cDBS::ffInt, 10);
-         updateDelFlg = new cDbStatement(eventsDb);
+      void putEvent(int channel, time_t start, int duration, uchar tableId, uchar version,
+                    uint64_t hash, uint32_t compHash)
+      {
+         cMutexLock lock(&indexMutex);
+         evtIndex.put(channel, start, duration, tableId, version, hash, compHash);
+      }
 
-         updateDelFlg->build("update %s set ", eventsDb->TableName());
-         updateDelFlg->bind("DelFlg", cDBS::bndIn | cDBS::bndSet);
-         updateDelFlg->bind("UpdFlg", cDBS::bndIn | cDBS::bndSet, ", ");
-         updateDelFlg->bind("UpdSp", cDBS::bndIn | cDBS::bndSet, ", ");
-         updateDelFlg->build(" where ");
-         updateDelFlg->bind("ChannelId", cDBS::bndIn | cDBS::bndSet);
-         updateDelFlg->bind("Source", cDBS::bndIn | cDBS::bndSet, " and ");
-         updateDelFlg->bindCmp(0, endTime, ">" , " and ");
-         updateDelFlg->bindCmp(0, "StartTime", 0, "<" ,  " and ");
-         updateDelFlg->bindCmp(0, "TableId",   0, ">" ,  " and (");
-         updateDelFlg->bindCmp(0, "TableId",   0, "=" ,  " or (");
-         updateDelFlg->bindCmp(0, "Version",   0, "<>" , " and ");
-         updateDelFlg->build("));");
+      int dropSegment(int channel, time_t segmentStart, time_t segmentEnd, uchar tableId, uchar version)
+      {
+         cMutexLock lock(&indexMutex);
+         return evtIndex.dropSegment(channel, segmentStart, segmentEnd, tableId, version);
+      }
 
-         status += updateDelFlg->prepare();
+      cEventIndex* getIndex()   { return &evtIndex; }
 
-         // we need the same as select :(
+      void showStat()
+      {
+         tell(1, "Handler: %ld segments processed, %ld of them waited for the channel lock, %ld skipped",
+              (long)segProcessed, (long)segContended, (long)segSkipped);
+         tell(1, "Handler: %ld events handled, %ld (%.1f%%) with unchanged content",
+              (long)evtHandled, (long)evtUnchanged,
+              evtHandled ? evtUnchanged * 100.0 / evtHandled : 0.0);
+
+         cMutexLock lock(&indexMutex);
+         evtIndex.showStat();
+      }
 
-         selectDelFlg = new cDbStatement(eventsDb);
+      std::atomic<long> segSkipped {0};
+      std::atomic<long> evtHandled {0};
+      std::atomic<long> evtUnchanged {0};  // same content hash, only version/tableid changed
 
-         selectDelFlg->build("select ");
-         selectDelFlg->bind("EventId", cDBS::bndOut);
-         selectDelFlg->build(" from %s where ", eventsDb->TableName());
-         selectDelFlg->bind("ChannelId", cDBS::bndIn | cDBS::bndSet);
-         selectDelFlg->bind("Source", cDBS::bndIn | cDBS::bndSet, " and ");
-         selectDelFlg->bindCmp(0, endTime, ">" , " and ");
-         selectDelFlg->bindCmp(0, "StartTime", 0, "<" ,  " and ");
-         selectDelFlg->bindCmp(0, "TableId",   0, ">" ,  " and (");
-         selectDelFlg->bindCmp(0, "TableId",   0, "=" ,  " or (");
-         selectDelFlg->bindCmp(0, "Version",   0, "<>" , " and ");
-         selectDelFlg->build("));");
+      //***************************************************************************
+      // Save Index
+      //  - snapshot for the next start
+      //***************************************************************************
 
-         status += selectDelFlg->prepare();
+      int saveIndex()
+      {
+         cMutexLock lock(&indexMutex);
 
-         // -----------------
-         // delete from components where eventid = ?;
+         if (!indexStamp || !persistIndex)
+            return done;
 
-         delCompOf = new cDbStatement(compDb);
+         evtIndex.applyPending();
 
-         delCompOf->build("delete from %s where ", compDb->TableName());
-         delCompOf->bind("EventId", cDBS::bndIn | cDBS::bndSet);
-         delCompOf->build(";");
+         return evtIndex.save(indexFile().c_str(), indexStamp, indexOrigin.c_str());
+      }
 
-         status += delCompOf->prepare();
+   private:
+
+      enum Misc
+      {
+         lockTimeoutMs = 2000,
+         stripeCount = 32
+      };
+
+      int initDb()
+      {
+         int status = success;
+
+         exitDb();
+
+         connection = new cDbConnection(dbName.empty() ? 0 : dbName.c_str());
+
+         vdrDb = new cDbTable(connection, "vdrs");
+         if (vdrDb->open() != success) return fail;
+
+         mapDb = new cDbTable(connection, "channelmap");
+         if (mapDb->open() != success) return fail;
+
+         eventsDb = new cDbTable(connection, "events");
+         if (eventsDb->open() != success) return fail;
 
          if (status == success)
          {
@@ -273,17 +369,9 @@ class cEpgHandlerInstance
 
          if (connection)
          {
-            delete endTime;       endTime = 0;
-            delete updateDelFlg;  updateDelFlg = 0;
-            delete selectDelFlg;  selectDelFlg = 0;
-            delete delCompOf;     delCompOf = 0;
-
             delete vdrDb;         vdrDb = 0;
             delete eventsDb;      eventsDb = 0;
-            delete compDb;        compDb = 0;
             delete mapDb;         mapDb = 0;
-            delete selectMergeSp; selectMergeSp = 0;
-            delete selectEventByStarttime; selectEventByStarttime = 0;
 
             delete connection;    connection = 0;
          }
@@ -291,69 +379,332 @@ class cEpgHandlerInstance
          return done;
       }
 
+      //***************************************************************************
+      // Update Mem List
+      //  - at first the index is loaded from the snapshot file (if present),
+      //    then only the events changed since it's stamp are read from the db,
+      //    without snapshot all events are read
+      //  - on a reconnect the index is kept, only the changes are read
+      //  - a index of a other database or one which doesn't match the db
+      //    afterwards (truncated, restored, ...) is dropped and read again
+      //***************************************************************************
+
       int updateMemList()
       {
-         time_t start = time(0);
+         std::string origin = dbOrigin();
+
+         if (indexStamp && origin != indexOrigin)
+         {
+            tell(1, "Handler: Database changed from '%s' to '%s', dropping the event index",
+                 indexOrigin.c_str(), origin.c_str());
+            indexStamp = 0;
+         }
+
+         if (!indexStamp && persistIndex)
+         {
+            cMutexLock lock(&indexMutex);
+            std::string fileOrigin;
+
+            if (evtIndex.load(indexFile().c_str(), indexStamp, fileOrigin) == success && fileOrigin != origin)
+            {
+               tell(1, "Handler: Event index '%s' was read from '%s', ignoring",
+                    indexFile().c_str(), fileOrigin.c_str());
+               evtIndex.clear();
+               indexStamp = 0;
+            }
+            else if (indexStamp)
+            {
+               int outdated = evtIndex.removeEndedBefore(time(0) - tmeSecondsPerHour);
+
+               tell(1, "Handler: Loaded event index with %zu events from '%s' (%d outdated removed)",
+                    evtIndex.size(), indexFile().c_str(), outdated);
+            }
+         }
+
+         indexOrigin = origin;
+
+         if (!indexStamp)
+            return readHashes(yes);
+
+         if (readHashes(no) != success)
+            return fail;
+
+         if (indexMatchesDb())
+            return success;
 
-         evtMemList.clear();
+         indexStamp = 0;
+
+         return readHashes(yes);
+      }
+
+      //***************************************************************************
+      // Index Matches Db
+      //  - compare the index with the not deleted and not ended vdr events of
+      //    the db, the max updsp of the db must not be below the stamp
+      //***************************************************************************
 
-         // select eventid, channelid, version, tableid, delflg
+      int indexMatchesDb()
+      {
+         time_t cutoff = time(0) - tmeSecondsPerHour;
+         std::string active = "sum((delflg is null or delflg <> 'Y') and starttime+duration >= "
+            + std::to_string(cutoff) + ")";
+         cDbValue activeCount(active.c_str(), cDBS::ffInt, 10);
+         cDbValue maxUpdsp("max(updsp)", cDBS::ffInt, 10);
+
+         // select sum(not deleted and not ended), max(updsp)
          //   from events where source = 'vdr'
 
-         cDbStatement* selectAllVdrEvents = new cDbStatement(eventsDb);
+         cDbStatement* selectCheck = new cDbStatement(eventsDb);
 
-         selectAllVdrEvents->build("select ");
-         selectAllVdrEvents->bind("EventId", cDBS::bndOut);
-         selectAllVdrEvents->bind("ChannelId", cDBS::bndOut, ", ");
-         selectAllVdrEvents->bind("Version", cDBS::bndOut, ", ");
-         selectAllVdrEvents->bind("TableId", cDBS::bndOut, ", ");
-         selectAllVdrEvents->bind("DelFlg", cDBS::bndOut, ", ");
-         selectAllVdrEvents->build(" from %s where source = 'vdr'", eventsDb->TableName());
+         selectCheck->build("select ");
+         selectCheck->bind(&activeCount, cDBS::bndOut);
+         selectCheck->bind(&maxUpdsp, cDBS::bndOut, ", ");
+         selectCheck->build(" from %s where source = 'vdr'", eventsDb->TableName());
 
-         if (selectAllVdrEvents->prepare() != success)
+         if (selectCheck->prepare() != success || !selectCheck->find())
+         {
+            // can't check, keep the index
+
+            delete selectCheck;
+            return yes;
+         }
+
+         long dbCount = activeCount.getIntValue();
+         time_t dbMaxUpdsp = maxUpdsp.getIntValue();
+
+         selectCheck->freeResult();
+         delete selectCheck;
+
+         cMutexLock lock(&indexMutex);
+
+         evtIndex.applyPending();
+         evtIndex.removeEndedBefore(cutoff);
+
+         if (dbMaxUpdsp >= indexStamp && (size_t)dbCount == evtIndex.size())
+            return yes;
+
+         tell(0, "Handler: Event index doesn't match the db (%zu/%ld events, stamp %s/%s), reading all hashes",
+              evtIndex.size(), dbCount, l2pTime(indexStamp).c_str(), l2pTime(dbMaxUpdsp).c_str());
+
+         return no;
+      }
+
+      std::string dbOrigin()
+      {
+         return std::string(cDbConnection::getHost()) + ":" + std::to_string(cDbConnection::getPort())
+            + "/" + connection->database();
+      }
+
+      //***************************************************************************
+      // Read Hashes
+      //  - all vdr events (full) or only the changes since the index stamp
+      //***************************************************************************
+
+      int readHashes(int full)
+      {
+         time_t start = time(0);
+         time_t maxUpdsp = 0;
+         cDbValue since("updsp", cDBS::ffInt, 10);
+
+         // select channelid, starttime, duration, version, tableid, delflg, updsp
+         //   from events where source = 'vdr' [and updsp >= ?]
+
+         cDbStatement* selectVdrEvents = new cDbStatement(eventsDb);
+
+         selectVdrEvents->build("select ");
+         selectVdrEvents->bind("ChannelId", cDBS::bndOut);
+         selectVdrEvents->bind("StartTime", cDBS::bndOut, ", ");
+         selectVdrEvents->bind("Duration", cDBS::bndOut, ", ");
+         selectVdrEvents->bind("Version", cDBS::bndOut, ", ");
+         selectVdrEvents->bind("TableId", cDBS::bndOut, ", ");
+         selectVdrEvents->bind("DelFlg", cDBS::bndOut, ", ");
+         selectVdrEvents->bind("UpdSp", cDBS::bndOut, ", ");
+         selectVdrEvents->build(" from %s where source = 'vdr'", eventsDb->TableName());
+
+         if (!full)
+            selectVdrEvents->bindCmp(0, &since, ">=", " and ");
+
+         if (selectVdrEvents->prepare() != success)
          {
             tell(0, "Handler: Aborted reading hashes from db due to prepare error");
-            delete selectAllVdrEvents;
+            delete selectVdrEvents;
             return fail;
          }
 
-         tell(1, "Handler: Start reading hashes from db");
+         if (full)
+            tell(1, "Handler: Start reading hashes from db");
+         else
+            tell(1, "Handler: Start reading hashes changed since %s from db", l2pTime(indexStamp).c_str());
+
+         // read the rows first, the index is locked only to fill it
+
+         struct Row { std::string channelId; time_t start; int duration; uchar tableId; uchar version; int deleted; };
+         std::vector<Row> rows;
 
          eventsDb->clear();
+         since.setValue(indexStamp - 60);   // some tolerance for transactions committed late
+
+         int f;
+
+         for (f = selectVdrEvents->find(); f > 0; f = selectVdrEvents->fetch())
+         {
+            maxUpdsp = std::max(maxUpdsp, (time_t)eventsDb->getIntValue("UpdSp"));
+
+            if (full && eventsDb->hasValue("DelFlg", "Y"))
+               continue;
+
+            rows.push_back({ eventsDb->getStrValue("CHANNELID"),
+                             (time_t)eventsDb->getIntValue("STARTTIME"),
+                             (int)eventsDb->getIntValue("Duration"),
+                             (uchar)eventsDb->getIntValue("TableId"),
+                             (uchar)eventsDb->getIntValue("Version"),
+                             eventsDb->hasValue("DelFlg", "Y") });
+
+            tell(4, "Handler: cInsert: '%ld:%s' with %ld/%ld",
+                 eventsDb->getIntValue("STARTTIME"), eventsDb->getStrValue("CHANNELID"),
+                 eventsDb->getIntValue("TableId"), eventsDb->getIntValue("Version"));
+         }
+
+         int failed = f == fail || selectVdrEvents->fetchFailed();
+
+         selectVdrEvents->freeResult();
+         delete selectVdrEvents;
+
+         if (failed)
+         {
+            tell(0, "Handler: Aborted reading hashes from db due to fetch error");
+            return fail;
+         }
+
+         cMutexLock lock(&indexMutex);
 
-         for (int f = selectAllVdrEvents->find(); f; f = selectAllVdrEvents->fetch())
+         if (full)
+            evtIndex.clear();
+
+         for (const auto& r : rows)
          {
-            char evtKey[100];
+            int channel = evtIndex.channelOf(r.channelId.c_str());
 
-            if (eventsDb->hasValue("DelFlg", "Y"))
+            if (r.deleted)
+            {
+               evtIndex.remove(channel, r.start);
                continue;
+            }
+
+            // keep the hashes if the event is unchanged
+
+            const cEventIndex::Entry* e = evtIndex.find(channel, r.start);
+            int unchanged = e && e->tableid == r.tableId && e->version == r.version;
+
+            evtIndex.put(channel, r.start, r.duration, r.tableId, r.version,
+                         unchanged ? e->hash : 0, unchanged ? e->compHash : 0);
+         }
+
+         indexStamp = std::max(indexStamp, maxUpdsp);
+
+         tell(1, "Handler: Finished reading hashes from db, got %zu %s, index has %d hashes (in %ld seconds)",
+              rows.size(), full ? "hashes" : "changes", (int)evtIndex.size(), time(0)-start);
 
-            sprintf(evtKey, "%ld:%s",
-                    eventsDb->getIntValue("STARTTIME"),
-                    eventsDb->getStrValue("CHANNELID"));
+         evtIndex.showStat();
 
-            evtMemList[evtKey].version = eventsDb->getIntValue("Version");
-            evtMemList[evtKey].tableid = eventsDb->getIntValue("TableId");
+         if (full && indexStamp && persistIndex)
+            evtIndex.save(indexFile().c_str(), indexStamp, indexOrigin.c_str());
 
-            tell(4, "Handler: cInsert: '%s' with %d/%d", evtKey, evtMemList[evtKey].tableid, evtMemList[evtKey].version);
+         return success;
+      }
+
+      std::string indexFile()
+      {
+         return std::string(cPlugin::CacheDirectory("epg2vdr")) + "/eventindex.dat";
+      }
+
+      int updateExternalIdsMap()
+      {
+         std::map<std::string,std::string> ids;
+
+         tell(1, "Handler: Start reading external ids from db");
+         mapDb->clear();
+
+         // select extid, channelid
+         //   from channelmap
+
+         cDbStatement* selectAll = new cDbStatement(mapDb);
+
+         selectAll->build("select ");
+         selectAll->bind("ExternalId", cDBS::bndOut);
+         selectAll->bind("ChannelId", cDBS::bndOut, ", ");
+         selectAll->build(" from %s", mapDb->TableName());
+
+         if (selectAll->prepare() != success)
+         {
+            tell(0, "Handler: Reading external id's from db aborted due to prepare error");
+            delete selectAll;
+            return fail;
          }
 
-         selectAllVdrEvents->freeResult();
-         delete selectAllVdrEvents;
+         for (int f = selectAll->find(); f; f = selectAll->fetch())
+            ids[mapDb->getStrValue("ChannelId")] = mapDb->getStrValue("ExternalId");
 
-         tell(1, "Handler: Finished reading hashes from db, got %d hashes (in %ld seconds)",
-              (int)evtMemList.size(), time(0)-start);
+         tell(1, "Handler: Finished reading external id's from db, got %d id's",
+              (int)ids.size());
+
+         selectAll->freeResult();
+         delete selectAll;
+
+         channelMap.publish(ids);
 
          return success;
       }
 
+      std::atomic<int> initialized {no};
+      time_t nextRetryAt {0};
+      cMutex dbMutex;                      // the connection and it's tables
+      cChannelMap channelMap;              // external ids of all channels of the channelmap
+      cMutex indexMutex;                   // evtIndex, leaf lock
+      cEventIndex evtIndex;                // version/tableid of the known DVB events
+      time_t indexStamp {0};               // max updsp of the events known by the index
+      std::string indexOrigin;             // the database of the index (host:port/name)
+      std::string dbName;                  // empty for the configured database
+      int persistIndex {yes};              // load/save the index snapshot
+      time_t nextPruneAt {0};
+      cMutexTry stripes[stripeCount];      // channel locks of the segment transfers
+
+      std::atomic<long> segProcessed {0};
+      std::atomic<long> segContended {0};
+
+      cDbConnection* connection {};
+      cDbTable* eventsDb {};
+      cDbTable* mapDb {};
+      cDbTable* vdrDb {};
+};
+
+//***************************************************************************
+// EPG Handler
+//  - lightweight per thread state of a segment transfer, the database
+//    stuff is shared by all instances (cEpgHandlerDb)
+//***************************************************************************
+
+class cEpgHandlerInstance
+{
+   public:
+
+      cEpgHandlerInstance(cEpgHandlerDb* aDb, cEpgWriter* aWriter)
+      {
+         db = aDb;
+         writer = aWriter;
+         tell(0, "Handler: Init handler instance for thread %d", cThread::ThreadId());
+      }
+
+      virtual ~cEpgHandlerInstance() { delete segment; if (channelLock) channelLock->unlock(); }
+
+      int dbConnected()   { return db->dbConnected(); }
+
       //***************************************************************************
       // Ignore Channel
       //***************************************************************************
 
       virtual bool IgnoreChannel(const cChannel* Channel)
       {
-         static time_t nextRetryAt = time(0);
          LogDuration l("IgnoreChannel", 5);
 
          // if this method is called the channel is
@@ -362,16 +713,7 @@ class cEpgHandlerInstance
 
          // only check the DB connection here!!
 
-         if (!dbConnected() && time(0) < nextRetryAt)
-            return true;
-
-         if (checkConnection() != success || externIdMap.size() < 1)
-         {
-            nextRetryAt = time(0) + 60;
-            return true;
-         }
-
-         return false;
+         return db->checkConnection() != success;
       }
 
       //***************************************************************************
@@ -380,13 +722,33 @@ class cEpgHandlerInstance
 
       virtual bool BeginSegmentTransfer(const cChannel* Channel, bool dummy)
       {
+         // the last transfer wasn't ended (a later handler refused the begin),
+         //   release it's channel lock and forget it's events
+
+         if (channelLock || segment)
+            abortSegment();
+
          // inital die channelid setzen
 
          channelId = Channel->GetChannelID();
+         channelName = (const char*)channelId.ToString();
+         channel = db->channelOf(channelName.c_str());
+
+         if (!channel)
+         {
+            db->segSkipped++;
+            return false;
+         }
+
+         // wait while an other device transfers a segment of this channel
+
+         if (!(channelLock = db->lockChannel(channel)))
+            return false;
 
          return true;
       }
 
+
       //***************************************************************************
       // Handled Externally
       //   hier wird festgelegt ob das Event via VDR im EPG landen soll
@@ -415,7 +777,7 @@ class cEpgHandlerInstance
 
          // dbConnected() here okay -> if not connected we return false an the vdr will handle the event?!?
 
-         if (dbConnected() && getExternalIdOfChannel(&channelId) != "")
+         if (dbConnected() && db->mappingOfChannel(channelId))
             return true;
 
          return false;
@@ -423,16 +785,47 @@ class cEpgHandlerInstance
 
       virtual bool EndSegmentTransfer(bool Modified, bool dummy)
       {
-         if (dummy || !dbConnected() || !connection->inTransaction())
+         if (dummy || !segment)
+         {
+            if (channelLock)
+            {
+               channelLock->unlock();
+               channelLock = 0;
+            }
+
             return false;
+         }
+
+         // hand over the segment to the writer, it's written in the background
 
-         if (Modified)
-            connection->commit();
+         if (Modified && segment->records.size())
+         {
+            if (writer->enqueue(segment) != success)
+            {
+               tell(1, "Handler: Writer queue full, dropped segment of channel '%s'",
+                    segment->channelId.c_str());
+               segment->revertIndex();
+               delete segment;
+            }
+         }
          else
-            connection->rollback();
+         {
+            delete segment;
+         }
+
+         segment = 0;
+
+         if (channelLock)
+         {
+            channelLock->unlock();
+            channelLock = 0;
+         }
 
          if (Epg2VdrConfig.loglevel > 2)
-            connection->showStat("handler");
+         {
+            db->showStat();
+            writer->showStat();
+         }
 
          return false;
       }
@@ -443,55 +836,55 @@ class cEpgHandlerInstance
 
       virtual bool IsUpdate(tEventID EventID, time_t StartTime, uchar TableID, uchar Version)
       {
-         char evtKey[100];
          LogDuration l("IsUpdate", 5);
 
          if (!dbConnected())
             return false;
 
-         if (!isZero(getExternalIdOfChannel(&channelId).c_str()) && StartTime > time(0) + 4 * tmeSecondsPerDay)
+         if (db->mappingOfChannel(channelId) == cChannelMap::cmExternal && StartTime > time(0) + 4 * tmeSecondsPerDay)
             return false;
 
-         sprintf(evtKey, "%ld:%s", StartTime, (const char*)channelId.ToString());
+         cEventIndex::Entry known;
 
-         if (evtMemList.find(evtKey) == evtMemList.end())
+         if (!db->findEvent(channel, StartTime, &known))
          {
-            tell(4, "Handler: Handle insert (or starttime update) of event '%s' (%d) for channel '%s'",
-                 evtKey, EventID, (const char*)channelId.ToString());
+            if (Epg2VdrConfig.loglevel > 3)
+               tell(4, "Handler: Handle insert (or starttime update) of event '%ld:%s' (%d) for channel '%s'",
+                    StartTime, channelName.c_str(), EventID, channelName.c_str());
 
-            if (!connection->inTransaction())
-               connection->startTransaction();
+            openSegment();
 
             return true;
          }
 
-         uchar currentTableId = std::max(uchar(evtMemList[evtKey].tableid), uchar(0x4E));
+         uchar currentTableId = std::max(uchar(known.tableid), uchar(0x4E));
 
          // skip bigger ids as current
 
          if (TableID > currentTableId)
          {
-            tell(4, "Handler: Ignoring update with older tableid (%d) for event '%s' (%d)(has tableid %d)",
-                 TableID, evtKey, EventID, evtMemList[evtKey].tableid);
+            if (Epg2VdrConfig.loglevel > 3)
+               tell(4, "Handler: Ignoring update with older tableid (%d) for event '%ld:%s' (%d)(has tableid %d)",
+                    TableID, StartTime, channelName.c_str(), EventID, known.tableid);
             return false;
          }
 
          // skip if version an tid identical
 
-         if (currentTableId == TableID && evtMemList[evtKey].version == Version)
+         if (currentTableId == TableID && known.version == Version)
          {
-            tell(4, "Handler: Ignoring 'non' update for event '%s' (%d), version still (%d)",
-                 evtKey, EventID, Version);
+            if (Epg2VdrConfig.loglevel > 3)
+               tell(4, "Handler: Ignoring 'non' update for event '%ld:%s' (%d), version still (%d)",
+                    StartTime, channelName.c_str(), EventID, Version);
             return false;
          }
 
          if (Epg2VdrConfig.loglevel > 3)
-            tell(4, "Handler: Handle update of event '%s' (%d)  %d/%d - %d/%d", evtKey, EventID,
-                 Version, TableID,
-                 evtMemList[evtKey].version, evtMemList[evtKey].tableid);
+            tell(4, "Handler: Handle update of event '%ld:%s' (%d)  %d/%d - %d/%d",
+                 StartTime, channelName.c_str(), EventID,
+                 Version, TableID, known.version, known.tableid);
 
-         if (!connection->inTransaction())
-            connection->startTransaction();
+         openSegment();
 
          return true;
       }
@@ -502,8 +895,6 @@ class cEpgHandlerInstance
 
       virtual bool HandleEvent(cEvent* event)
       {
-         int oldStartTime = 0;
-
          if (!dbConnected() || !event || !channelId.Valid())
             return false;
 
@@ -517,118 +908,32 @@ class cEpgHandlerInstance
 
          // Events der Kanäle welche nicht in der map zu finden sind ignorieren
 
-         if (getExternalIdOfChannel(&channelId) == "")
+         if (!db->mappingOfChannel(channelId))
             return false;
 
-         if (!connection->inTransaction())
+         if (!segment)
          {
-            tell(0, "Handler: Error missing tact in HandleEvent");
+            tell(0, "Handler: Error missing segment in HandleEvent");
             return false;
          }
 
-         std::string comp;
+         // copy the event to the segment, the database is updated by the writer
 
-         // lookup the event ..
-         //   first try by starttime
-
-         eventsDb->clear();
-         eventsDb->setValue("CHANNELID", channelId.ToString());
-         eventsDb->setValue("STARTTIME", event->StartTime());
-
-         int insert = !selectEventByStarttime->find();
-
-         if (insert)
-         {
-            // try lookup by eventid
-
-            eventsDb->setValue("CHANNELID", channelId.ToString());
-            eventsDb->setBigintValue("EVENTID", (long)event->EventID());
-
-            if (eventsDb->find())
-            {
-               // fount => NOT a insert, just a update of the starttime
-
-               insert = no;
-               oldStartTime = eventsDb->getIntValue("STARTTIME");
-               eventsDb->setValue("STARTTIME", event->StartTime());
-            }
-         }
+         segment->records.emplace_back();
+         cEpgRecord* r = &segment->records.back();
 
-         // reinstate ??
-
-         if (eventsDb->hasValue("DELFLG", "Y"))
-         {
-            char updFlg = Us::usPassthrough;
-
-            mapDb->clear();
-            mapDb->setValue("CHANNELID", channelId.ToString());
-
-            if (selectMergeSp->find())
-            {
-               time_t mergesp = mapDb->getIntValue("MERGESP");
-               long masterid = eventsDb->getIntValue("MASTERID");
-               long useid = eventsDb->getIntValue("USEID");
-
-               if (event->StartTime() > mergesp)
-                  updFlg = Us::usRemove;
-               else if (event->StartTime() <= mergesp && masterid == useid)
-                  updFlg = Us::usActive;
-               else if (event->StartTime() <= mergesp && masterid != useid)
-                  updFlg = Us::usLink;
-            }
-
-            eventsDb->setCharValue("UPDFLG", updFlg);
-            eventsDb->getValue("DELFLG")->setNull();
-         }
-
-         if (!insert && std::abs(event->StartTime() - eventsDb->getIntValue("StartTime")) > 6*tmeSecondsPerHour)
-         {
-            tell(3, "Handler: Info: Start time of %d/%s - '%s' moved %ld hours from %s to %s - '%s'",
-                 event->EventID(), (const char*)channelId.ToString(),
-                 eventsDb->getStrValue("Title"),
-                 (event->StartTime() - eventsDb->getIntValue("StartTime")) / tmeSecondsPerHour,
-                 l2pTime(eventsDb->getIntValue("StartTime")).c_str(),
-                 l2pTime(event->StartTime()).c_str(),
-                 event->Title());
-         }
-
-         time_t end = event->StartTime() + event->Duration();
-
-         if (!insert
-             && end < time(0) - 2*tmeSecondsPerHour
-             && eventsDb->getIntValue("StartTime") >  time(0)
-             && event->StartTime() < eventsDb->getIntValue("StartTime"))
-         {
-            tell(1, "Handler: Info: Got update of %d/%s with startime more than 2h in past "
-                 "(%s/%d) before (%s), ignoring update, set delflg instead",
-                 event->EventID(), (const char*)channelId.ToString(),
-                 l2pTime(event->StartTime()).c_str(), event->Duration(),
-                 l2pTime(eventsDb->getIntValue("StartTime")).c_str());
-
-            eventsDb->setValue("DelFlg", "Y");
-            eventsDb->setCharValue("UpdFlg", Us::usDelete);
-         }
-         else
-         {
-            eventsDb->setValue("StartTime", event->StartTime());
-         }
-
-         if (!insert && eventsDb->getIntValue("VPS") != event->Vps())
-            tell(1, "Handler: Toggle vps flag for '%s' at '%s' from %s to %s",
-                 event->Title(), (const char*)channelId.ToString(),
-                 l2pTime(eventsDb->getIntValue("VPS")).c_str(), l2pTime(event->Vps()).c_str());
-
-         eventsDb->setValue("Source", "vdr");
-         eventsDb->setValue("TableId", event->TableID());
-         eventsDb->setValue("Version", event->Version());
-         eventsDb->setValue("Title", event->Title());
-         eventsDb->setValue("LongDescription", event->Description());
-         eventsDb->setValue("Duration", event->Duration());
-         eventsDb->setValue("ParentalRating", event->ParentalRating());
-         eventsDb->setValue("Vps", event->Vps());
-
-         if (!isEmpty(event->ShortText()))
-            eventsDb->setValue("ShortText", event->ShortText());
+         r->eventId = event->EventID();
+         r->startTime = event->StartTime();
+         r->duration = event->Duration();
+         r->tableId = event->TableID();
+         r->version = event->Version();
+         r->parentalRating = event->ParentalRating();
+         r->vps = event->Vps();
+         r->hasTitle = event->Title() != 0;
+         r->title = notNull(event->Title(), "");
+         r->shortText = notNull(event->ShortText(), "");
+         r->hasDescription = event->Description() != 0;
+         r->description = notNull(event->Description(), "");
 
          // contents
 
@@ -638,98 +943,49 @@ class cEpgHandlerInstance
             if (event->Contents(i) > 0)
                sprintf(eos(contents), "0x%x,", event->Contents(i));
 
-         if (!isEmpty(contents))
-            eventsDb->setValue("CONTENTS", contents);
+         r->contents = contents;
 
          // components ..
 
-         compDb->clear();
-         compDb->setBigintValue("EVENTID", eventsDb->getBigintValue("EVENTID"));
-         delCompOf->execute();
-
          if (event->Components())
          {
             for (int i = 0; i < event->Components()->NumComponents(); i++)
             {
                tComponent* p = event->Components()->Component(i);
 
-               compDb->clear();
-               compDb->setBigintValue("EventId", eventsDb->getBigintValue("EVENTID"));
-               compDb->setValue("ChannelId", channelId.ToString());
-               compDb->setValue("Stream", p->stream);
-               compDb->setValue("Type", p->type);
-               compDb->setValue("Lang", p->language);
-               compDb->setValue("Description", p->description ? p->description : "");
-               compDb->store();
+               r->components.push_back({ p->stream, p->type, notNull(p->language, ""),
+                                         notNull(p->description, "") });
             }
          }
 
-         // compressed ..
-
-         if (event->Title())
-         {
-            comp = event->Title();
-            prepareCompressed(comp);
-            eventsDb->setValue("COMPTITLE", comp.c_str());
-         }
+         // same content as known -> only version and table id changed
 
-         if (!isEmpty(event->ShortText()))
-         {
-            comp = event->ShortText();
-            prepareCompressed(comp);
-            eventsDb->setValue("COMPSHORTTEXT", comp.c_str());
-         }
+         uint64_t hash = r->contentHash();
+         uint32_t compHash = r->componentsHash();
+         cEventIndex::Entry known;
 
-         if (!isEmpty(event->Description()))
-         {
-            comp = event->Description();
-            prepareCompressed(comp);
-            eventsDb->setValue("COMPLONGDESCRIPTION", comp.c_str());
-         }
+         db->evtHandled++;
 
-         if (insert)
+         if (db->findEvent(channel, event->StartTime(), &known))
          {
-            eventsDb->setValue("UseId", 0L);
-            eventsDb->setCharValue("UpdFlg", Us::usPassthrough); // default (vdr:000 events)
-
-            mapDb->clear();
-            mapDb->setValue("ChannelId", channelId.ToString());
-
-            if (selectMergeSp->find())
+            if (known.hash == hash)
             {
-               // vdr event for merge with external event
-
-               time_t mergesp = mapDb->getIntValue("MergeSp");
-               eventsDb->setCharValue("UpdFlg", event->StartTime() > mergesp ? Us::usInactive : Us::usActive);
+               r->type = cEpgRecord::rtVersion;
+               db->evtUnchanged++;
             }
 
-            eventsDb->insert();
-         }
-         else
-         {
-            eventsDb->update();
-         }
+            // the components are only rewritten if they changed
 
-         if (!insert && oldStartTime)
-         {
-            char evtKey[100];
-            sprintf(evtKey, "%ld:%s", (long)oldStartTime, (const char*)channelId.ToString());
-            evtMemList.erase(evtKey);
-            tell(4, "Handler: cRemove: '%s'  (due to starttime update)", evtKey);
+            r->componentsUnchanged = known.compHash == compHash;
          }
 
-         // update hash map
-
-         char evtKey[100];
+         // update event index
 
-         sprintf(evtKey, "%ld:%s", (long)event->StartTime(), (const char*)channelId.ToString());
+         db->putEvent(channel, event->StartTime(), event->Duration(), event->TableID(), event->Version(),
+                      hash, compHash);
 
-         evtMemList[evtKey].version = event->Version();
-         evtMemList[evtKey].tableid = event->TableID();
-
-         tell(4, "Handler: cUpdate/cInsert: '%s' to %d/%d", evtKey, evtMemList[evtKey].tableid, evtMemList[evtKey].version);
-
-         selectEventByStarttime->freeResult();
+         tell(4, "Handler: cUpdate/cInsert: '%ld:%s' to %d/%d", (long)event->StartTime(),
+              channelName.c_str(), event->TableID(), event->Version());
 
          return true;
       }
@@ -743,139 +999,74 @@ class cEpgHandlerInstance
       {
          // we handle only vdr events here (provided by DVB)
 
-         if (!dbConnected() || getExternalIdOfChannel(&channelId) == "")
+         if (!dbConnected() || !db->mappingOfChannel(channelId))
             return false;
 
-         if (!connection->inTransaction())
+         if (!segment)
          {
-            tell(0, "Handler: Error missing tact DropOutdated");
+            tell(0, "Handler: Error missing segment in DropOutdated");
             return false;
          }
 
          if (SegmentStart <= 0 || SegmentEnd <= 0)
             return false;
 
-         LogDuration l("DropOutdated", 5);
+         // forget the outdated events, they are marked as deleted by the writer
 
-         eventsDb->clear();
-         eventsDb->setValue("ChannelId", Schedule->ChannelID().ToString());
-         eventsDb->setValue("Source", "vdr");
-         eventsDb->setValue("UpdSp", time(0));
-         eventsDb->setValue("StartTime", SegmentEnd);
-         eventsDb->setValue("TableId", TableID);
-         eventsDb->setValue("Version", Version);
-         endTime->setValue(SegmentStart);
+         int n = db->dropSegment(channel, SegmentStart, SegmentEnd, TableID, Version);
 
-         // remove segment from cache
+         if (n)
+            tell(4, "Handler: cRemove: %d events of '%s' in %ld - %ld", n, channelName.c_str(),
+                 (long)SegmentStart, (long)SegmentEnd);
 
-         for (int f = selectDelFlg->find(); f; f = selectDelFlg->fetch())
-         {
-            char evtKey[100];
-
-            sprintf(evtKey, "%ld:%s",
-                    eventsDb->getIntValue("STARTTIME"),
-                    eventsDb->getStrValue("CHANNELID"));
-
-            evtMemList.erase(evtKey);
-            tell(4, "Handler: cRemove: '%s'", evtKey);
-         }
+         segment->records.emplace_back();
+         cEpgRecord* r = &segment->records.back();
 
-         selectDelFlg->freeResult();
-
-         eventsDb->setValue("DELFLG", "Y");
-         eventsDb->setCharValue("UPDFLG", Us::usDelete);
-
-         // mark segment as deleted
-
-         updateDelFlg->execute();
+         r->type = cEpgRecord::rtDrop;
+         r->startTime = SegmentStart;
+         r->endTime = SegmentEnd;
+         r->tableId = TableID;
+         r->version = Version;
 
          return true;
       }
 
    private:
-
-      std::string getExternalIdOfChannel(tChannelID* channelId)
+      void abortSegment()
       {
-         char* id = 0;
-         std::string extid = "";
-
-         if (externIdMap.size() < 1)
-            return "";
-
-         id = strdup(channelId->ToString());
-
-         if (externIdMap.find(id) != externIdMap.end())
-            extid = externIdMap[id];
-
-         free(id);
-
-         return extid;
-      }
-
-      int updateExternalIdsMap()
-      {
-         externIdMap.clear();
-         tell(1, "Handler: Start reading external ids from db");
-         mapDb->clear();
-
-         // select extid, channelid
-         //   from channelmap
-
-         cDbStatement* selectAll = new cDbStatement(mapDb);
-
-         selectAll->build("select ");
-         selectAll->bind("ExternalId", cDBS::bndOut);
-         selectAll->bind("ChannelId", cDBS::bndOut, ", ");
-         selectAll->build(" from %s", mapDb->TableName());
-
-         if (selectAll->prepare() != success)
+         if (segment)
          {
-            tell(0, "Handler: Reading external id's from db aborted due to prepare error");
-            delete selectAll;
-            return fail;
+            segment->revertIndex();
+            delete segment;
+            segment = 0;
          }
 
-         for (int f = selectAll->find(); f; f = selectAll->fetch())
+         if (channelLock)
          {
-            const char* extid = mapDb->getStrValue("ExternalId");
-            const char* chan = mapDb->getStrValue("ChannelId");
-
-            externIdMap[chan] = extid;
+            channelLock->unlock();
+            channelLock = 0;
          }
-
-         tell(1, "Handler: Finished reading external id's from db, got %d id's",
-              (int)externIdMap.size());
-
-         selectAll->freeResult();
-         delete selectAll;
-
-         return success;
       }
 
-      struct MemMap
+      void openSegment()
       {
-         int version;
-         int tableid;
-      };
-
-      std::map<std::string,MemMap> evtMemList;
-      std::map<std::string,std::string> externIdMap;
-      tChannelID channelId;
+         if (segment)
+            return;
 
-      int initialized {false};
-      cDbConnection* connection {};
+         segment = new cEpgSegment;
+         segment->channelId = (const char*)channelId.ToString();
+         segment->index = db->getIndex();
+         segment->channel = channel;
+      }
 
-      cDbTable* eventsDb {};
-      cDbTable* mapDb {};
-      cDbTable* vdrDb {};
-      cDbTable* compDb {};
+      cEpgHandlerDb* db {};
+      tChannelID channelId;
+      std::string channelName;
+      int channel {0};                     // index of channelId in the event index
+      cMutexTry* channelLock {};           // lock of the channel while the segment transfer
 
-      cDbValue* endTime {};
-      cDbStatement* updateDelFlg {};
-      cDbStatement* selectDelFlg {};
-      cDbStatement* delCompOf {};
-      cDbStatement* selectMergeSp {};
-      cDbStatement* selectEventByStarttime {};
+      cEpgWriter* writer {};
+      cEpgSegment* segment {};             // the pending segment transfer
 
       // cUpdate* update;
 };
@@ -892,7 +1083,8 @@ class cEpg2VdrEpgHandler : public cEpgHandler
 
       ~cEpg2VdrEpgHandler()
       {
-         handlerMutex.lock();
+         writer.stop();
+         cMutexLock lock(&instanceMutex);
 
          std::map<tThreadId,cEpgHandlerInstance*>::iterator it;
 
@@ -901,13 +1093,40 @@ class cEpg2VdrEpgHandler : public cEpgHandler
             delete handler[it->first];
             handler[it->first] = 0;
          }
-
-         handlerMutex.unlock();
       }
 
       int getActive()           { return active; }
       void setActive(int state) { active = state; }
 
+      cEpgWriter* getWriter()   { return &writer; }
+
+      //***************************************************************************
+      // Stop
+      //   - drain the writer, then save the event index snapshot for the next
+      //     start, called by the plugin's Stop() (the handler itself may be
+      //     deleted too late or not at all on shutdown)
+      //***************************************************************************
+
+      void stop()
+      {
+         replayer.stop();
+         writer.stop();
+         handlerDb.saveIndex();
+      }
+
+      //***************************************************************************
+      // Record / Replay
+      //   - record the calls of the handler instances, replay a recording
+      //     in background into a other database
+      //***************************************************************************
+
+      int startRecording(const char* file) { return recorder.open(file); }
+      int stopRecording()                  { return recorder.close(); }
+      int isRecording()                    { return recorder.isActive(); }
+
+      int startReplay(const char* file, const char* database) { return replayer.start(file, database); }
+      std::string replayReport()                               { return replayer.getReport(); }
+
       //***************************************************************************
       // Ignore Channel
       //   - includes the NOEPG feature - so we don't need the noepg plugin
@@ -918,15 +1137,13 @@ class cEpg2VdrEpgHandler : public cEpgHandler
          // IgnoreChannel ist der erste Anlaufpunkt des EIT handlers,
          // wird hier ignoriert bricht die Verarbeitung des Kanals direkt ab
 
-         tChannelID tmp = Channel->GetChannelID();
-
-         if (externIdMap.size() < 1)
+         if (!channelMap.size())
             return true;
 
          // Kanäle welche nicht in der map konfiguriert sind (na) werden nicht in der DB verwaltet
          // abhängig von blacklist durchgelassen oder ignoriert
 
-         if (getExternalIdOfChannel(&tmp) == "")
+         if (!channelMap.mappingOf(Channel->GetChannelID()))
             return Epg2VdrConfig.blacklist;
 
          // ingnore - wenn nicht aktiv
@@ -936,6 +1153,9 @@ class cEpg2VdrEpgHandler : public cEpgHandler
 
          // Handler check - only to check if the DB connection is fine
 
+         if (recorder.isActive())
+            recorder.ignoreChannel(Channel);
+
          if (getHandler()->IgnoreChannel(Channel))
             return true;
 
@@ -944,29 +1164,36 @@ class cEpg2VdrEpgHandler : public cEpgHandler
 
       virtual bool HandledExternally(const cChannel* Channel)
       {
+         if (recorder.isActive())
+            recorder.handledExternally(Channel);
+
          return getHandler()->HandledExternally(Channel);
       }
 
       virtual bool BeginSegmentTransfer(const cChannel *Channel, bool dummy)
       {
-         // solange die Datenbank mit einem anderen handler thread
-         // beschäftigt ist (ergo wir den lock nicht bekommen) erst mal ignorieren
+         // the segments of different channels are handled concurrently,
+         //   the instance locks the channel
 
-         if (!handlerMutex.tryLock())
-            return false;
+         if (recorder.isActive())
+            recorder.begin(Channel, dummy);
 
          return getHandler()->BeginSegmentTransfer(Channel, dummy);
       }
 
       virtual bool EndSegmentTransfer(bool Modified, bool dummy)
       {
-         handlerMutex.unlock();
+         if (recorder.isActive())
+            recorder.end(Modified, dummy);
+
          getHandler()->EndSegmentTransfer(Modified, dummy);
          return false;
       }
 
       virtual bool IsUpdate(tEventID EventID, time_t StartTime, uchar TableID, uchar Version)
       {
+         if (recorder.isActive())
+            recorder.isUpdate(EventID, StartTime, TableID, Version);
 
          cEpgHandlerInstance* h = getHandler();
          return h->IsUpdate(EventID, StartTime, TableID, Version);
@@ -974,6 +1201,9 @@ class cEpg2VdrEpgHandler : public cEpgHandler
 
       virtual bool HandleEvent(cEvent* event)
       {
+         if (recorder.isActive())
+            recorder.handleEvent(event);
+
          cEpgHandlerInstance* h = getHandler();
          return h->HandleEvent(event);
       }
@@ -981,6 +1211,9 @@ class cEpg2VdrEpgHandler : public cEpgHandler
       virtual bool DropOutdated(cSchedule* Schedule, time_t SegmentStart,
                                 time_t SegmentEnd, uchar TableID, uchar Version)
       {
+         if (recorder.isActive())
+            recorder.dropOutdated(SegmentStart, SegmentEnd, TableID, Version);
+
          cEpgHandlerInstance* h = getHandler();
          return h->DropOutdated(Schedule, SegmentStart, SegmentEnd, TableID, Version);
       }
@@ -1011,13 +1244,12 @@ class cEpg2VdrEpgHandler : public cEpgHandler
             return fail;
          }
 
+         std::map<std::string,std::string> ids;
+
          // channel lock scope
          {
             GET_CHANNELS_READ(channels);
 
-            cMutexLock lock(&mapMutex);
-            externIdMap.clear();
-
             for (int f = selectAll->find(); f; f = selectAll->fetch())
             {
                std::string extid = mapDb->getStrValue("ExternalId");
@@ -1055,12 +1287,16 @@ class cEpg2VdrEpgHandler : public cEpgHandler
 
                // insert into map
 
-               externIdMap[strChannelId] = extid;
+               ids[strChannelId] = extid;
             }
          }
 
+         // publish the new snapshot, the EIT threads read it without lock
+
+         channelMap.publish(ids);
+
          tell(1, "Handler: Finished reading external id's from db, got %d id's",
-              (int)externIdMap.size());
+              (int)channelMap.size());
 
          selectAll->freeResult();
          delete selectAll;
@@ -1078,39 +1314,24 @@ class cEpg2VdrEpgHandler : public cEpgHandler
 
    private:
 
-      std::string getExternalIdOfChannel(tChannelID* channelId)
-      {
-         char* id = 0;
-         std::string extid = "";
-
-         cMutexLock lock(&mapMutex);
-
-         if (externIdMap.size() < 1)
-            return "";
-
-         id = strdup(channelId->ToString());
-
-         if (externIdMap.find(id) != externIdMap.end())
-            extid = externIdMap[id];
-
-         free(id);
-
-         return extid;
-      }
-
       cEpgHandlerInstance* getHandler()
       {
+         cMutexLock lock(&instanceMutex);
+
          if (handler.find(cThread::ThreadId()) == handler.end())
-            handler[cThread::ThreadId()] = new cEpgHandlerInstance();
+            handler[cThread::ThreadId()] = new cEpgHandlerInstance(&handlerDb, &writer);
 
          return handler[cThread::ThreadId()];
       }
 
-      std::map<std::string,std::string> externIdMap;
+      cChannelMap channelMap;              // external ids of the channels (merge <= 1)
       std::map<tThreadId,cEpgHandlerInstance*> handler;
       int active {false};
-      cMutex mapMutex;
-      cMutexTry handlerMutex;
+      cMutex instanceMutex;
+      cEpgHandlerDb handlerDb;             // connection and event index, shared by the instances
+      cEpgWriter writer;
+      cEitRecorder recorder;
+      cEitReplay replayer;
 
       static cEpg2VdrEpgHandler* singleton;
 };
@@ -9,6 +9,7 @@
 #include <errmsg.h>
 
 #include <map>
+#include <algorithm>
 
 #include "db.h"
 
@@ -84,6 +85,8 @@ cDbStatement::cDbStatement(cDbTable* aTable)
    bindPrefix = 0;
    firstExec = yes;
    buildErrors = 0;
+   streaming = no;
+   prefetchRows = 0;
 
    callsPeriod = 0;
    callsTotal = 0;
@@ -112,6 +115,8 @@ cDbStatement::cDbStatement(cDbConnection* aConnection, const char* sText)
    callsTotal = 0;
    duration = 0;
    buildErrors = 0;
+   streaming = no;
+   prefetchRows = 0;
 
    if (connection)
       connection->statements.append(this);
@@ -130,45 +135,52 @@ cDbStatement::~cDbStatement()
 //***************************************************************************
 
 int cDbStatement::execute(int noResult)
+{
+   double start = usNow();
+   int status = executeStatement(noResult);
+
+   // retry once on a lost connection, but not inside a transaction and not
+   //   while a other statement is iterating a result (it's lost by the reconnect)
+
+   if (status != success && connection && connection->isDropped() &&
+       !connection->inTransaction() && !connection->statements.openResults(this) &&
+       connection->reconnect() == success)
+   {
+      tell(1, "Retrying statement [%s] after reconnect", stmtTxt.c_str());
+      status = executeStatement(noResult);
+   }
+
+   double us = usNow() - start;
+
+   if (statistic && cDbStatistic::record(statistic, us, streaming ? 0 : affected, status != success))
+      captureSlow(us / 1000);
+
+   return status;
+}
+
+int cDbStatement::executeStatement(int noResult)
 {
    affected = 0;
+   rowsLeft = 0;
+   invalidated = no;
+   fetchError = no;
 
    if (!connection || !connection->getMySql())
       return fail;
 
+   if (!stmt && prepared && prepareStatement() != success)   // lazy prepare
+      return fail;
+
    if (!stmt)
       return connection->errorSql(connection, "execute(missing statement)");
 
-//    if (explain && firstExec)
-//    {
-//       firstExec = no;
-
-//       if (strstr(stmtTxt.c_str(), "select "))
-//       {
-//          MYSQL_RES* result;
-//          MYSQL_ROW row;
-//          string q = "explain " + stmtTxt;
-
-//          if (connection->query(q.c_str()) != success)
-//             connection->errorSql(connection, "explain ", 0);
-//          else if ((result = mysql_store_result(connection->getMySql())))
-//          {
-//             while ((row = mysql_fetch_row(result)))
-//             {
-//                tell(0, "EXPLAIN: %s) %s %s %s %s %s %s %s %s %s",
-//                     row[0], row[1], row[2], row[3],
-//                     row[4], row[5], row[6], row[7], row[8], row[9]);
-//             }
-
-//             mysql_free_result(result);
-//          }
-//       }
-//    }
-
    // tell(0, "execute %d [%s]", stmt, stmtTxt.c_str());
 
    double start = usNow();
 
+   if (updateBindings(inBind, inValues) && mysql_stmt_bind_param(stmt, inBind))
+      return connection->errorSql(connection, "execute(bind_param)", stmt, stmtTxt.c_str());
+
    if (mysql_stmt_execute(stmt))
       return connection->errorSql(connection, "execute(stmt_execute)", stmt, stmtTxt.c_str());
 
@@ -176,6 +188,19 @@ int cDbStatement::execute(int noResult)
    callsPeriod++;
    callsTotal++;
 
+   // streaming - the rows are fetched from the server side cursor
+   //   while iterating, we only know if there is a first row
+
+   if (outCount && streaming)
+   {
+      if (noResult)
+         mysql_stmt_free_result(stmt);
+      else
+         affected = rowsLeft = fetchRow() == 0 ? 1 : 0;   // the cursor is open until the end
+
+      return success;
+   }
+
    // out binding - if needed
 
    if (outCount && !noResult)
@@ -186,7 +211,10 @@ int cDbStatement::execute(int noResult)
       // fetch the first result - if any
 
       if (mysql_stmt_affected_rows(stmt) > 0)
-         mysql_stmt_fetch(stmt);
+      {
+         fetchRow();
+         rowsLeft = mysql_stmt_affected_rows(stmt) - 1;
+      }
    }
    else if (outCount)
    {
@@ -239,20 +267,129 @@ int cDbStatement::find()
 
 int cDbStatement::fetch()
 {
-   if (!mysql_stmt_fetch(stmt))
+   if (!fetchRow())
       return yes;
 
    return no;
 }
 
+//***************************************************************************
+// Fetch Row
+//  - the string buffers of the values grow on demand (see cDbValue::reserve),
+//    the bindings are updated before the fetch if a buffer was moved and
+//    values which don't fit are fetched again after growing the buffer
+//***************************************************************************
+
+int cDbStatement::fetchRow()
+{
+   int res;
+
+   if (!stmt || invalidated)
+   {
+      if (invalidated)
+         tell(0, "Error: Result of statement [%s] was lost by a reconnect", stmtTxt.c_str());
+
+      fetchError = yes;
+      return 1;
+   }
+
+   if (updateBindings(outBind, outValues) && mysql_stmt_bind_result(stmt, outBind))
+   {
+      connection->errorSql(connection, "fetch(bind_result)", stmt, stmtTxt.c_str());
+      fetchError = yes;
+      return 1;
+   }
+
+   if ((res = mysql_stmt_fetch(stmt)) == MYSQL_DATA_TRUNCATED)
+      res = fetchTruncated();
+
+   fetchError = res != 0 && res != MYSQL_NO_DATA;
+
+   if (res == 0 && streaming)
+      streamedRows++;
+   else if (res == 0 && rowsLeft > 0)
+      rowsLeft--;
+   else if (res != 0)
+      rowsLeft = 0;
+
+   return res;
+}
+
+int cDbStatement::fetchTruncated()
+{
+   for (int i = 0; i < outCount; i++)
+   {
+      cDbValue* value = outValues[i];
+
+      if (!value->isStrFormat() || value->isNull())
+         continue;
+
+      if (value->getStrValueSize() > outBind[i].buffer_length)
+      {
+         // length is set to the real size of the column by mysql
+
+         MYSQL_BIND bind = outBind[i];
+
+         value->reserve(std::min(value->getStrValueSize(), (unsigned long)value->getField()->getSize()));
+
+         bind.buffer = value->getStrValueRef();
+         bind.buffer_length = value->getStrCapacity();
+
+         if (mysql_stmt_fetch_column(stmt, &bind, i, 0))
+         {
+            connection->errorSql(connection, "fetch(fetch_column)", stmt, stmtTxt.c_str());
+            return MYSQL_DATA_TRUNCATED;
+         }
+      }
+
+      value->fitStrValue();
+   }
+
+   return 0;
+}
+
+//***************************************************************************
+// Update Bindings
+//***************************************************************************
+
+int cDbStatement::updateBindings(MYSQL_BIND* bindings, std::vector<cDbValue*>& values)
+{
+   int changed = no;
+
+   for (size_t i = 0; i < values.size(); i++)
+   {
+      cDbValue* value = values[i];
+
+      if (!value->isStrFormat())
+         continue;
+
+      if (bindings[i].buffer != value->getStrValueRef() || bindings[i].buffer_length != value->getStrCapacity())
+      {
+         bindings[i].buffer = value->getStrValueRef();
+         bindings[i].buffer_length = value->getStrCapacity();
+         changed = yes;
+      }
+   }
+
+   return changed;
+}
+
 int cDbStatement::freeResult()
 {
+   if (statistic && streamedRows)
+   {
+      cDbStatistic::addRows(statistic, streamedRows);
+      streamedRows = 0;
+   }
+
    if (metaResult)
       mysql_free_result(metaResult);
 
    if (stmt)
       mysql_stmt_free_result(stmt);
 
+   rowsLeft = 0;
+
    return success;
 }
 
@@ -499,6 +636,10 @@ void cDbStatement::clear()
       outBind = 0;
    }
 
+   inValues.clear();
+   outValues.clear();
+   prepared = no;
+
    if (stmt)
    {
       mysql_stmt_free_result(stmt);
@@ -507,6 +648,37 @@ void cDbStatement::clear()
    }
 }
 
+//***************************************************************************
+// Reprepare
+//  - the handle of the old connection is invalid, prepare the statement
+//    text with the existing bindings on the new connection
+//  - a statement with a pending result is invalidated, fetch() fails
+//    (fetchFailed()) instead of reporting the end of the data
+//***************************************************************************
+
+int cDbStatement::reprepare()
+{
+   // a result still iterated by the caller is gone, let it's next fetch fail
+
+   invalidated = rowsLeft > 0;
+   rowsLeft = 0;
+
+   if (stmt)
+   {
+      mysql_stmt_close(stmt);
+      stmt = 0;
+   }
+
+   if (!prepared)
+      return success;
+
+   prepared = no;
+   affected = 0;
+   streamedRows = 0;
+
+   return prepare();
+}
+
 //***************************************************************************
 // Append Binding
 //***************************************************************************
@@ -521,11 +693,13 @@ int cDbStatement::appendBinding(cDbValue* value, BindType bt)
    {
       count = ++inCount;
       bindings = &inBind;
+      inValues.push_back(value);
    }
    else if (bt & bndOut)
    {
       count = ++outCount;
       bindings = &outBind;
+      outValues.push_back(value);
    }
    else
       return 0;
@@ -543,7 +717,7 @@ int cDbStatement::appendBinding(cDbValue* value, BindType bt)
    {
       newBinding->buffer_type = MYSQL_TYPE_STRING;
       newBinding->buffer = value->getStrValueRef();
-      newBinding->buffer_length = value->getField()->getSize();
+      newBinding->buffer_length = value->getStrCapacity();
       newBinding->length = value->getStrValueSizeRef();
 
       newBinding->is_null = value->getNullRef();
@@ -553,7 +727,7 @@ int cDbStatement::appendBinding(cDbValue* value, BindType bt)
    {
       newBinding->buffer_type = MYSQL_TYPE_BLOB;
       newBinding->buffer = value->getStrValueRef();
-      newBinding->buffer_length = value->getField()->getSize();
+      newBinding->buffer_length = value->getStrCapacity();
       newBinding->length = value->getStrValueSizeRef();
 
       newBinding->is_null = value->getNullRef();
@@ -605,26 +779,57 @@ int cDbStatement::appendBinding(cDbValue* value, BindType bt)
 // Prepare Statement
 //***************************************************************************
 
+//***************************************************************************
+// Prepare
+//  - with lazyPrepare statements of tables with a verified schema (see
+//    cDbTable::init) are prepared on their first execute, this saves a round
+//    trip per statement but prepare errors don't show up in the status of
+//    prepare(), therefore it's off by default (setup.conf LazyPrepare)
+//***************************************************************************
+
+int cDbStatement::lazyPrepare = no;
+
 int cDbStatement::prepare()
 {
-   if (!connection->getMySql())
-   {
-      tell(0, "Error: Lost connection, can't prepare statement");
-      return fail;
-   }
-
    if (!stmtTxt.length())
       return fail;
 
    if (buildErrors)
       return fail;
 
+   if (lazyPrepare && table && table->isSchemaVerified())
+   {
+      statistic = cDbStatistic::get(stmtTxt.c_str());
+      prepared = yes;
+
+      tell(3, "Statement '%s' will be prepared on first use", stmtTxt.c_str());
+
+      return success;
+   }
+
+   return prepareStatement();
+}
+
+int cDbStatement::prepareStatement()
+{
+   if (!connection->getMySql())
+   {
+      tell(0, "Error: Lost connection, can't prepare statement");
+      return fail;
+   }
+
    stmt = mysql_stmt_init(connection->getMySql());
 
    // prepare statement
 
    if (mysql_stmt_prepare(stmt, stmtTxt.c_str(), stmtTxt.length()))
-      return connection->errorSql(connection, "prepare(stmt_prepare)", stmt, stmtTxt.c_str());
+   {
+      connection->errorSql(connection, "prepare(stmt_prepare)", stmt, stmtTxt.c_str());
+      mysql_stmt_close(stmt);
+      stmt = 0;
+
+      return fail;
+   }
 
    if (outBind)
    {
@@ -638,8 +843,49 @@ int cDbStatement::prepare()
          return connection->errorSql(connection, "buildPrimarySelect(bind_param)", stmt);
    }
 
-   tell(2, "Statement '%s' with (%ld) in parameters and (%d) out bindings prepared",
-        stmtTxt.c_str(), mysql_stmt_param_count(stmt), outCount);
+   if (streaming && applyCursorType() != success)
+      return fail;
+
+   statistic = cDbStatistic::get(stmtTxt.c_str());
+   prepared = yes;
+
+   tell(2, "Statement '%s' with (%ld) in parameters and (%d) out bindings prepared%s",
+        stmtTxt.c_str(), mysql_stmt_param_count(stmt), outCount,
+        streaming ? " (streaming)" : "");
+
+   return success;
+}
+
+//***************************************************************************
+// Streaming
+//  - for large scans, the rows are fetched via a read only server side
+//    cursor in blocks of 'prefetch' rows while iterating instead of
+//    storing the whole result on client side first.
+//  - other statements of the connection can be executed while iterating
+//  - since the result isn't stored getAffected() only reports
+//    if a first row was found (0/1), getResultCount() is not supported
+//  - can be switched before each execute
+//***************************************************************************
+
+int cDbStatement::setStreaming(int on, int prefetch)
+{
+   streaming = on;
+   prefetchRows = prefetch > 0 ? prefetch : 1;
+
+   if (!stmt)
+      return success;             // applied by prepare()
+
+   return applyCursorType();
+}
+
+int cDbStatement::applyCursorType()
+{
+   unsigned long type = streaming ? CURSOR_TYPE_READ_ONLY : CURSOR_TYPE_NO_CURSOR;
+   unsigned long rows = streaming ? prefetchRows : 1;
+
+   if (mysql_stmt_attr_set(stmt, STMT_ATTR_CURSOR_TYPE, &type) ||
+       mysql_stmt_attr_set(stmt, STMT_ATTR_PREFETCH_ROWS, &rows))
+      return connection->errorSql(connection, "setStreaming(attr_set)", stmt, stmtTxt.c_str());
 
    return success;
 }
@@ -661,144 +907,522 @@ void cDbStatement::showStat()
 }
 
 //***************************************************************************
-// cDbConnection statics
+// Capture Slow
+//  - record the statement with the bound values and the EXPLAIN output,
+//    the values are filled into the text since EXPLAIN can't handle
+//    the placeholders
 //***************************************************************************
 
-char* cDbConnection::confPath = 0;
-char* cDbConnection::encoding = 0;
-char* cDbConnection::dbHost = strdup("localhost");
-int   cDbConnection::dbPort = 3306;
-char* cDbConnection::dbUser = 0;
-char* cDbConnection::dbPass = 0;
-char* cDbConnection::dbName = 0;
-int   cDbConnection::initThreads = 0;
-cMyMutex cDbConnection::initMutex;
+static std::string sqlValue(MYSQL* mysql, cDbValue* value)
+{
+   char buf[100];
 
-//***************************************************************************
-// Class cDbTable
-//***************************************************************************
+   if (value->isNull())
+      return "NULL";
 
-//***************************************************************************
-// Object
-//***************************************************************************
+   switch (value->getField()->getFormat())
+   {
+      case cDBS::ffInt:
+      case cDBS::ffUInt:
+         snprintf(buf, sizeof(buf), "%ld", value->getIntValue());
+         return buf;
 
-cDbTable::cDbTable(cDbConnection* aConnection, const char* name)
-{
-   connection = aConnection;
-   holdInMemory = no;
-   attached = no;
+      case cDBS::ffBigInt:
+      case cDBS::ffUBigInt:
+         snprintf(buf, sizeof(buf), "%lld", (long long)value->getBigintValue());
+         return buf;
 
-   row = 0;
-   stmtSelect = 0;
-   stmtInsert = 0;
-   stmtUpdate = 0;
-   lastInsertId = na;
+      case cDBS::ffFloat:
+         snprintf(buf, sizeof(buf), "%f", value->getFloatValue());
+         return buf;
 
-   tableDef = dbDict.getTable(name);
+      case cDBS::ffDateTime:
+      {
+         struct tm tm;
+         time_t t = value->getTimeValue();
 
-   if (tableDef)
-      row = new cDbRow(tableDef);
-   else
-      tell(0, "Fatal: Table '%s' missing in dictionary '%s'!", name, dbDict.getPath());
-}
+         strftime(buf, sizeof(buf), "'%Y-%m-%d %H:%M:%S'", localtime_r(&t, &tm));
+         return buf;
+      }
 
-cDbTable::~cDbTable()
-{
-   close();
+      default:
+      {
+         unsigned long len = std::min(value->getStrValueSize(), 200UL);   // enough for EXPLAIN
+         char* escaped = (char*)malloc(2*len+1);
+         std::string str;
 
-   delete row;
-}
+         mysql_real_escape_string(mysql, escaped, value->getStrValue(), len);
+         str = "'" + std::string(escaped) + "'";
+         free(escaped);
 
-//***************************************************************************
-// Open / Close
-//***************************************************************************
+         return str;
+      }
+   }
+}
 
-int cDbTable::open(int allowAlter)
+void cDbStatement::captureSlow(double ms)
 {
-   if (!tableDef || !row)
-      return abrt;
+   cDbStatistic::SlowQuery query;
+   MYSQL* mysql = connection->getMySql();
+   std::string text;
+   size_t v = 0;
 
-   if (attach() != success)
+   query.time = time(0);
+   query.ms = ms;
+   query.text = stmtTxt;
+
+   if (!mysql)
+      return;
+
+   for (const char* p = stmtTxt.c_str(); *p; p++)
    {
-      tell(0, "Could not access database '%s:%d' (tried to open %s)",
-           connection->getHost(), connection->getPort(), TableName());
+      if (*p != '?' || v >= inValues.size())
+      {
+         text += *p;
+         continue;
+      }
 
-      return fail;
+      std::string value = sqlValue(mysql, inValues[v]);
+
+      query.params += std::string(v ? ", " : "") + inValues[v]->getField()->getName() + "=" + value;
+      text += value;
+      v++;
    }
 
-   return init(allowAlter);
-}
+   // EXPLAIN only for select, update and delete
 
-int cDbTable::close()
-{
-   if (stmtSelect) { delete stmtSelect; stmtSelect = 0; }
-   if (stmtInsert) { delete stmtInsert; stmtInsert = 0; }
-   if (stmtUpdate) { delete stmtUpdate; stmtUpdate = 0; }
+   const char* p = stmtTxt.c_str();
 
-   detach();
+   while (isspace(*p))
+      p++;
 
-   return success;
-}
+   if (strncasecmp(p, "select", 6) == 0 || strncasecmp(p, "update", 6) == 0 || strncasecmp(p, "delete", 6) == 0)
+   {
+      MYSQL_RES* result;
+      MYSQL_ROW row;
 
-//***************************************************************************
-// Attach / Detach
-//***************************************************************************
+      if (mysql_query(mysql, ("explain " + text).c_str()) != 0)
+         query.explain = std::string("explain failed: ") + mysql_error(mysql);
 
-int cDbTable::attach()
-{
-   if (isAttached())
-      return success;
+      else if ((result = mysql_store_result(mysql)))
+      {
+         unsigned int count = mysql_num_fields(result);
 
-   if (connection->attachConnection() != success)
-   {
-      tell(0, "Could not access database '%s:%d'",
-           connection->getHost(), connection->getPort());
+         while ((row = mysql_fetch_row(result)))
+         {
+            for (unsigned int i = 0; i < count; i++)
+               query.explain += std::string(i ? " | " : "      ") + (row[i] ? row[i] : "NULL");
 
-      return fail;
+            query.explain += "\n";
+         }
+
+         mysql_free_result(result);
+      }
    }
 
-   attached = yes;
+   tell(0, "Slow statement (%.2f ms) [%s] with (%s)", ms, stmtTxt.c_str(), query.params.c_str());
 
-   return success;
+   cDbStatistic::addSlow(query);
 }
 
-int cDbTable::detach()
+//***************************************************************************
+// Class cDbStatementStat
+//***************************************************************************
+
+double cDbStatementStat::percentile(double p)
 {
-   if (isAttached())
+   unsigned long count = 0;
+   unsigned long limit = calls * p;
+
+   if (!calls)
+      return 0;
+
+   for (int i = 0; i < bucketCount; i++)
    {
-      connection->detachConnection();
-      attached = no;
+      count += buckets[i];
+
+      if (count > limit || count == calls)
+         return std::min((double)(1UL << (i+1)), max) / 1000;
    }
 
-   return success;
+   return max / 1000;
 }
 
 //***************************************************************************
-// Init
+// Class cDbStatistic
 //***************************************************************************
 
-int cDbTable::init(int allowAlter)
+int cDbStatistic::slowThreshold = 0;
+cMyMutex cDbStatistic::mutex;
+std::map<std::string,cDbStatementStat*> cDbStatistic::stats;
+std::list<cDbStatistic::SlowQuery> cDbStatistic::slowQueries;
+
+cDbStatementStat* cDbStatistic::get(const char* text)
 {
-   std::string str;
-   std::map<std::string, cDbFieldDef*>::iterator f;
-   int n = 0;
+   cDbStatementStat* stat;
 
-   if (!isConnected())
+   mutex.Lock();
+
+   auto it = stats.find(text);
+
+   if (it != stats.end())
+      stat = it->second;
+   else
+      stat = stats[text] = new cDbStatementStat(text);
+
+   mutex.Unlock();
+
+   return stat;
+}
+
+//***************************************************************************
+// Record
+//  - returns yes if the statement was slow and should be captured
+//***************************************************************************
+
+int cDbStatistic::record(cDbStatementStat* stat, double us, long rows, int error)
+{
+   int bucket = 0;
+   int capture = no;
+
+   while (bucket < cDbStatementStat::bucketCount-1 && (double)(1UL << (bucket+1)) <= us)
+      bucket++;
+
+   mutex.Lock();
+
+   stat->calls++;
+   stat->rows += rows;
+   stat->total += us;
+   stat->max = std::max(stat->max, us);
+   stat->buckets[bucket]++;
+
+   if (error)
+      stat->errors++;
+
+   if (!error && slowThreshold > 0 && us >= slowThreshold * 1000.0 && time(0) >= stat->lastSlowAt + slowInterval)
+   {
+      stat->lastSlowAt = time(0);
+      capture = yes;
+   }
+
+   mutex.Unlock();
+
+   return capture;
+}
+
+void cDbStatistic::addRows(cDbStatementStat* stat, long rows)
+{
+   mutex.Lock();
+   stat->rows += rows;
+   mutex.Unlock();
+}
+
+void cDbStatistic::addSlow(const SlowQuery& query)
+{
+   mutex.Lock();
+
+   slowQueries.push_front(query);
+
+   if (slowQueries.size() > maxSlowQueries)
+      slowQueries.pop_back();
+
+   mutex.Unlock();
+}
+
+//***************************************************************************
+// Reset
+//  - the stat objects are referenced by the statements, only clear them
+//***************************************************************************
+
+void cDbStatistic::reset()
+{
+   mutex.Lock();
+
+   for (auto it = stats.begin(); it != stats.end(); it++)
+   {
+      cDbStatementStat* stat = it->second;
+
+      stat->calls = stat->errors = stat->rows = 0;
+      stat->total = stat->max = 0;
+      stat->lastSlowAt = 0;
+      memset(stat->buckets, 0, sizeof(stat->buckets));
+   }
+
+   slowQueries.clear();
+
+   mutex.Unlock();
+}
+
+unsigned long cDbStatistic::totalCalls()
+{
+   unsigned long calls = 0;
+
+   mutex.Lock();
+
+   for (auto it = stats.begin(); it != stats.end(); it++)
+      calls += it->second->calls;
+
+   mutex.Unlock();
+
+   return calls;
+}
+
+//***************************************************************************
+// Report
+//  - the top statements by total time
+//***************************************************************************
+
+std::string cDbStatistic::report(int top)
+{
+   std::vector<cDbStatementStat*> list;
+   std::string out;
+   char buf[300];
+
+   mutex.Lock();
+
+   for (auto it = stats.begin(); it != stats.end(); it++)
+   {
+      if (it->second->calls)
+         list.push_back(it->second);
+   }
+
+   std::sort(list.begin(), list.end(), [](cDbStatementStat* a, cDbStatementStat* b) { return a->total > b->total; });
+
+   snprintf(buf, sizeof(buf), "%8s %9s %5s %9s %8s %8s %8s %9s  %s",
+            "calls", "rows", "err", "total[s]", "p50[ms]", "p95[ms]", "p99[ms]", "max[ms]", "statement");
+   out += buf;
+
+   for (int i = 0; i < (int)list.size() && i < top; i++)
+   {
+      cDbStatementStat* stat = list[i];
+
+      snprintf(buf, sizeof(buf), "\n%8lu %9lu %5lu %9.2f %8.2f %8.2f %8.2f %9.2f  %.120s",
+               stat->calls, stat->rows, stat->errors, stat->total / 1000000,
+               stat->percentile(0.50), stat->percentile(0.95), stat->percentile(0.99),
+               stat->max / 1000, stat->text.c_str());
+      out += buf;
+   }
+
+   snprintf(buf, sizeof(buf), "\n%d of %d statements, slow query capture %s",
+            std::min(top, (int)list.size()), (int)list.size(),
+            slowThreshold > 0 ? ("at " + std::to_string(slowThreshold) + " ms").c_str() : "off");
+   out += buf;
+
+   mutex.Unlock();
+
+   return out;
+}
+
+std::string cDbStatistic::reportSlow()
+{
+   std::string out;
+   char stamp[50];
+   char buf[100];
+
+   mutex.Lock();
+
+   for (auto it = slowQueries.begin(); it != slowQueries.end(); it++)
+   {
+      struct tm tm;
+
+      strftime(stamp, sizeof(stamp), "%d.%m.%y %H:%M:%S", localtime_r(&it->time, &tm));
+      snprintf(buf, sizeof(buf), "%s%s took %.2f ms\n", out.empty() ? "" : "\n", stamp, it->ms);
+
+      out += buf;
+      out += "   " + it->text + "\n";
+
+      if (!it->params.empty())
+         out += "   values: " + it->params + "\n";
+
+      if (!it->explain.empty())
+         out += "   explain:\n" + it->explain;
+   }
+
+   while (!out.empty() && out.back() == '\n')
+      out.pop_back();
+
+   if (out.empty())
+      out = "No slow statements captured";
+
+   mutex.Unlock();
+
+   return out;
+}
+
+//***************************************************************************
+// cDbConnection statics
+//***************************************************************************
+
+char* cDbConnection::confPath = 0;
+char* cDbConnection::schemaOwner = strdup("schema");
+char* cDbConnection::encoding = 0;
+char* cDbConnection::dbHost = strdup("localhost");
+int   cDbConnection::dbPort = 3306;
+char* cDbConnection::dbUser = 0;
+char* cDbConnection::dbPass = 0;
+char* cDbConnection::dbName = 0;
+int   cDbConnection::initThreads = 0;
+cMyMutex cDbConnection::initMutex;
+
+//***************************************************************************
+// Class cDbTable
+//***************************************************************************
+
+//***************************************************************************
+// Object
+//***************************************************************************
+
+cDbTable::cDbTable(cDbConnection* aConnection, const char* name)
+{
+   connection = aConnection;
+   holdInMemory = no;
+   attached = no;
+
+   row = 0;
+   stmtSelect = 0;
+   stmtInsert = 0;
+   stmtUpdate = 0;
+   lastInsertId = na;
+
+   tableDef = dbDict.getTable(name);
+
+   if (tableDef)
+   {
+      row = new cDbRow(tableDef);
+      holdInMemory = tableDef->isHoldInMemory();
+   }
+   else
+      tell(0, "Fatal: Table '%s' missing in dictionary '%s'!", name, dbDict.getPath());
+}
+
+cDbTable::~cDbTable()
+{
+   close();
+
+   delete row;
+}
+
+//***************************************************************************
+// Open / Close
+//***************************************************************************
+
+int cDbTable::open(int allowAlter)
+{
+   if (!tableDef || !row)
+      return abrt;
+
+   if (attach() != success)
+   {
+      tell(0, "Could not access database '%s:%d' (tried to open %s)",
+           connection->getHost(), connection->getPort(), TableName());
+
+      return fail;
+   }
+
+   return init(allowAlter);
+}
+
+int cDbTable::close()
+{
+   if (stmtSelect) { delete stmtSelect; stmtSelect = 0; }
+   if (stmtInsert) { delete stmtInsert; stmtInsert = 0; }
+   if (stmtUpdate) { delete stmtUpdate; stmtUpdate = 0; }
+
+   for (auto it = updateStatements.begin(); it != updateStatements.end(); it++)
+      delete it->second;
+
+   updateStatements.clear();
+
+   resetBy();
+   memClear();
+
+   for (auto it = byStatements.begin(); it != byStatements.end(); it++)
+      delete it->second;
+
+   byStatements.clear();
+
+   delete stmtSelectAll;  stmtSelectAll = 0;
+   delete memLoadRow;     memLoadRow = 0;
+
+   detach();
+
+   return success;
+}
+
+//***************************************************************************
+// Attach / Detach
+//***************************************************************************
+
+int cDbTable::attach()
+{
+   if (isAttached())
+      return success;
+
+   if (connection->attachConnection() != success)
+   {
+      tell(0, "Could not access database '%s:%d'",
+           connection->getHost(), connection->getPort());
+
+      return fail;
+   }
+
+   attached = yes;
+
+   return success;
+}
+
+int cDbTable::detach()
+{
+   if (isAttached())
+   {
+      connection->detachConnection();
+      attached = no;
+   }
+
+   return success;
+}
+
+//***************************************************************************
+// Init
+//***************************************************************************
+
+int cDbTable::init(int allowAlter)
+{
+   std::string str;
+   std::map<std::string, cDbFieldDef*>::iterator f;
+   int n = 0;
+
+   if (!isConnected())
       return fail;
 
    // check/create table ...
+   //  - skipped as long as the fingerprint stored for the table matches
+   //    the dictionary
+
+   const char* fingerprint = connection->getSchemaFingerprint(TableName());
+   schemaVerified = fingerprint && strcmp(fingerprint, tableDef->getFingerprint()) == 0;
 
-   if (allowAlter)
+   if (allowAlter && !schemaVerified)
    {
+      int status = success;
+
       if (exist())
-         validateStructure(allowAlter);
+         status += validateStructure(allowAlter);
 
       if (!exist() && createTable() != success)
          return fail;
 
       // check/create indices
 
-      createIndices();
+      status += createIndices();
+
+      if (status == success &&
+          connection->setSchemaFingerprint(TableName(), tableDef->getFingerprint()) == success)
+         schemaVerified = yes;
+   }
+   else if (allowAlter)
+   {
+      tell(2, "Structure of '%s' unchanged (%s), skipping validation", TableName(), fingerprint);
    }
 
    // ------------------------------
@@ -897,6 +1521,40 @@ int cDbTable::init(int allowAlter)
    if (stmtUpdate->prepare() != success)
       return fail;
 
+   // -----------------------------------------
+   // fields of the in memory mirror
+
+   primaryFields.clear();
+   updspField = 0;
+
+   for (int i = 0; i < fieldCount(); i++)
+   {
+      if (getField(i)->getType() & ftPrimary)
+         primaryFields.push_back(getField(i));
+      else if (strcasecmp(getField(i)->getName(), "updsp") == 0)
+         updspField = getField(i);
+   }
+
+   // -----------------------------------------
+   // select all, bound to a row of it's own to keep
+   //   the row of the table untouched while (re)loading
+
+   if (holdInMemory)
+   {
+      memLoadRow = new cDbRow(tableDef);
+      stmtSelectAll = new cDbStatement(this);
+
+      stmtSelectAll->build("select ");
+
+      for (int i = 0; i < fieldCount(); i++)
+         stmtSelectAll->bind(memLoadRow->getValue(getField(i)), bndOut, i ? ", " : "");
+
+      stmtSelectAll->build(" from %s;", TableName());
+
+      if (stmtSelectAll->prepare() != success)
+         return fail;
+   }
+
    return success;
 }
 
@@ -957,7 +1615,7 @@ int cDbTable::validateStructure(int allowAlter)
    // ------------------------
    // execute query
 
-   if (connection->query(select, TableName(), connection->getName()) != success)
+   if (connection->query(select, TableName(), connection->database()) != success)
    {
       connection->errorSql(getConnection(), "validateStructure()", 0);
       if (needDetach) detach();
@@ -1361,23 +2019,173 @@ int cDbTable::checkIndex(const char* idxName, int& fieldCount)
 }
 
 //***************************************************************************
-// SQL Error
+// Connect
 //***************************************************************************
 
-int cDbConnection::errorSql(cDbConnection* connection, const char* prefix,
-                            MYSQL_STMT* stmt, const char* stmtTxt)
+int cDbConnection::connect()
 {
-   if (!connection || !connection->mysql)
+   static int first = yes;
+
+   connectDropped = yes;
+   schemaLoaded = no;
+
+   tell(2, "Calling mysql_init(%ld)", syscall(__NR_gettid));
+
+   if (!(mysql = mysql_init(0)))
+      return errorSql(this, "attachConnection(init)");
+
+   if (!mysql_real_connect(mysql, dbHost,
+                           dbUser, dbPass, database(), dbPort, 0, 0))
    {
-      tell(0, "SQL-Error in '%s'", prefix);
+      mysql_close(mysql);
+      mysql = 0;
+
+      if (!attached)
+         mysql_thread_end();
+
+      tell(0, "Error, connecting to database at '%s' on port (%d) failed",
+           dbHost, dbPort);
+
       return fail;
    }
 
-   int error = mysql_errno(connection->mysql);
-   char* conErr = 0;
-   char* stmtErr = 0;
+   connectDropped = no;
 
-   if (error == CR_SERVER_LOST ||
+   // init encoding
+
+   if (encoding && *encoding)
+   {
+      if (mysql_set_character_set(mysql, encoding))
+         errorSql(this, "init(character_set)");
+
+      if (first)
+      {
+         tell(0, "SQL client character now '%s'", mysql_character_set_name(mysql));
+         first = no;
+      }
+   }
+
+   return success;
+}
+
+//***************************************************************************
+// Schema Fingerprint
+//  - the fingerprints of all tables are stored as rows of the parameters
+//    table with the owner schemaOwner, the tables shared with epgd stay
+//    untouched (no ALTER needed) and each client keeps its own fingerprints
+//  - fetched with one query per connect, if the query fails all tables
+//    are handled as unverified
+//***************************************************************************
+
+const char* cDbConnection::getSchemaFingerprint(const char* table)
+{
+   if (!schemaLoaded)
+   {
+      MYSQL_RES* result;
+      MYSQL_ROW row;
+
+      schemaFingerprints.clear();
+      schemaLoaded = yes;
+
+      if (query("select name, value from parameters where owner = '%s'", schemaOwner) != success)
+         return 0;
+
+      if (!(result = mysql_store_result(getMySql())))
+      {
+         errorSql(this, "getSchemaFingerprint()");
+         return 0;
+      }
+
+      while ((row = mysql_fetch_row(result)))
+      {
+         if (row[0] && row[1] && strncmp(row[1], "schema:", 7) == 0)
+            schemaFingerprints[row[0]] = row[1];
+      }
+
+      mysql_free_result(result);
+   }
+
+   auto it = schemaFingerprints.find(table);
+
+   return it != schemaFingerprints.end() ? it->second.c_str() : 0;
+}
+
+int cDbConnection::setSchemaFingerprint(const char* table, const char* fingerprint)
+{
+   if (query("replace into parameters (owner, name, value, inssp, updsp) "
+             "values ('%s', '%s', '%s', unix_timestamp(), unix_timestamp())",
+             schemaOwner, table, fingerprint) != success)
+      return fail;
+
+   schemaFingerprints[table] = fingerprint;
+   tell(1, "Stored fingerprint '%s' of table '%s'", fingerprint, table);
+
+   return success;
+}
+
+//***************************************************************************
+// Reconnect
+//  - re-establish a dropped connection in place, the registered statements
+//    are prepared again so the statement and table objects of the
+//    callers stay valid
+//***************************************************************************
+
+int cDbConnection::reconnect()
+{
+   int failed;
+
+   if (!attached || time(0) < reconnectFailedAt + 5)
+      return fail;
+
+   disconnect();
+
+   tell(0, "Trying to reconnect to database at '%s:%d'", dbHost, dbPort);
+
+   if (connect() != success)
+   {
+      reconnectFailedAt = time(0);
+      return fail;
+   }
+
+   reconnectFailedAt = 0;
+
+   inTact = no;               // a open transaction is gone with the old connection
+   reconnects++;
+
+   if ((failed = statements.reprepare()))
+   {
+      tell(0, "Error: Reconnected, but %d statement(s) failed to prepare", failed);
+      connectDropped = yes;   // let the caller fall back to a complete init
+      reconnectFailedAt = time(0);
+      return fail;
+   }
+
+   tell(0, "Reconnected to database (#%d)", reconnects);
+
+   return success;
+}
+
+//***************************************************************************
+// SQL Error
+//***************************************************************************
+
+int cDbConnection::errorSql(cDbConnection* connection, const char* prefix,
+                            MYSQL_STMT* stmt, const char* stmtTxt)
+{
+   if (!connection || !connection->mysql)
+   {
+      tell(0, "SQL-Error in '%s'", prefix);
+      return fail;
+   }
+
+   int error = mysql_errno(connection->mysql);
+
+   if (!error && stmt)
+      error = mysql_stmt_errno(stmt);
+   char* conErr = 0;
+   char* stmtErr = 0;
+
+   if (error == CR_SERVER_LOST ||
        error == CR_SERVER_GONE_ERROR ||
 // for compatibility with newer versions of MariaDB library
 #ifdef CR_INVALID_CONN_HANDLE
@@ -1452,6 +2260,8 @@ int cDbTable::deleteWhere(const char* where, ...)
 
    free(tmp);
 
+   memClear();
+
    if (connection->query("%s", stmt.c_str()))
       return connection->errorSql(connection, "deleteWhere()", 0, stmt.c_str());
 
@@ -1504,6 +2314,8 @@ int cDbTable::truncate()
 
    tmp = "delete from " + std::string(TableName());
 
+   memClear();
+
    if (connection->query("%s", tmp.c_str()))
       return connection->errorSql(connection, "truncate()", 0, tmp.c_str());
 
@@ -1567,7 +2379,12 @@ int cDbTable::insert(time_t inssp)
 
    lastInsertId = stmtInsert->getLastInsertId();
 
-   return stmtInsert->getAffected() == 1 ? success : fail;
+   if (stmtInsert->getAffected() != 1)
+      return fail;
+
+   memWrite(/*insert =*/ yes, /*changedOnly =*/ no);
+
+   return success;
 }
 
 //***************************************************************************
@@ -1595,10 +2412,145 @@ int cDbTable::update(time_t updsp)
          setValue(fld, fld->getDefault());
    }
 
-   if (stmtUpdate->execute())
+   cDbStatement* stmt = getUpdateStatement();
+
+   if (stmt->execute())
       return fail;
 
-   return stmtUpdate->getAffected() == 1 ? success : fail;
+   if (stmt->getAffected() != 1)
+      return fail;
+
+   memWrite(/*insert =*/ no, /*changedOnly =*/ stmt != stmtUpdate);
+
+   return success;
+}
+
+//***************************************************************************
+// Get Update Statement
+//  - the statement of all update fields is used if all of them are changed,
+//    otherwise a statement for just the changed fields is prepared and
+//    cached by the mask of the changed fields
+//***************************************************************************
+
+static long valueSize(cDbValue* value)
+{
+   switch (value->getField()->getFormat())
+   {
+      case cDBS::ffAscii:
+      case cDBS::ffText:
+      case cDBS::ffMText:
+      case cDBS::ffMlob:     return value->getStrValueSize();
+      case cDBS::ffDateTime: return sizeof(MYSQL_TIME);
+      default:               return sizeof(int64_t);
+   }
+}
+
+int cDbTable::isUpdateField(cDbFieldDef* fld)
+{
+   // don't update PKey, autoinc and the insert stamp
+
+   if (fld->getType() & ftPrimary || fld->getType() & ftAutoinc)
+      return no;
+
+   return strcasecmp(fld->getName(), "inssp") != 0;
+}
+
+cDbStatement* cDbTable::getUpdateStatement()
+{
+   std::string mask(fieldCount(), '-');
+   long fullSize = 0;
+   long size = 0;
+   int changed = 0;
+   int all = yes;
+
+   for (int i = 0; i < fieldCount(); i++)
+   {
+      cDbFieldDef* fld = getField(i);
+
+      if (!isUpdateField(fld))
+         continue;
+
+      cDbValue* value = getValue(fld);
+      long s = valueSize(value);
+
+      fullSize += s;
+
+      if (value->getChanges())
+      {
+         mask[i] = 'x';
+         size += s;
+         changed++;
+      }
+      else
+         all = no;
+   }
+
+   auto it = updateStatements.find(mask);
+
+   if (all || !changed || (it == updateStatements.end() && updateStatements.size() >= maxUpdateStatements))
+   {
+      updates++;
+      updateBytesSent += fullSize;
+      return stmtUpdate;
+   }
+
+   updates++;
+   updateBytesSent += size;
+   updateBytesSaved += fullSize - size;
+
+   if (it != updateStatements.end())
+      return it->second;
+
+   // new mask, prepare statement
+
+   int n = 0;
+   cDbStatement* stmt = new cDbStatement(this);
+
+   stmt->build("update %s set ", TableName());
+
+   for (int i = 0; i < fieldCount(); i++)
+   {
+      if (mask[i] == 'x')
+         stmt->bind(getField(i), bndIn | bndSet, n++ ? ", " : "");
+   }
+
+   stmt->build(" where ");
+
+   n = 0;
+
+   for (int i = 0; i < fieldCount(); i++)
+   {
+      if (getField(i)->getType() & ftPrimary)
+         stmt->bind(getField(i), bndIn | bndSet, n++ ? " and " : "");
+   }
+
+   stmt->build(";");
+
+   if (stmt->prepare() != success)
+   {
+      delete stmt;
+      return stmtUpdate;
+   }
+
+   updateStatements[mask] = stmt;
+
+   return stmt;
+}
+
+//***************************************************************************
+// Show Statistic
+//***************************************************************************
+
+void cDbTable::showStat()
+{
+   if (updates)
+      tell(0, "Table '%s': %ld updates with %d field masks, %ld kB sent, %ld kB saved by updating changed fields only",
+           TableName(), updates, (int)updateStatements.size(),
+           updateBytesSent / 1024, updateBytesSaved / 1024);
+
+   if (holdInMemory && memLoads)
+      tell(0, "Table '%s': %d rows in memory, %ld hits, %ld misses, %ld (re)loads",
+           TableName(), (int)memRows.size(), memHits, memMisses, memLoads);
 }
 
 //***************************************************************************
@@ -1607,16 +2559,31 @@ int cDbTable::update(time_t updsp)
 
 int cDbTable::find()
 {
+   int found;
+
    if (!stmtSelect)
       return no;
 
+   if (holdInMemory && memCheck() == success)
+   {
+      if (memFind())
+         return yes;
+
+      memMisses++;               // read through
+   }
+
    if (stmtSelect->execute() != success)
    {
       connection->errorSql(connection, "find()");
       return no;
    }
 
-   return stmtSelect->getAffected() == 1 ? yes : no;
+   found = stmtSelect->getAffected() == 1;
+
+   if (found && memLoaded)
+      memWrite(/*insert =*/ yes, /*changedOnly =*/ no);
+
+   return found ? yes : no;
 }
 
 //***************************************************************************
@@ -1658,3 +2625,616 @@ void cDbTable::reset(cDbStatement* stmt)
    if (stmt)
       stmt->freeResult();
 }
+
+//***************************************************************************
+// Find By
+//  - for tables held in memory the rows are looked up by a hash index of
+//    the given fields, build on first use, otherwise (or on a miss) a select
+//    statement is prepared and cached for the field list
+//***************************************************************************
+
+int cDbTable::findBy(const char* fields)
+{
+   std::string key;
+   MemIndex* index;
+
+   resetBy();
+
+   if (!(index = getMemIndex(fields)))
+      return no;
+
+   if (holdInMemory && memCheck() == success)
+   {
+      if (!index->valid)
+      {
+         index->rows.clear();
+
+         for (auto it = memRows.begin(); it != memRows.end(); it++)
+         {
+            if (memKey(it->second, index->fields, key) == success)
+               index->rows.insert(std::make_pair(key, it->second));
+         }
+
+         index->valid = yes;
+      }
+
+      if (memKey(row, index->fields, key) != success)   // null never matches
+         return no;
+
+      auto range = index->rows.equal_range(key);
+
+      for (auto it = range.first; it != range.second; it++)
+         byMatches.push_back(it->second);
+
+      byGeneration = memGeneration;
+
+      if (!byMatches.empty())
+         return fetchBy();
+
+      memMisses++;               // read through, as find()
+   }
+
+   // not in memory (or missed), use a statement
+
+   auto it = byStatements.find(fields);
+
+   if (it == byStatements.end())
+   {
+      cDbStatement* stmt = new cDbStatement(this);
+
+      stmt->build("select ");
+      stmt->bindAllOut();
+      stmt->build(" from %s where ", TableName());
+
+      for (size_t i = 0; i < index->fields.size(); i++)
+         stmt->bind(index->fields[i], bndIn | bndSet, i ? " and " : "");
+
+      stmt->build(";");
+
+      if (stmt->prepare() != success)
+      {
+         delete stmt;
+         return no;
+      }
+
+      it = byStatements.insert(std::make_pair(std::string(fields), stmt)).first;
+   }
+
+   byStmt = it->second;
+
+   if (byStmt->find() <= 0)
+      return no;
+
+   memWrite(/*insert =*/ yes, /*changedOnly =*/ no);
+
+   return yes;
+}
+
+int cDbTable::fetchBy()
+{
+   if (byStmt)
+   {
+      if (!byStmt->fetch())
+         return no;
+
+      memWrite(/*insert =*/ yes, /*changedOnly =*/ no);
+
+      return yes;
+   }
+
+   // rows of a previous load may be gone
+
+   if (byGeneration != memGeneration || byPos >= byMatches.size())
+      return no;
+
+   copyRow(byMatches[byPos++], row);
+   memHits++;
+
+   return yes;
+}
+
+void cDbTable::resetBy()
+{
+   if (byStmt)
+      byStmt->freeResult();
+
+   byStmt = 0;
+   byMatches.clear();
+   byPos = 0;
+}
+
+//***************************************************************************
+// Get Mem Index
+//  - the field list is parsed once, the rows of the index are
+//    (re)build on demand by findBy()
+//***************************************************************************
+
+cDbTable::MemIndex* cDbTable::getMemIndex(const char* fields)
+{
+   auto it = memIndices.find(fields);
+
+   if (it != memIndices.end())
+      return &it->second;
+
+   MemIndex index;
+   char* list = strdup(fields);
+   char* p = list;
+   char* name;
+
+   while ((name = strsep(&p, " ")))
+   {
+      cDbFieldDef* fld;
+
+      if (isEmpty(name))
+         continue;
+
+      if (!(fld = getField(name)))
+      {
+         free(list);
+         return 0;
+      }
+
+      index.fields.push_back(fld);
+   }
+
+   free(list);
+
+   if (index.fields.empty())
+      return 0;
+
+   return &(memIndices[fields] = index);
+}
+
+//***************************************************************************
+// Mem Key
+//  - build the hash key of the row by the given fields, case insensitive
+//    like the default collation of the database
+//***************************************************************************
+
+int cDbTable::memKey(cDbRow* r, const std::vector<cDbFieldDef*>& fields, std::string& key)
+{
+   char buf[100];
+
+   key.clear();
+
+   for (size_t i = 0; i < fields.size(); i++)
+   {
+      cDbFieldDef* fld = fields[i];
+      cDbValue* value = r->getValue(fld);
+
+      if (value->isNull())
+         return fail;
+
+      if (fld->isString())
+      {
+         for (const char* c = value->getStrValue(); *c; c++)
+            key += tolower(*c);
+      }
+      else
+      {
+         if (fld->isInt())
+            snprintf(buf, sizeof(buf), "%ld", value->getIntValue());
+         else if (fld->isBigInt())
+            snprintf(buf, sizeof(buf), "%lld", (long long)value->getBigintValue());
+         else if (fld->isFloat())
+            snprintf(buf, sizeof(buf), "%f", value->getFloatValue());
+         else
+            snprintf(buf, sizeof(buf), "%ld", (long)value->getTimeValue());
+
+         key += buf;
+      }
+
+      key += '\x01';
+   }
+
+   return success;
+}
+
+void cDbTable::copyRow(cDbRow* from, cDbRow* to)
+{
+   for (int i = 0; i < fieldCount(); i++)
+      to->getValue(getField(i))->copy(from->getValue(getField(i)));
+}
+
+//***************************************************************************
+// Mem Check
+//  - (re)load the rows if the table was changed by others, probed by
+//    max(updsp) and the row count at most every memCheckInterval seconds
+//***************************************************************************
+
+int cDbTable::memCheck()
+{
+   MYSQL_RES* res;
+   MYSQL_ROW data;
+   time_t maxUpdsp = 0;
+   long count = 0;
+
+   if (!memLoaded)
+      return memLoad();
+
+   if (time(0) < memCheckedAt + memCheckInterval)
+      return success;
+
+   memCheckedAt = time(0);
+
+   if (connection->query("select %s%s, count(1) from %s",
+                         updspField ? "max(" : "0",
+                         updspField ? (std::string(updspField->getDbName()) + ")").c_str() : "",
+                         TableName()))
+   {
+      connection->errorSql(connection, "memCheck()");
+      memClear();
+      return fail;
+   }
+
+   if ((res = mysql_store_result(connection->getMySql())))
+   {
+      if ((data = mysql_fetch_row(res)))
+      {
+         maxUpdsp = data[0] ? atol(data[0]) : 0;
+         count = data[1] ? atol(data[1]) : 0;
+      }
+
+      mysql_free_result(res);
+   }
+
+   // a change in the second of the last load isn't visible by max(updsp), reload in doubt
+
+   if (maxUpdsp != memUpdsp || count != memCount || memUpdsp >= memLoadedAt)
+      return memLoad();
+
+   return success;
+}
+
+//***************************************************************************
+// Mem Load
+//***************************************************************************
+
+int cDbTable::memLoad()
+{
+   std::string key;
+
+   memClear();
+
+   if (!stmtSelectAll)
+      return fail;
+
+   memLoadedAt = memCheckedAt = time(0);
+
+   int f = stmtSelectAll->find();
+
+   if (f < 0)
+      return fail;
+
+   for (; f; f = stmtSelectAll->fetch())
+   {
+      cDbRow* r = new cDbRow(tableDef);
+
+      copyRow(memLoadRow, r);
+
+      if (memKey(r, primaryFields, key) != success)
+      {
+         delete r;
+         continue;
+      }
+
+      auto it = memRows.find(key);
+
+      if (it != memRows.end())
+         delete it->second;
+
+      memRows[key] = r;
+      memCount++;
+
+      if (updspField)
+         memUpdsp = std::max(memUpdsp, (time_t)r->getIntValue(updspField));
+   }
+
+   stmtSelectAll->freeResult();
+
+   memLoaded = yes;
+   memLoads++;
+
+   tell(2, "Loaded %d rows of table '%s' into memory", (int)memRows.size(), TableName());
+
+   return success;
+}
+
+void cDbTable::memClear()
+{
+   for (auto it = memRows.begin(); it != memRows.end(); it++)
+      delete it->second;
+
+   memRows.clear();
+
+   for (auto it = memIndices.begin(); it != memIndices.end(); it++)
+   {
+      it->second.rows.clear();
+      it->second.valid = no;
+   }
+
+   memLoaded = no;
+   memCount = 0;
+   memUpdsp = 0;
+   memGeneration++;
+}
+
+//***************************************************************************
+// Mem Find
+//***************************************************************************
+
+int cDbTable::memFind()
+{
+   std::string key;
+
+   if (memKey(row, primaryFields, key) != success)
+      return no;
+
+   auto it = memRows.find(key);
+
+   if (it == memRows.end())
+      return no;
+
+   copyRow(it->second, row);
+   memHits++;
+
+   return yes;
+}
+
+//***************************************************************************
+// Mem Write
+//  - write through of a inserted, updated or read through row
+//***************************************************************************
+
+void cDbTable::memWrite(int insert, int changedOnly)
+{
+   std::string key;
+
+   if (!holdInMemory || !memLoaded)
+      return;
+
+   if (memKey(row, primaryFields, key) != success)
+   {
+      memClear();                   // reload on next access
+      return;
+   }
+
+   auto it = memRows.find(key);
+
+   if (it == memRows.end())
+   {
+      if (!insert)                  // the complete row is unknown, reload on next check
+         return;
+
+      cDbRow* r = new cDbRow(tableDef);
+      copyRow(row, r);
+      memRows[key] = r;
+      memCount++;
+   }
+   else
+   {
+      for (int i = 0; i < fieldCount(); i++)
+      {
+         cDbFieldDef* fld = getField(i);
+
+         if (!insert && !isUpdateField(fld))
+            continue;
+
+         if (changedOnly && !getValue(fld)->getChanges())
+            continue;
+
+         it->second->getValue(fld)->copy(getValue(fld));
+      }
+   }
+
+   if (updspField)
+      memUpdsp = std::max(memUpdsp, (time_t)getIntValue(updspField));
+
+   for (auto ix = memIndices.begin(); ix != memIndices.end(); ix++)
+      ix->second.valid = no;
+}
+
+//***************************************************************************
+// Class cDbBatchWriter
+//***************************************************************************
+
+cDbBatchWriter::cDbBatchWriter(cDbTable* aTable, int aSize, int aInterval)
+{
+   table = aTable;
+   interval = aInterval;
+   size = std::max(aSize, 1);
+
+   // mysql is limited to 65535 placeholders per statement
+
+   if (size * table->fieldCount() > 65535)
+      size = 65535 / table->fieldCount();
+
+   for (int i = 0; i < size; i++)
+      rows.push_back(new cDbRow(table->getTableDef()));
+}
+
+cDbBatchWriter::~cDbBatchWriter()
+{
+   if (pending)
+      tell(0, "Warning: Dropping %d unwritten rows of batch for '%s'", pending, table->TableName());
+
+   for (auto it = statements.begin(); it != statements.end(); it++)
+      delete it->second;
+
+   for (auto it = rows.begin(); it != rows.end(); it++)
+      delete *it;
+}
+
+//***************************************************************************
+// Append
+//***************************************************************************
+
+int cDbBatchWriter::append(time_t stamp)
+{
+   cDbTableDef* tableDef = table->getTableDef();
+   cDbRow* row = rows[pending];
+   time_t now = time(0);
+
+   for (int i = 0; i < tableDef->fieldCount(); i++)
+   {
+      cDbFieldDef* fld = tableDef->getField(i);
+
+      row->getValue(fld)->copy(table->getValue(fld));
+
+      // same as insert(), inssp is kept by the 'on duplicate key' part
+
+      if (strcasecmp(fld->getName(), "updsp") == 0 || strcasecmp(fld->getName(), "inssp") == 0)
+         row->setValue(fld, stamp ? stamp : now);
+
+      else if (row->isNull(fld) && !isEmpty(fld->getDefault()))
+         row->setValue(fld, fld->getDefault());
+   }
+
+   if (!pending++)
+      firstPendingAt = now;
+
+   if (pending >= size || (interval && now - firstPendingAt >= interval))
+      return flush();
+
+   return success;
+}
+
+//***************************************************************************
+// Flush
+//  - write in chunks of 'size' rows and the rest in power of two chunks,
+//    therefore only a few statements have to be prepared
+//***************************************************************************
+
+int cDbBatchWriter::flush()
+{
+   cDbTableDef* tableDef = table->getTableDef();
+   int offset = 0;
+   int status = success;
+
+   if (!pending)
+      return success;
+
+   while (offset < pending)
+   {
+      int count = chunkSize(pending - offset);
+      cDbStatement* stmt = getStatement(count);
+
+      // the statements are bound to the first 'count' rows, move the rows down
+
+      for (int r = 0; offset && r < count; r++)
+      {
+         for (int i = 0; i < tableDef->fieldCount(); i++)
+            rows[r]->getValue(tableDef->getField(i))->copy(rows[offset+r]->getValue(tableDef->getField(i)));
+      }
+
+      roundTrips++;
+
+      if (!stmt || stmt->execute() != success)
+      {
+         tell(0, "Error: Writing batch of %d rows to '%s' failed", count, table->TableName());
+         status = fail;
+         errors++;
+      }
+
+      offset += count;
+   }
+
+   flushes++;
+   rowsTotal += pending;
+   pending = 0;
+
+   return status;
+}
+
+int cDbBatchWriter::chunkSize(int count)
+{
+   int chunk = 1;
+
+   if (count >= size)
+      return size;
+
+   while (chunk * 2 <= count)
+      chunk *= 2;
+
+   return chunk;
+}
+
+//***************************************************************************
+// Get Statement
+//   insert into <table> (<fields>) values (?, ..), (?, ..), ...
+//     on duplicate key update <field> = values(<field>), ...
+//***************************************************************************
+
+cDbStatement* cDbBatchWriter::getStatement(int count)
+{
+   cDbTableDef* tableDef = table->getTableDef();
+   int n = 0;
+
+   auto it = statements.find(count);
+
+   if (it != statements.end())
+      return it->second;
+
+   cDbStatement* stmt = new cDbStatement(table);
+
+   stmt->build("insert into %s (", table->TableName());
+
+   // autoinc fields are included, a NULL value lets the db create the id
+
+   for (int i = 0; i < tableDef->fieldCount(); i++)
+      stmt->build("%s%s", n++ ? ", " : "", tableDef->getField(i)->getDbName());
+
+   stmt->build(") values ");
+
+   for (int r = 0; r < count; r++)
+   {
+      n = 0;
+      stmt->build("%s(", r ? ", " : "");
+
+      for (int i = 0; i < tableDef->fieldCount(); i++)
+         stmt->bind(rows[r]->getValue(tableDef->getField(i)), bndIn, n++ ? ", " : "");
+
+      stmt->build(")");
+   }
+
+   stmt->build(" on duplicate key update ");
+
+   n = 0;
+
+   for (int i = 0; i < tableDef->fieldCount(); i++)
+   {
+      cDbFieldDef* fld = tableDef->getField(i);
+
+      if (fld->getType() & ftPrimary || fld->getType() & ftAutoinc)
+         continue;
+
+      if (strcasecmp(fld->getName(), "inssp") == 0)  // don't update the insert stamp
+         continue;
+
+      stmt->build("%s%s = values(%s)", n++ ? ", " : "", fld->getDbName(), fld->getDbName());
+   }
+
+   if (!n)   // table has only key fields
+      stmt->build("%s = %s", tableDef->getField(0)->getDbName(), tableDef->getField(0)->getDbName());
+
+   if (stmt->prepare() != success)
+   {
+      delete stmt;
+      return 0;
+   }
+
+   statements[count] = stmt;
+
+   return stmt;
+}
+
+//***************************************************************************
+// Show Statistic
+//***************************************************************************
+
+void cDbBatchWriter::showStat()
+{
+   tell(1, "Batch writer '%s': %ld rows in %ld flushes (%.1f rows/flush) with %ld round trips, %ld errors",
+        table->TableName(), rowsTotal, flushes,
+        flushes ? (double)rowsTotal / flushes : 0.0, roundTrips, errors);
+}
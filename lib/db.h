@@ -18,6 +18,8 @@
 #include <mysql.h>
 
 #include <list>
+#include <vector>
+#include <unordered_map>
 
 #include "common.h"
 #include "dbdict.h"
@@ -37,6 +39,7 @@ class cDbValue : public cDbService
       {
          field = 0;
          strValue = 0;
+         strCapacity = 0;
          ownField = 0;
          changed = 0;
 
@@ -46,11 +49,12 @@ class cDbValue : public cDbService
       cDbValue(const char* name, FieldFormat format, int size)
       {
          strValue = 0;
+         strCapacity = 0;
          changed = 0;
          ownField = new cDbFieldDef(name, name, format, size, ftData, 0);
 
          field = ownField;
-         strValue = (char*)calloc(field->getSize()+TB, sizeof(char));
+         reserve(0);
 
          clear();
       }
@@ -65,6 +69,7 @@ class cDbValue : public cDbService
          clear();
          ::free(strValue);
          strValue = 0;
+         strCapacity = 0;
 
          if (ownField)
          {
@@ -95,15 +100,84 @@ class cDbValue : public cDbService
          changed = 0;
       }
 
+      void copy(cDbValue* from)   // raw copy, both values must belong to the same field
+      {
+         clear();
+
+         if (from->strValue && reserve(from->strValueSize) == success)
+         {
+            memcpy(strValue, from->strValue, from->strValueSize);
+            strValue[from->strValueSize] = 0;
+         }
+
+         strValueSize = from->strValueSize;
+         numValue = from->numValue;
+         longlongValue = from->longlongValue;
+         floatValue = from->floatValue;
+         timeValue = from->timeValue;
+         nullValue = from->nullValue;
+      }
+
       virtual void setField(cDbFieldDef* f)
       {
          free();
          field = f;
 
          if (field)
-            strValue = (char*)calloc(field->getSize()+TB, sizeof(char));
+            reserve(0);
+      }
+
+      //***************************************************************************
+      // String Buffer
+      //  - allocated small and grown on demand up to the size of the field,
+      //    so short and NULL values don't pin the full field size
+      //***************************************************************************
+
+      int isStrFormat()
+      {
+         return field->getFormat() == ffAscii || field->getFormat() == ffText ||
+            field->getFormat() == ffMText || field->getFormat() == ffMlob;
+      }
+
+      int reserve(unsigned long size)
+      {
+         unsigned long max = field->getSize();
+
+         if (strValue && size <= strCapacity)
+            return success;
+
+         // grow at least by factor 2 to avoid frequent reallocs
+
+         unsigned long capacity = std::min(std::max(std::max(size, 2 * strCapacity), (unsigned long)minStrCapacity), max);
+
+         if (size > capacity)
+            return fail;
+
+         char* p = (char*)realloc(strValue, capacity+TB);
+
+         if (!p)
+            return fail;
+
+         if (!strValue)
+            *p = 0;
+
+         p[capacity] = 0;
+         strValue = p;
+         strCapacity = capacity;
+
+         return success;
       }
 
+      void fitStrValue()        // after fetch of a (maybe truncated) value
+      {
+         if (strValueSize > strCapacity)
+            strValueSize = strCapacity;
+
+         strValue[strValueSize] = 0;
+      }
+
+      unsigned long getStrCapacity()       { return strCapacity; }
+
       virtual cDbFieldDef* getField()      { return field; }
       virtual const char* getName()        { return field->getName(); }
       virtual const char* getDbName()      { return field->getDbName(); }
@@ -139,6 +213,7 @@ class cDbValue : public cDbService
       void setValue(const char* value, int size = 0)
       {
          int modified = no;
+         int c = changed;       // clear() resets the change counter
 
          if (field->getFormat() != ffAscii && field->getFormat() != ffText &&
              field->getFormat() != ffMText && field->getFormat() != ffMlob)
@@ -164,10 +239,12 @@ class cDbValue : public cDbService
                size = field->getSize();
             }
 
-            if (memcmp(strValue, value, size) != 0 || isNull())
+            if (isNull() || (unsigned long)size != strValueSize || memcmp(strValue, value, size) != 0)
                modified = yes;
 
             clear();
+            changed = c;
+            reserve(size);
             memcpy(strValue, value, size);
             strValue[size] = 0;
             strValueSize = size;
@@ -176,16 +253,25 @@ class cDbValue : public cDbService
 
          else if (value)
          {
-            if (strlen(value) > (size_t)field->getSize())
+            size_t len = strlen(value);
+
+            if (len > (size_t)field->getSize())
+            {
                tell(0, "Warning, size of %d for '%s' exeeded (needed %ld) [%s]",
-                    field->getSize(), field->getName(), (long)strlen(value), value);
+                    field->getSize(), field->getName(), (long)len, value);
 
-            if (strncmp(strValue, value, strlen(value)) != 0 || isNull())
+               len = field->getSize();
+            }
+
+            if (isNull() || len != strValueSize || strncmp(strValue, value, len) != 0)
                modified = yes;
 
             clear();
-            sprintf(strValue, "%.*s", field->getSize(), value);
-            strValueSize = strlen(strValue);
+            changed = c;
+            reserve(len);
+            memcpy(strValue, value, len);
+            strValue[len] = 0;
+            strValueSize = len;
             nullValue = 0;
          }
 
@@ -280,7 +366,7 @@ class cDbValue : public cDbService
       {
          if (field->getFormat() == ffInt || field->getFormat() == ffUInt)
          {
-            if (numValue != value)
+            if (numValue != value || isNull())
                changed++;
 
             numValue = value;
@@ -289,7 +375,7 @@ class cDbValue : public cDbService
 
          else if (field->getFormat() == ffBigInt || field->getFormat() == ffUBigInt)
          {
-            if (longlongValue != value)
+            if (longlongValue != value || isNull())
                changed++;
 
             longlongValue = value;
@@ -427,10 +513,80 @@ class cDbValue : public cDbService
       MYSQL_TIME timeValue;
       char* strValue;
       unsigned long strValueSize;
+      unsigned long strCapacity;        // allocated size of strValue (without TB)
+
+      enum { minStrCapacity = 32 };
       my_bool nullValue;
       int changed;
 };
 
+//***************************************************************************
+// cDbStatementStat
+//  - latency histogram (log2 buckets of microseconds) and row counters
+//    of a statement text, shared by all connections
+//***************************************************************************
+
+class cDbStatementStat
+{
+   public:
+
+      enum { bucketCount = 32 };
+
+      cDbStatementStat(const char* aText) : text(aText) {}
+
+      double percentile(double p);   // upper bound of the bucket in ms
+
+      std::string text;
+      unsigned long calls {0};
+      unsigned long errors {0};
+      unsigned long rows {0};
+      double total {0};              // us
+      double max {0};                // us
+      unsigned long buckets[bucketCount] {};
+      time_t lastSlowAt {0};
+};
+
+//***************************************************************************
+// cDbStatistic
+//  - process wide registry of the statement statistics and the
+//    captured slow queries
+//***************************************************************************
+
+class cDbStatistic
+{
+   public:
+
+      struct SlowQuery
+      {
+         time_t time;
+         double ms;
+         std::string text;
+         std::string params;
+         std::string explain;
+      };
+
+      static cDbStatementStat* get(const char* text);
+      static int record(cDbStatementStat* stat, double us, long rows, int error);
+      static void addRows(cDbStatementStat* stat, long rows);
+      static void addSlow(const SlowQuery& query);
+      static void reset();
+      static unsigned long totalCalls();   // round trips of all statements
+
+      static std::string report(int top = 25);
+      static std::string reportSlow();
+
+      static int slowThreshold;      // capture statements slower than n ms, 0 for off
+
+   private:
+
+      static const size_t maxSlowQueries {20};
+      static const int slowInterval {60};   // capture a statement at most every n seconds
+
+      static cMyMutex mutex;
+      static std::map<std::string,cDbStatementStat*> stats;
+      static std::list<SlowQuery> slowQueries;
+};
+
 //***************************************************************************
 // cDbStatement
 //***************************************************************************
@@ -479,7 +635,13 @@ class cDbStatement : public cDbService
 
       // ..
 
-      int prepare();
+      int prepare();       // deferred to the first execute with lazyPrepare
+      int reprepare();     // prepare again after a reconnect, bindings stay untouched
+      int isPrepared()     { return prepared; }
+      int setStreaming(int on, int prefetch = 100);
+      int isStreaming()    { return streaming; }
+      int fetchFailed()    { return fetchError; }   // last fetch() ended by a error, not by the end of the result
+      int hasOpenResult()  { return rowsLeft > 0; }
       int getAffected()    { return affected; }
       int getResultCount();
       int getLastInsertId();
@@ -490,6 +652,7 @@ class cDbStatement : public cDbService
       // data
 
       static int explain;         // debug explain
+      static int lazyPrepare;     // defer prepare of statements on verified tables (default off)
 
    private:
 
@@ -506,10 +669,29 @@ class cDbStatement : public cDbService
       const char* bindPrefix;
       int firstExec;              // debug explain
       int buildErrors;
+      int streaming;              // fetch via server side cursor instead of storing the result
+      unsigned long prefetchRows;
+      std::vector<cDbValue*> inValues;    // the values of the bindings
+      std::vector<cDbValue*> outValues;
+
+      int prepareStatement();
+      int applyCursorType();
+      int executeStatement(int noResult);
+      void captureSlow(double ms);
+      int updateBindings(MYSQL_BIND* bindings, std::vector<cDbValue*>& values);
+      int fetchRow();
+      int fetchTruncated();
 
       unsigned long callsPeriod;
       unsigned long callsTotal;
       double duration;
+
+      cDbStatementStat* statistic {};
+      long streamedRows {0};     // rows fetched via cursor, added to the statistic on freeResult()
+      int fetchError {no};
+      int prepared {no};
+      long rowsLeft {0};         // rows of the result not fetched yet (streaming: 1 until the end)
+      int invalidated {no};      // the pending result was lost by a reconnect
 };
 
 //***************************************************************************
@@ -526,6 +708,32 @@ class cDbStatements
       void append(cDbStatement* s)  { statements.push_back(s); }
       void remove(cDbStatement* s)  { statements.remove(s); }
 
+      int reprepare()
+      {
+         int failed = 0;
+
+         for (std::list<cDbStatement*>::iterator it = statements.begin() ; it != statements.end(); ++it)
+         {
+            if (*it && (*it)->reprepare() != success)
+               failed++;
+         }
+
+         return failed;
+      }
+
+      int openResults(cDbStatement* except = 0)
+      {
+         int count = 0;
+
+         for (std::list<cDbStatement*>::iterator it = statements.begin() ; it != statements.end(); ++it)
+         {
+            if (*it && *it != except && (*it)->hasOpenResult())
+               count++;
+         }
+
+         return count;
+      }
+
       void showStat(const char* name)
       {
          tell(0, "Statement statistic of last %ld seconds from '%s':", time(0) - statisticPeriod, name);
@@ -678,6 +886,7 @@ class cDbRow : public cDbService
 
       cDbValue* getValue(cDbFieldDef* f)                    { return &dbValues[f->getIndex()]; }
       cDbValue* getValue(const char* n)                     { GET_FIELD_RES(n, 0); return &dbValues[f->getIndex()]; }
+      cDbValue* getValueAt(int i)                     const { return &dbValues[tableDef->indexOf(i)]; }   // index from dbfields.h
 
       time_t  getTimeValue(cDbFieldDef* f)            const { return dbValues[f->getIndex()].getTimeValue(); }
       const char* getStrValue(cDbFieldDef* f)         const { return dbValues[f->getIndex()].getStrValue(); }
@@ -708,12 +917,15 @@ class cDbConnection
 {
    public:
 
-      cDbConnection()
+      cDbConnection(const char* aName = 0)     // a other database than the configured one
       {
          mysql = 0;
          attached = 0;
          inTact = no;
          connectDropped = yes;
+
+         if (aName)
+            name = aName;
       }
 
       virtual ~cDbConnection()
@@ -722,46 +934,19 @@ class cDbConnection
       }
 
       int isConnected() { return getMySql() != 0; }
+      const char* database() { return name.empty() ? dbName : name.c_str(); }
 
       int attachConnection()
       {
-         static int first = yes;
-
          if (!mysql)
          {
-            connectDropped = yes;
-
-            tell(2, "Calling mysql_init(%ld)", syscall(__NR_gettid));
-
-            if (!(mysql = mysql_init(0)))
-               return errorSql(this, "attachConnection(init)");
-
-            if (!mysql_real_connect(mysql, dbHost,
-                                    dbUser, dbPass, dbName, dbPort, 0, 0))
-            {
-               close();
-
-               tell(0, "Error, connecting to database at '%s' on port (%d) failed",
-                    dbHost, dbPort);
-
+            if (connect() != success)
                return fail;
-            }
-
-            connectDropped = no;
 
-            // init encoding
+            // connection was dropped while attached, prepare the statements again
 
-            if (encoding && *encoding)
-            {
-               if (mysql_set_character_set(mysql, encoding))
-                  errorSql(this, "init(character_set)");
-
-               if (first)
-               {
-                  tell(0, "SQL client character now '%s'", mysql_character_set_name(mysql));
-                  first = no;
-               }
-            }
+            if (attached)
+               statements.reprepare();
          }
 
          attached++;
@@ -790,9 +975,24 @@ class cDbConnection
          }
       }
 
+      // close a dropped connection but keep the attachments for a reconnect
+
+      void disconnect()
+      {
+         if (mysql)
+         {
+            tell(2, "Closing dropped mysql connection");
+
+            mysql_close(mysql);
+            mysql = 0;
+         }
+      }
+
       int check()
       {
-         if (!isConnected())
+         // a dropped connection of opened tables is re-established in place
+
+         if (!isConnected() && (!attached || reconnect() != success))
             return fail;
 
          query("SELECT SYSDATE();");
@@ -801,6 +1001,13 @@ class cDbConnection
          return isConnected() ? success : fail;
       }
 
+      int reconnect();
+      int isDropped()     { return connectDropped || !mysql; }
+      int getReconnects() { return reconnects; }
+
+      const char* getSchemaFingerprint(const char* table);
+      int setSchemaFingerprint(const char* table, const char* fingerprint);
+
       virtual int __attribute__ ((format(printf, 2, 3))) query(const char* format, ...)
       {
          va_list more;
@@ -858,8 +1065,19 @@ class cDbConnection
             vasprintf(&stmt, format, more);
 
             if ((status = mysql_query(h, stmt)))
+            {
                errorSql(this, stmt);
 
+               // retry once on a lost connection, but not inside a transaction
+               //   and not while a statement is iterating a result
+
+               if (isDropped() && !inTact && !statements.openResults() && reconnect() == success)
+               {
+                  if ((status = mysql_query(getMySql(), stmt)))
+                     errorSql(this, stmt);
+               }
+            }
+
             free(stmt);
          }
 
@@ -962,7 +1180,7 @@ class cDbConnection
       MYSQL* getMySql()
       {
          if (connectDropped)
-            close();
+            disconnect();
 
          return mysql;
       }
@@ -994,6 +1212,7 @@ class cDbConnection
       static const char* getEncoding()               { return encoding; }
       static void setConfPath(const char* cpath)     { free(confPath); confPath = strdup(cpath); }
       static const char* getConfPath()               { return confPath; }
+      static void setSchemaOwner(const char* owner)  { free(schemaOwner); schemaOwner = strdup(owner); }
 
       // -----------------------------------------------------------
       // init() and exit() must exactly called 'once' per process
@@ -1061,12 +1280,20 @@ class cDbConnection
       int attached;
       int inTact;
       int connectDropped;
+      int reconnects {0};
+      time_t reconnectFailedAt {0};     // don't retry a failed reconnect for some seconds
+      std::string name;                 // database of this connection, empty for dbName
+      int schemaLoaded {no};            // fingerprints loaded since connect
+      std::map<std::string, std::string, _casecmp_> schemaFingerprints;
+
+      int connect();
 
       static cMyMutex initMutex;
       static int initThreads;
 
       static char* encoding;
       static char* confPath;
+      static char* schemaOwner;          // owner of the fingerprint rows in parameters
 
       // connecting data
 
@@ -1114,6 +1341,17 @@ class cDbTable : public cDbService
       virtual int countWhere(const char* where, int& count, const char* what = 0);
       virtual int truncate();
 
+      // lookup by the current values of some fields (space separated list like "SOURCE CHANNELID"),
+      //   served from memory for tables held in memory, otherwise via a prepared select
+
+      int findBy(const char* fields);
+      int fetchBy();
+      void resetBy();
+
+      int isHoldInMemory()                      { return holdInMemory; }
+      int isSchemaVerified()                    { return schemaVerified; }
+      void setMemCheckInterval(int seconds)     { memCheckInterval = seconds; }
+
       // interface to cDbRow
 
       void clear()                                                    { row->clear(); }
@@ -1160,6 +1398,7 @@ class cDbTable : public cDbService
 
       cDbValue* getValue(cDbFieldDef* f)                              { return row->getValue(f); }
       cDbValue* getValue(const char* fname)                           { return row->getValue(fname); }
+      cDbValue* getValueAt(int i)                                     { return row->getValueAt(i); }
       int init(cDbValue*& dbvalue, const char* fname)                 { dbvalue = row->getValue(fname); return dbvalue ? success : fail; }
       cDbRow* getRow()                                                { return row; }
 
@@ -1175,6 +1414,8 @@ class cDbTable : public cDbService
       virtual int createTable();
       virtual int createIndices();
 
+      void showStat();
+
    protected:
 
       virtual int init(int allowAlter = 0);                     // 0 - off, 1 - on, 2 on with allow drop unused columns
@@ -1183,10 +1424,32 @@ class cDbTable : public cDbService
       virtual int alterAddField(cDbFieldDef* def);
       virtual int alterDropField(const char* name);
 
+      cDbStatement* getUpdateStatement();
+      int isUpdateField(cDbFieldDef* fld);
+
+      // in memory mirror
+
+      struct MemIndex
+      {
+         std::vector<cDbFieldDef*> fields;
+         std::unordered_multimap<std::string,cDbRow*> rows;
+         int valid {no};
+      };
+
+      int memCheck();
+      int memLoad();
+      void memClear();
+      int memFind();
+      void memWrite(int insert, int changedOnly);
+      MemIndex* getMemIndex(const char* fields);
+      int memKey(cDbRow* r, const std::vector<cDbFieldDef*>& fields, std::string& key);
+      void copyRow(cDbRow* from, cDbRow* to);
+
       // data
 
       cDbRow* row;
-      int holdInMemory;        // hold table additionally in memory (not implemented yet)
+      int holdInMemory;        // hold table additionally in memory (flag 'inmemory' of the dictionary)
+      int schemaVerified {no}; // fingerprint of the table matches the dictionary
       int attached;
       int lastInsertId;
 
@@ -1198,6 +1461,86 @@ class cDbTable : public cDbService
       cDbStatement* stmtSelect;
       cDbStatement* stmtInsert;
       cDbStatement* stmtUpdate;
+
+      // update statements of the changed fields only, by field mask
+
+      std::map<std::string,cDbStatement*> updateStatements;
+      static const size_t maxUpdateStatements {50};
+
+      long updates {0};
+      long updateBytesSent {0};
+      long updateBytesSaved {0};
+
+      // in memory mirror, rows hashed by the primary key, reloaded if
+      //   max(updsp) or count of the table changed
+
+      cDbStatement* stmtSelectAll {};
+      cDbRow* memLoadRow {};
+      std::unordered_map<std::string,cDbRow*> memRows;
+      std::map<std::string,MemIndex> memIndices;     // by field list of findBy()
+      std::vector<cDbFieldDef*> primaryFields;
+      cDbFieldDef* updspField {};
+      int memLoaded {no};
+      int memGeneration {0};                         // incremented on each (re)load
+      long memCount {0};
+      time_t memUpdsp {0};
+      time_t memLoadedAt {0};
+      time_t memCheckedAt {0};
+      int memCheckInterval {5};                      // seconds
+
+      // findBy() cursor
+
+      cDbStatement* byStmt {};
+      std::map<std::string,cDbStatement*> byStatements;
+      std::vector<cDbRow*> byMatches;
+      size_t byPos {0};
+      int byGeneration {0};
+
+      long memHits {0};
+      long memMisses {0};
+      long memLoads {0};
+};
+
+//***************************************************************************
+// cDbBatchWriter
+//  - collects rows of a table and writes them with one multi row
+//    'insert ... on duplicate key update' per flush
+//***************************************************************************
+
+class cDbBatchWriter : public cDbService
+{
+   public:
+
+      cDbBatchWriter(cDbTable* aTable, int aSize = 100, int aInterval = 10);
+      virtual ~cDbBatchWriter();
+
+      int append(time_t stamp = 0);   // append a copy of the current row of the table
+      int flush();
+      void clear()                    { pending = 0; }
+      int getPending()                { return pending; }
+      cDbTable* getTable()            { return table; }
+      void showStat();
+
+   protected:
+
+      int chunkSize(int count);
+      cDbStatement* getStatement(int count);
+
+      cDbTable* table {};
+      int size {100};                 // max rows per flush
+      int interval {10};              // flush at least every n seconds (checked on append)
+      int pending {0};
+      time_t firstPendingAt {0};
+
+      std::vector<cDbRow*> rows;
+      std::map<int,cDbStatement*> statements;   // prepared upsert statements by row count
+
+      // statistic
+
+      long flushes {0};
+      long rowsTotal {0};
+      long roundTrips {0};
+      long errors {0};
 };
 
 //***************************************************************************
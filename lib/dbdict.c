@@ -6,6 +6,7 @@
  */
 
 #include "errno.h"
+#include <sys/stat.h>
 
 #include "common.h"
 #include "dbdict.h"
@@ -217,6 +218,56 @@ int cDbDict::init(cDbFieldDef*& field, const char* tname, const char* fname)
    return fail;
 }
 
+//***************************************************************************
+// Check Indices
+//  - verify compiled in field indices (see dbfields.h) against the
+//    loaded dictionary, the list is terminated by a entry without table
+//  - if tables is given (0 terminated) only the indices of these tables
+//    are checked
+//  - a field at a other index is mapped by name (cDbTableDef::indexOf()),
+//    only missing fields fail
+//***************************************************************************
+
+int cDbDict::checkIndices(const FieldIndex* indices, const char* const* tables)
+{
+   int errors {0};
+
+   for (const FieldIndex* i = indices; i->table; i++)
+   {
+      if (tables)
+      {
+         const char* const* t = tables;
+
+         while (*t && strcasecmp(*t, i->table) != 0)
+            t++;
+
+         if (!*t)
+            continue;
+      }
+
+      cDbTableDef* table = getTable(i->table);
+      cDbFieldDef* field = table ? table->getField(i->field, yes) : 0;
+
+      if (!field)
+      {
+         tell(0, "Fatal: Field %s.%s not found in dictionary", i->table, i->field);
+         errors++;
+      }
+      else
+      {
+         // a other index is resolved by name, the accessors map it
+
+         if (field->getIndex() != i->index)
+            tell(0, "Warning: Index of field %s.%s is %d, compiled in index is %d, using %d",
+                 i->table, i->field, field->getIndex(), i->index, field->getIndex());
+
+         table->mapCompiledIndex(i->index, field->getIndex());
+      }
+   }
+
+   return errors ? fail : success;
+}
+
 //***************************************************************************
 // In
 //***************************************************************************
@@ -226,6 +277,8 @@ int cDbDict::in(const char* file, int filter)
    FILE* f;
    char* line = 0;
    size_t size = 0;
+   struct stat sb {};
+   std::string cacheFile;
 
    if (isEmpty(file))
       return fail;
@@ -233,6 +286,16 @@ int cDbDict::in(const char* file, int filter)
    fieldFilter = filter;
    asprintf(&path, "%s", file);
 
+   // try the cache first, it's valid as long as the dictionary isn't touched
+
+   cacheFile = std::string(path) + ".cache";
+
+   if (stat(path, &sb) == 0 && readCache(cacheFile.c_str(), sb.st_mtime, sb.st_size) == success)
+   {
+      tell(1, "Dictionary '%s' loaded from cache", path);
+      return success;
+   }
+
    f = fopen(path, "r");
 
    if (!f)
@@ -263,9 +326,317 @@ int cDbDict::in(const char* file, int filter)
    fclose(f);   
    free(line);
 
+   writeCache(cacheFile.c_str(), sb.st_mtime, sb.st_size);
+
+   return success;
+}
+
+//***************************************************************************
+// Dictionary Cache
+//  - binary image of the parsed dictionary to avoid the parsing at startup
+//  - bound to the version, the mtime and size of the dictionary file and
+//    the field filter, on any difference the dictionary is parsed again
+//    and the cache rewritten
+//***************************************************************************
+
+static const char* cacheMagic = "EPGDICT";
+static const int cacheVersion = 1;
+
+static void putInt(FILE* fp, int64_t value)
+{
+   fwrite(&value, sizeof(value), 1, fp);
+}
+
+static void putStr(FILE* fp, const char* str)
+{
+   putInt(fp, str ? (int64_t)strlen(str) : -1);
+
+   if (str)
+      fwrite(str, 1, strlen(str), fp);
+}
+
+static int getInt(FILE* fp, int64_t& value)
+{
+   return fread(&value, sizeof(value), 1, fp) == 1 ? success : fail;
+}
+
+static int getStr(FILE* fp, char*& str)      // str is 0 for a NULL string, caller has to free it
+{
+   int64_t len;
+
+   str = 0;
+
+   if (getInt(fp, len) != success || len > 10000)
+      return fail;
+
+   if (len < 0)
+      return success;
+
+   str = (char*)malloc(len + 1);
+
+   if (fread(str, 1, len, fp) != (size_t)len)
+   {
+      free(str);
+      str = 0;
+      return fail;
+   }
+
+   str[len] = 0;
+
+   return success;
+}
+
+int cDbDict::writeCache(const char* file, time_t mtime, long size)
+{
+   std::string tmp = std::string(file) + ".tmp";
+   FILE* fp;
+
+   if (!(fp = fopen(tmp.c_str(), "w")))
+   {
+      tell(1, "Info: Can't write dictionary cache '%s', error was '%s'", tmp.c_str(), strerror(errno));
+      return fail;
+   }
+
+   putStr(fp, cacheMagic);
+   putInt(fp, cacheVersion);
+   putInt(fp, mtime);
+   putInt(fp, size);
+   putInt(fp, fieldFilter);
+   putInt(fp, tables.size());
+
+   for (auto t = tables.begin(); t != tables.end(); t++)
+   {
+      cDbTableDef* table = t->second;
+
+      putStr(fp, table->getName());
+      putInt(fp, table->isHoldInMemory());
+      putInt(fp, table->fieldCount());
+
+      for (int i = 0; i < table->fieldCount(); i++)
+      {
+         cDbFieldDef* f = table->getField(i);
+
+         putStr(fp, f->name);
+         putStr(fp, f->description);
+         putStr(fp, f->dbname);
+         putInt(fp, f->format);
+         putInt(fp, f->size);
+         putInt(fp, f->type);
+         putInt(fp, f->filter);
+         putStr(fp, f->def);
+      }
+
+      putInt(fp, table->indexCount());
+
+      for (int i = 0; i < table->indexCount(); i++)
+      {
+         cDbIndexDef* index = table->getIndex(i);
+
+         putStr(fp, index->getName());
+         putStr(fp, index->getDescription());
+         putInt(fp, index->fieldCount());
+
+         for (int n = 0; n < index->fieldCount(); n++)
+            putStr(fp, index->getField(n) ? index->getField(n)->getName() : 0);
+      }
+   }
+
+   if (fclose(fp) != 0 || rename(tmp.c_str(), file) != 0)
+   {
+      tell(1, "Info: Can't write dictionary cache '%s', error was '%s'", file, strerror(errno));
+      unlink(tmp.c_str());
+      return fail;
+   }
+
+   tell(2, "Wrote dictionary cache '%s'", file);
+
    return success;
 }
 
+int cDbDict::readCache(const char* file, time_t mtime, long size)
+{
+   FILE* fp;
+   char* magic {};
+   int64_t version, cMtime, cSize, cFilter, tableCount;
+   int status {success};
+
+   if (!(fp = fopen(file, "r")))
+      return fail;
+
+   if (getStr(fp, magic) != success || !magic || strcmp(magic, cacheMagic) != 0 ||
+       getInt(fp, version) != success || version != cacheVersion ||
+       getInt(fp, cMtime) != success || cMtime != mtime ||
+       getInt(fp, cSize) != success || cSize != size ||
+       getInt(fp, cFilter) != success || cFilter != fieldFilter ||
+       getInt(fp, tableCount) != success)
+   {
+      free(magic);
+      fclose(fp);
+      tell(2, "Dictionary cache '%s' outdated, ignoring", file);
+      return fail;
+   }
+
+   free(magic);
+
+   for (int t = 0; status == success && t < tableCount; t++)
+   {
+      char* name {};
+      int64_t inMemory, count;
+
+      if (getStr(fp, name) != success || !name ||
+          getInt(fp, inMemory) != success || getInt(fp, count) != success)
+      {
+         free(name);
+         status = fail;
+         break;
+      }
+
+      cDbTableDef* table = new cDbTableDef(name);
+      table->setHoldInMemory(inMemory);
+      tables[name] = table;
+      free(name);
+
+      for (int i = 0; status == success && i < count; i++)
+      {
+         cDbFieldDef* f = new cDbFieldDef;
+         char* description {};
+         int64_t format, fsize, type, filter;
+
+         if (getStr(fp, f->name) != success || getStr(fp, description) != success ||
+             getStr(fp, f->dbname) != success || getInt(fp, format) != success ||
+             getInt(fp, fsize) != success || getInt(fp, type) != success ||
+             getInt(fp, filter) != success || getStr(fp, f->def) != success ||
+             !f->name || !f->dbname)
+         {
+            free(description);
+            delete f;
+            status = fail;
+            break;
+         }
+
+         if (description)
+            f->setDescription(description);
+
+         free(description);
+
+         f->format = (FieldFormat)format;
+         f->size = fsize;
+         f->type = type;
+         f->filter = filter;
+         f->index = table->fieldCount();
+         table->addField(f);
+      }
+
+      if (status != success || getInt(fp, count) != success)
+      {
+         status = fail;
+         break;
+      }
+
+      for (int i = 0; status == success && i < count; i++)
+      {
+         cDbIndexDef* index = new cDbIndexDef();
+         char* iname {};
+         char* description {};
+         int64_t fields;
+
+         table->addIndex(index);
+
+         if (getStr(fp, iname) != success || getStr(fp, description) != success ||
+             getInt(fp, fields) != success)
+         {
+            free(iname);
+            free(description);
+            status = fail;
+            break;
+         }
+
+         if (iname) index->setName(iname);
+         if (description) index->setDescription(description);
+         free(iname);
+         free(description);
+
+         for (int n = 0; n < fields; n++)
+         {
+            char* fname {};
+
+            if (getStr(fp, fname) != success)
+            {
+               status = fail;
+               break;
+            }
+
+            index->addField(fname ? table->getField(fname) : 0);
+            free(fname);
+         }
+      }
+   }
+
+   fclose(fp);
+
+   if (status != success)
+   {
+      tell(0, "Warning: Dictionary cache '%s' corrupt, ignoring", file);
+
+      // drop the partially loaded tables, the dictionary will be parsed again
+
+      for (auto t = tables.begin(); t != tables.end(); t++)
+         delete t->second;
+
+      tables.clear();
+   }
+
+   return status;
+}
+
+//***************************************************************************
+// Fingerprint
+//  - hash over the table definition (fields, formats, defaults, indices),
+//    stored in a parameters row of the schema owner (schema-epg2vdr for the
+//    plugin) after the structure is validated. As long as it matches the
+//    validation round trips can be skipped
+//***************************************************************************
+
+const char* cDbTableDef::getFingerprint()
+{
+   if (fingerprint)
+      return fingerprint;
+
+   uint64_t hash = 14695981039346656037ULL;     // FNV-1a
+   std::string def;
+   char tmp[100];
+
+   for (int i = 0; i < fieldCount(); i++)
+   {
+      cDbFieldDef* f = getField(i);
+
+      def += std::string(f->getName()) + "|" + f->getDbName() + "|" + f->toColumnFormat(tmp)
+         + "|" + f->getDefault() + "|" + notNull(f->getDbDescription(), "")
+         + "|" + std::to_string(f->getType()) + ";";
+   }
+
+   for (int i = 0; i < indexCount(); i++)
+   {
+      def += std::string("idx") + notNull(getIndex(i)->getName(), "") + "(";
+
+      for (int n = 0; n < getIndex(i)->fieldCount(); n++)
+         if (getIndex(i)->getField(n))
+            def += std::string(getIndex(i)->getField(n)->getDbName()) + ",";
+
+      def += ");";
+   }
+
+   for (size_t i = 0; i < def.length(); i++)
+   {
+      hash ^= (unsigned char)tolower(def[i]);
+      hash *= 1099511628211ULL;
+   }
+
+   asprintf(&fingerprint, "schema:%016llx", (unsigned long long)hash);
+
+   return fingerprint;
+}
+
 //***************************************************************************
 // Forget
 //***************************************************************************
@@ -323,17 +694,31 @@ int cDbDict::atLine(const char* line)
    if (strncasecmp(line, "Table ", 6) == 0)
    {
       char tableName[100];
+      char* option;
 
       prsTable = yes;
       curTable = 0;
       p = line + strlen("Table ");
       strcpy(tableName, p);
       allTrim(tableName);
-      
+
+      // optional flags behind the name, like 'Table vdrs inmemory'
+
+      if ((option = strpbrk(tableName, " \t")))
+      {
+         *option++ = 0;
+         allTrim(option);
+      }
+
       if (!getTable(tableName))
       {
          curTable = new cDbTableDef(tableName);
          tables[tableName] = curTable;
+
+         if (option && strcasecmp(option, "inmemory") == 0)
+            curTable->setHoldInMemory(yes);
+         else if (!isEmpty(option))
+            tell(0, "Warning: Ignoring unknown option '%s' of table '%s'", option, tableName);
       }
       else
          tell(0, "Fatal: Table '%s' doubly defined", tableName);
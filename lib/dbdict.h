@@ -294,7 +294,7 @@ class cDbTableDef : public cDbService
       friend class cDbTable;
       friend class cDbStatement;
 
-      cDbTableDef(const char* n)       { name = strdup(n); }
+      cDbTableDef(const char* n)       { name = strdup(n); holdInMemory = no; fingerprint = 0; }
 
       ~cDbTableDef()
       {
@@ -304,10 +304,14 @@ class cDbTableDef : public cDbService
          indices.clear();
 
          free(name);
+         free(fingerprint);
          clear();
       }
 
       const char* getName()            { return name; }
+      const char* getFingerprint();
+      int isHoldInMemory()             { return holdInMemory; }
+      void setHoldInMemory(int flag)   { holdInMemory = flag; }
       int fieldCount()                 { return dfields.size(); }
       cDbFieldDef* getField(int id)    { return _dfields[id]; }
 
@@ -350,6 +354,19 @@ class cDbTableDef : public cDbService
             tell(0, "Fatal: Field '%s.%s' doubly defined", getName(), f->getName());
       }
 
+      // index of a field by it's compiled in index (dbfields.h), both are the same
+      //   unless the dictionary differs from the one dbfields.h was generated of
+
+      int indexOf(int compiled)           { return compiledIndex.empty() ? compiled : compiledIndex[compiled]; }
+
+      void mapCompiledIndex(int compiled, int index)
+      {
+         while ((int)compiledIndex.size() <= compiled)
+            compiledIndex.push_back(compiledIndex.size());
+
+         compiledIndex[compiled] = index;
+      }
+
       int indexCount()                    { return indices.size(); }
       cDbIndexDef* getIndex(int i)        { return indices[i]; }
       void addIndex(cDbIndexDef* i)       { indices.push_back(i); }
@@ -395,7 +412,10 @@ class cDbTableDef : public cDbService
    private:
 
       char* name;
+      int holdInMemory;        // table flagged 'inmemory' in the dictionary
+      char* fingerprint;       // hash of the definition, see getFingerprint()
       std::vector<cDbIndexDef*> indices;
+      std::vector<int> compiledIndex;     // compiled in index -> index, see indexOf()
 
       // FiledDefs stored as list to have access via index
       std::vector<cDbFieldDef*> _dfields;
@@ -433,6 +453,13 @@ class cDbDict : public cDbService
          idtFields
       };
 
+      struct FieldIndex
+      {
+         const char* table;
+         const char* field;
+         int index;
+      };
+
       cDbDict();
       virtual ~cDbDict();
 
@@ -442,6 +469,7 @@ class cDbDict : public cDbService
       cDbTableDef* getTable(const char* name);
       void show();
       int init(cDbFieldDef*& field, const char* tname, const char* fname);
+      int checkIndices(const FieldIndex* indices, const char* const* tables = 0);
       const char* getPath() { return path ? path : ""; }
       void forget();
 
@@ -454,6 +482,8 @@ class cDbDict : public cDbService
       int parseField(const char* line);
       int parseIndex(const char* line);
       int parseFilter(cDbFieldDef* f, const char* value);
+      int readCache(const char* file, time_t mtime, long size);
+      int writeCache(const char* file, time_t mtime, long size);
 
       // data
 
@@ -0,0 +1,117 @@
+#
+# dict2h.awk
+#
+#   Generate a header with the field indices of the tables of a
+#   db dictionary (like configs/epg.dat)
+#
+#   usage: awk -f lib/dict2h.awk configs/epg.dat > dbfields.h
+#
+#   The index of a field is its position in the table definition, like
+#   cDbDict::parseField() assigns it (without field filter!). The indices
+#   are checked against the dictionary loaded at runtime by dbf::check().
+#
+
+BEGIN {
+   tableCount = 0
+   isTable = 0
+   inside = 0
+}
+
+{
+   line = $0
+
+   sub(/\/\/.*/, "", line)             # strip comments
+   gsub(/^[ \t]+|[ \t]+$/, "", line)
+
+   if (line == "")
+      next
+
+   split(line, token, /[ \t]+/)
+
+   if (tolower(token[1]) == "table")
+   {
+      table = token[2]
+      isTable = 1
+   }
+   else if (tolower(token[1]) == "index")
+   {
+      isTable = 0
+   }
+   else if (index(line, "{"))
+   {
+      inside = 1
+
+      if (isTable)
+      {
+         tables[++tableCount] = table
+         fieldCount[table] = 0
+      }
+   }
+   else if (index(line, "}"))
+   {
+      inside = 0
+      isTable = 0
+   }
+   else if (inside && isTable)
+   {
+      fields[table, fieldCount[table]++] = token[1]
+   }
+}
+
+END {
+   print "/*"
+   print " * dbfields.h: field indices of the db dictionary"
+   print " *"
+   print " * Generated from '" FILENAME "' by lib/dict2h.awk, don't edit!"
+   print " *"
+   print " */"
+   print ""
+   print "#pragma once"
+   print ""
+   print "#include \"lib/dbdict.h\""
+   print ""
+   print "namespace dbf"
+   print "{"
+
+   for (t = 1; t <= tableCount; t++)
+   {
+      table = tables[t]
+
+      print "   namespace " table
+      print "   {"
+
+      for (i = 0; i < fieldCount[table]; i++)
+         printf "      constexpr int fi%s = %d;\n", fields[table, i], i
+
+      print ""
+      printf "      constexpr int fieldCount = %d;\n", fieldCount[table]
+      print "   }"
+      print ""
+   }
+
+   print "   //***************************************************************************"
+   print "   // Check"
+   print "   //  - the indices must match the dictionary loaded at runtime, only the"
+   print "   //    tables given (0 terminated) are checked, all if 0"
+   print "   //***************************************************************************"
+   print ""
+   print "   inline int check(const char* const* tables = 0)"
+   print "   {"
+   print "      static const cDbDict::FieldIndex indices[] ="
+   print "      {"
+
+   for (t = 1; t <= tableCount; t++)
+   {
+      table = tables[t]
+
+      for (i = 0; i < fieldCount[table]; i++)
+         printf "         { \"%s\", \"%s\", %d },\n", table, fields[table, i], i
+   }
+
+   print "         { 0, 0, 0 }"
+   print "      };"
+   print ""
+   print "      return dbDict.checkIndices(indices, tables);"
+   print "   }"
+   print "}"
+}
@@ -62,7 +62,6 @@ cSearchTimer::cSearchTimer()
    mapDb = 0;
    vdrDb = 0;
 
-   selectChannelFromMap = 0;
    selectDoneTimer = 0;
    selectActiveSearchtimers = 0;
    selectSearchtimerMaxModSp = 0;
@@ -159,19 +158,6 @@ int cSearchTimer::initDb()
 
    // selectDoneTimer - will build and prepared later at runtime ...
 
-   // ----------
-   // select channelname
-   //   from channelmap
-
-   selectChannelFromMap = new cDbStatement(mapDb);
-
-   selectChannelFromMap->build("select ");
-   selectChannelFromMap->bind("CHANNELNAME", cDBS::bndOut);
-   selectChannelFromMap->build(" from %s where ", mapDb->TableName());
-   selectChannelFromMap->bind("CHANNELID", cDBS::bndIn | cDBS::bndSet);
-
-   status += selectChannelFromMap->prepare();
-
    // select *,
    //    from timers
    //    where state in ('P','R')
@@ -249,7 +235,6 @@ int cSearchTimer::exitDb()
       delete selectActiveSearchtimers;  selectActiveSearchtimers = 0;
       delete selectSearchtimerMaxModSp; selectSearchtimerMaxModSp = 0;
       delete selectDoneTimer;           selectDoneTimer = 0;
-      delete selectChannelFromMap;      selectChannelFromMap = 0;
       delete selectAllTimer;            selectAllTimer = 0;
       // delete selectConflictingTimers;   selectConflictingTimers = 0;
       delete selectTimerByEvent;        selectTimerByEvent = 0;
@@ -555,15 +540,15 @@ int cSearchTimer::matchCriterias(cDbRow* searchTimer, cDbRow* event)
    mapDb->clear();
    mapDb->setValue("CHANNELID", channelid);
 
-   if (!selectChannelFromMap->find() || mapDb->getIntValue("UNKNOWNATVDR") > 0)
+   if (!mapDb->findBy("CHANNELID") || mapDb->getIntValue("UNKNOWNATVDR") > 0)
    {
-      mapDb->reset();
+      mapDb->resetBy();
       tell(2, "AUTOTIMER: Skipping hit, channelid '%s' is unknown at least on one VDR!",
            event->getStrValue("CHANNELID"));
       return no;
    }
 
-   mapDb->reset();
+   mapDb->resetBy();
 
    // check channel matches
 
@@ -974,13 +959,13 @@ int cSearchTimer::createTimer(int id)
    mapDb->clear();
    mapDb->setValue("CHANNELID", useeventsDb->getStrValue("CHANNELID"));
 
-   if (selectChannelFromMap->find())
+   if (mapDb->findBy("CHANNELID"))
       channelname = mapDb->getStrValue("CHANNELNAME");
 
    if (isEmpty(channelname))
       channelname = useeventsDb->getStrValue("CHANNELID");
 
-   selectChannelFromMap->freeResult();
+   mapDb->resetBy();
 
    // ------------------------------------------
    // Create timer in timerdistribution ...
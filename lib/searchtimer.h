@@ -62,7 +62,6 @@ class cSearchTimer
       cDbTable* mapDb;
       cDbTable* vdrDb;
 
-      cDbStatement* selectChannelFromMap;
       cDbStatement* selectDoneTimer;
       cDbStatement* selectActiveSearchtimers;
       cDbStatement* selectSearchtimerMaxModSp;
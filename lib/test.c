@@ -7,7 +7,9 @@
 
 #include <stdint.h>   // uint_64_t
 #include <sys/time.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 #include <stdio.h>
 #include <string>
@@ -18,6 +20,7 @@
 #include "epgservice.h"
 #include "dbdict.h"
 #include "xml.h"
+#include "../evtindex.h"
 //#include "wol.h"
 
 cDbConnection* connection = 0;
@@ -635,6 +638,164 @@ int tsp(std::string transponder)
    return 0;
 }
 
+//***************************************************************************
+// Check Event Index
+//  - put/find/remove across resizes, dropSegment, removeEndedBefore,
+//    the save/load round trip and the rejection of corrupt files
+//***************************************************************************
+
+int chkFailed = 0;
+
+void chk(int ok, const char* what)
+{
+   if (!ok)
+   {
+      tell(0, "Error: Check '%s' failed", what);
+      chkFailed++;
+   }
+}
+
+int chkEventIndex()
+{
+   const char* file = "/tmp/epg2vdr-evtindex.dat";
+   const time_t base = 1500000000;
+   const int perChannel = 3000;                   // 9000 events, the index resizes several times
+   cEventIndex index;
+   int channels[3];
+
+   chkFailed = 0;
+
+   channels[0] = index.channelOf("S19.2E-1-1019-10301");
+   channels[1] = index.channelOf("S19.2E-1-1079-28006");
+   channels[2] = index.channelOf("C-1-1051-11100");
+
+   chk(channels[0] && channels[1] && channels[2] && channels[0] != channels[2], "channelOf");
+   chk(index.channelOf("S19.2E-1-1079-28006") == channels[1], "channelOf (interned)");
+
+   // put / find / remove across resizes
+
+   const cEventIndex::Entry* e = 0;
+
+   for (int c = 0; c < 3; c++)
+      for (int i = 0; i < perChannel; i++)
+         index.put(channels[c], base + i * 600, 600, 0x50 + c, i % 32, i + 1, c + 1);
+
+   chk(index.size() == 3 * perChannel, "put - size");
+
+   for (int c = 0; c < 3; c++)
+      for (int i = 0; i < perChannel; i += 3)
+         index.remove(channels[c], base + i * 600);
+
+   for (int c = 0; c < 3; c++)
+   {
+      for (int i = 0; i < perChannel; i++)
+      {
+         e = index.find(channels[c], base + i * 600);
+
+         if (i % 3 == 0)
+            chk(!e, "remove - find");
+         else
+            chk(e && e->tableid == 0x50 + c && e->version == i % 32 && e->hash == (uint64_t)i + 1,
+                "put - find");
+      }
+   }
+
+   chk(index.size() == 3 * (perChannel - perChannel / 3), "remove - size");
+
+   // more puts over the tombstones, then the removed ones are back
+
+   for (int i = 0; i < perChannel; i += 3)
+      index.put(channels[0], base + i * 600, 600, 0x4e, 1);
+
+   e = index.find(channels[0], base);
+
+   chk(e && e->tableid == 0x4e, "put over tombstone");
+   chk(index.size() == 3 * (perChannel - perChannel / 3) + perChannel / 3, "put over tombstone - size");
+
+   // dropSegment - events overlapping the segment of a 'newer' table or a other
+   //   version are dropped, a lower table (0x4e < 0x50) is kept
+
+   int dropped = index.dropSegment(channels[0], base, base + 3 * 3600, 0x50, 31);
+
+   chk(dropped == 12, "dropSegment - count");
+   chk(index.find(channels[0], base) != 0, "dropSegment - lower table kept");
+   chk(!index.find(channels[0], base + 600), "dropSegment - other version dropped");
+   chk(index.find(channels[0], base + 19 * 600) != 0, "dropSegment - behind segment kept");
+   chk(index.find(channels[1], base + 600) != 0, "dropSegment - other channel kept");
+
+   // removeEndedBefore - the events of all channels ending before
+
+   size_t before = index.size();
+   int removed = index.removeEndedBefore(base + 100 * 600);
+
+   chk(!index.find(channels[1], base + 98 * 600), "removeEndedBefore - ended removed");
+   chk(index.find(channels[1], base + 100 * 600) != 0, "removeEndedBefore - running kept");
+   chk(index.size() == before - removed, "removeEndedBefore - size");
+
+   // save / load round trip
+
+   std::string origin;
+   time_t stamp = 0;
+   cEventIndex loaded;
+
+   chk(index.save(file, base + 4711, "localhost:3306/epg2vdr") == success, "save");
+   chk(loaded.load(file, stamp, origin) == success, "load");
+   chk(stamp == base + 4711 && origin == "localhost:3306/epg2vdr", "load - stamp and origin");
+   chk(loaded.size() == index.size(), "load - size");
+   chk(loaded.channelOf("C-1-1051-11100") == channels[2], "load - channels");
+
+   for (int c = 0; c < 3; c++)
+   {
+      for (int i = 0; i < perChannel; i++)
+      {
+         e = index.find(channels[c], base + i * 600);
+         const cEventIndex::Entry* l = loaded.find(channels[c], base + i * 600);
+
+         chk((!e && !l) || (e && l && e->tableid == l->tableid && e->version == l->version &&
+                            e->hash == l->hash && e->compHash == l->compHash), "load - entries");
+      }
+   }
+
+   chk(loaded.removeEndedBefore(base + 200 * 600) == index.removeEndedBefore(base + 200 * 600),
+       "load - timelines");
+
+   // corrupt files are rejected and leave the index empty
+
+   index.save(file, base, "localhost:3306/epg2vdr");
+
+   struct stat sb;
+   stat(file, &sb);
+
+   // the last span of the last channel doesn't reference a slot
+
+   FILE* fp = fopen(file, "r+");
+   uint32_t span[2] = { 0xFFFFFFF0, 0xFFFFFFFF };
+
+   fseek(fp, -(long)sizeof(span), SEEK_END);
+   fwrite(span, sizeof(span), 1, fp);
+   fclose(fp);
+
+   cEventIndex corrupt;
+
+   chk(corrupt.load(file, stamp, origin) == fail, "load - span without slot rejected");
+   chk(corrupt.size() == 0 && corrupt.channelOf("C-1-1051-11100") == 1, "load - rejected is empty");
+
+   // truncated
+
+   index.save(file, base, "localhost:3306/epg2vdr");
+   truncate(file, sb.st_size - 4);
+
+   cEventIndex truncated;
+
+   chk(truncated.load(file, stamp, origin) == fail, "load - truncated rejected");
+
+   unlink(file);
+
+   tell(0, "Event index checks %s (%d failed)", chkFailed ? "FAILED" : "passed", chkFailed);
+
+   return chkFailed ? 1 : 0;
+}
+
 //***************************************************************************
 // Main
 //***************************************************************************
@@ -644,6 +805,9 @@ int main(int argc, char** argv)
    cEpgConfig::logstdout = yes;
    cEpgConfig::loglevel = 2;
 
+   if (argc > 1 && strcmp(argv[1], "evtindex") == 0)
+      return chkEventIndex();
+
 
    cXml xml;
 
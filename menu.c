@@ -332,20 +332,6 @@ int cMenuDb::initDb()
 
    status += selectRecordingForEventByLv->prepare();
 
-   // ----------
-   // select channelname
-   //   from channelmap
-   //   where channelid = ?
-
-   selectChannelFromMap = new cDbStatement(mapDb);
-
-   selectChannelFromMap->build("select ");
-   selectChannelFromMap->bind("CHANNELNAME", cDBS::bndOut);
-   selectChannelFromMap->build(" from %s where ", mapDb->TableName());
-   selectChannelFromMap->bind("CHANNELID", cDBS::bndIn | cDBS::bndSet);
-
-   status += selectChannelFromMap->prepare();
-
    // search timer stuff
 
    if (!status)
@@ -428,7 +414,6 @@ int cMenuDb::exitDb()
       delete selectDoneTimerByStateTimeOrder;  selectDoneTimerByStateTimeOrder = 0;
       delete selectRecordingForEvent;          selectRecordingForEvent = 0;
       delete selectRecordingForEventByLv;      selectRecordingForEventByLv = 0;
-      delete selectChannelFromMap;             selectChannelFromMap = 0;
 
       delete connection;           connection = 0;
 
@@ -789,7 +774,7 @@ int cMenuDb::createTimer(cDbRow* timerRow, const char* destUuid, int type)
          mapDb->clear();
          mapDb->setValue("CHANNELID", useeventsDb->getStrValue("CHANNELID"));
 
-         if (selectChannelFromMap->find())
+         if (mapDb->findBy("CHANNELID"))
          {
             channelname = mapDb->getStrValue("CHANNELNAME");
 
@@ -799,7 +784,7 @@ int cMenuDb::createTimer(cDbRow* timerRow, const char* destUuid, int type)
             timerDoneDb->setValue("CHANNELNAME", channelname);
          }
 
-         selectChannelFromMap->freeResult();
+         mapDb->resetBy();
       }
 
       selectEventById->freeResult();
@@ -132,7 +132,6 @@ class cMenuDb : public cParameters
       cDbStatement* selectDoneTimerByStateTimeOrder {};
       cDbStatement* selectRecordingForEvent {};
       cDbStatement* selectRecordingForEventByLv {};
-      cDbStatement* selectChannelFromMap {};
 
       cSearchTimer* search {};
 
@@ -39,6 +39,9 @@ struct cEpg2VdrConfig : public cEpgConfig
       int extendedEpgData2Aux {false};
       int switchTimerNotifyTime {0};
       int closeOnSwith {false};
+      int slowQueryMs {0};              // capture db statements slower than n ms (0 = off)
+      int fetchWorkers {4};             // db connections to fetch the events on full reload (<= 1 sequential)
+      int lazyPrepare {false};          // prepare the statements of verified tables on first use
 };
 
 extern cEpg2VdrConfig Epg2VdrConfig;
@@ -520,7 +520,13 @@ int cUpdate::updateRecordingTable(int fullReload)
          insert ? insCnt++ : updCnt++;
          tell(2, "Info: '%s' recording '%s / %s' due to %d changes [%s]", insert ? "Insert" : "Update",
               title, subTitle, recordingListDb->getChanges(), recordingListDb->getChangedFields().c_str());
-         recordingListDb->store();
+
+         // only the inserts are batched, the writer upserts all columns
+
+         if (insert)
+            recordingListWriter->append();
+         else
+            recordingListDb->update();
       }
 
       // check recording image table
@@ -591,8 +597,15 @@ int cUpdate::updateRecordingTable(int fullReload)
       recordingListDb->reset();
    }
 
+   recordingListWriter->flush();
    connection->commit();
 
+   if (Epg2VdrConfig.loglevel > 1)
+   {
+      recordingListWriter->showStat();
+      recordingListDb->showStat();
+   }
+
    tell(0, "Info: Found %d recordings; %d inserted; %d updated and %d directories", count, insCnt, updCnt, dirCnt);
 
    // create info files for new recordings
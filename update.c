@@ -6,6 +6,7 @@
  */
 
 #include <locale.h>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <vdr/videodir.h>
@@ -16,92 +17,7 @@
 #include "epg2vdr.h"
 #include "update.h"
 #include "handler.h"
-
-//***************************************************************************
-// EPG Sanitizer
-//***************************************************************************
-
-static void stripControlCharacters(char* s)
-{
-   if (s)
-   {
-      int len = strlen(s);
-
-      while (len > 0)
-      {
-         int l = Utf8CharLen(s);
-         uchar* p = (uchar*)s;
-
-         if (l == 2 && *p == 0xC2) // UTF-8 sequence
-            p++;
-
-         if (*p == 0x86 || *p == 0x87 || *p == 0x0D)
-         {
-            memmove(s, p + 1, len - l + 1); // we also copy the terminating 0!
-            len -= l;
-            l = 0;
-         }
-
-         s += l;
-         len -= l;
-      }
-   }
-}
-
-//***************************************************************************
-// Events AUX Fields - stored as XML in cEvent:aux
-//***************************************************************************
-
-const char* cUpdate::auxFields[] =
-{
-// field name                type    max size
-
-   "imagecount",          // int
-   "scrseriesid",         // int
-   "scrseriesepisode",    // int
-   "scrmovieid",          // int
-   "numrating",           // int
-
-   "year",                // ascii     10
-   "category",            // ascii     50
-   "country",             // ascii     50
-   "audio",               // ascii     50
-
-   "txtrating",           // ascii    100
-   "genre",               // ascii    100
-   "flags",               // ascii    100
-   "commentator",         // ascii    200
-   "tipp",                // ascii    250
-   "rating",              // ascii    250
-   "moderator",           // ascii    250
-   "music",               // ascii    250
-   "screenplay",          // ascii    500
-   "shortreview",         // ascii    500
-
-   "guest",               // text    1000
-   "producer",            // text    1000
-   "camera",              // text    1000
-   "director",            // text    1000
-   "topic",               // ascii   1000
-
-   "other",               // text    2000
-   "shortdescription",    // mtext   3000
-   "shorttext",           // ascii    300
-   "actor",               // mtext   5000
-
-   "episodename",         // ascii    100
-   "episodeshortname",    // ascii    100
-   "episodepartname",     // ascii    300
-   "episodeextracol1",    // ascii    250
-   "episodeextracol2",    // ascii    250
-   "episodeextracol3",    // ascii    250
-   "episodeseason",       // int
-   "episodepart",         // int
-   "episodeparts",        // int
-   "episodenumber",       // int
-
-   0
-};
+#include "dbfields.h"
 
 //***************************************************************************
 // ctor
@@ -175,13 +91,30 @@ int cUpdate::init()
 
    asprintf(&dictPath, "%s/epg.dat", cPlugin::ConfigDirectory("epg2vdr/"));
 
+   uint64_t dictStart = cTimeMs::Now();
+
    if (dbDict.in(dictPath) != success)
    {
       tell(0, "Fatal: Dictionary not loaded, aborting!");
       return fail;
    }
 
-   tell(0, "Dictionary '%s' loaded", dictPath);
+   tell(0, "Dictionary '%s' loaded in %s", dictPath, ms2Dur(cTimeMs::Now()-dictStart).c_str());
+
+   // the hot paths access the fields of these tables by the compiled in index (update.c, fetcher.c)
+
+   static const char* const indexedTables[] = { "events", "components", "useevents", 0 };
+
+   // fields at other indices are mapped by name, only missing fields are fatal
+
+   if (dbf::check(indexedTables) != success)
+   {
+      tell(0, "Fatal: Dictionary '%s' lacks fields of the compiled in field indices, "
+           "install the epg.dat of this plugin version, aborting!", dictPath);
+      free(dictPath);
+      return fail;
+   }
+
    free(dictPath);
 
    // init database ...
@@ -193,6 +126,7 @@ int cUpdate::init()
    cDbConnection::setUser(Epg2VdrConfig.dbUser);
    cDbConnection::setPass(Epg2VdrConfig.dbPass);
    cDbConnection::setConfPath(cPlugin::ConfigDirectory("epg2vdr/"));
+   cDbConnection::setSchemaOwner("schema-epg2vdr");
 
    videoBasePath = cVideoDirectory::Name();
 
@@ -219,6 +153,10 @@ cDbFieldDef imageSizeDef("image", "image", cDBS::ffUInt, 0, cDBS::ftData);
 int cUpdate::initDb()
 {
    int status = success;
+   uint64_t start = cTimeMs::Now();
+   uint64_t connectedAt, openedAt, preparedAt;
+   int verified {0};
+   int opened {0};
 
    if (!connection)
       connection = new cDbConnection();
@@ -238,6 +176,7 @@ int cUpdate::initDb()
    }
 
    vdrDb->reset();
+   connectedAt = cTimeMs::Now();
 
    if (vdrDb->getIntValue("DBAPI") != DB_API)
    {
@@ -275,8 +214,7 @@ int cUpdate::initDb()
    useeventsDb = new cDbTable(connection, "useevents");
    if (useeventsDb->open() != success) return fail;
 
-   compDb = new cDbTable(connection, "components");
-   if (compDb->open() != success) return fail;
+   if (fetcher.initDb(connection) != success) return fail;
 
    timerDb = new cDbTable(connection, "timers");
    if (timerDb->open() != success) return fail;
@@ -296,12 +234,14 @@ int cUpdate::initDb()
    if ((status = cParameters::initDb(connection)) != success)
       return status;
 
-   // -------------------------------------------
-   // init db values
+   for (cDbTable* t : { vdrDb, mapDb, fileDb, imageDb, imageRefDb, episodeDb, eventsDb, useeventsDb,
+                        timerDb, timerDoneDb, recordingDirDb, recordingListDb, recordingImagesDb })
+   {
+      opened++;
+      verified += t->isSchemaVerified();
+   }
 
-   viewDescription = new cDbValue("description", cDBS::ffText, 50000);
-   viewMergeSource = new cDbValue("mergesource", cDBS::ffAscii, 25);
-   viewLongDescription = new cDbValue("longdescription", cDBS::ffText, 50000);
+   openedAt = cTimeMs::Now();
 
    // -------------------------------------------
    // init statements
@@ -363,6 +303,7 @@ int cUpdate::initDb()
    selectAllImages->bindCmp("r", "UPDSP", 0, ">");
    selectAllImages->build(")");
 
+   selectAllImages->setStreaming(yes);     // the result may get huge on full reload
    status += selectAllImages->prepare();
 
    // select distinct channelid, channelname
@@ -404,47 +345,7 @@ int cUpdate::initDb()
 
    status += markUnknownChannel->prepare();
 
-   // select changed events
-
-   selectUpdEvents = new cDbStatement(eventsDb);
-
-   // select useid, eventid, source, delflg, updflg, fileref,
-   //        tableid, version, title, shorttext, starttime,
-   //        duration, parentalrating, vps, description
-   //    from eventsview
-   //      where
-   //        channelid = ?
-   //        and updsp > ?
-   //        and updflg in (.....)
-
-   selectUpdEvents->build("select ");
-   selectUpdEvents->bind("USEID", cDBS::bndOut);
-   // selectUpdEvents->bind("MASTERID", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("EVENTID", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("SOURCE", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("DELFLG", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("UPDFLG", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("FILEREF", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("TABLEID", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("VERSION", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("TITLE", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("SHORTTEXT", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("STARTTIME", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("DURATION", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("PARENTALRATING", cDBS::bndOut, ", ");
-   selectUpdEvents->bind("VPS",  cDBS::bndOut, ", ");
-   selectUpdEvents->bind("CONTENTS",  cDBS::bndOut, ", ");
-   selectUpdEvents->bind(viewDescription, cDBS::bndOut, ", ");
-   selectUpdEvents->bind(viewMergeSource, cDBS::bndOut, ", ");
-   selectUpdEvents->bind(viewLongDescription, cDBS::bndOut, ", ");
-   selectUpdEvents->build(" from eventsview where ");
-   selectUpdEvents->bind("CHANNELID", cDBS::bndIn | cDBS::bndSet);
-   selectUpdEvents->bindCmp(0, "UPDSP", 0, ">", " and ");
-   selectUpdEvents->build(" and UPDFLG in (%s)", Us::getNeeded());
-
-   status += selectUpdEvents->prepare();
-
-   // select event by useid
+   // select event by useid (recording info files)
 
    selectEventById = new cDbStatement(useeventsDb);
 
@@ -476,28 +377,9 @@ int cUpdate::initDb()
    selectAllEvents->build("%s in (%s)",
                           useeventsDb->getField("UPDFLG")->getDbName(), Us::getNeeded());
 
+   selectAllEvents->setStreaming(yes);
    status += selectAllEvents->prepare();
 
-   // ...
-
-   // select stream, type, lang, description
-   //  from components where
-   // eventid = ?;
-   // channelid = ?;
-
-   selectComponentsOf = new cDbStatement(compDb);
-
-   selectComponentsOf->build("select ");
-   selectComponentsOf->bind("Stream", cDBS::bndOut);
-   selectComponentsOf->bind("Type", cDBS::bndOut, ", ");
-   selectComponentsOf->bind("Lang", cDBS::bndOut, ", ");
-   selectComponentsOf->bind("Description", cDBS::bndOut, ", ");
-   selectComponentsOf->build(" from %s where ", compDb->TableName());
-   selectComponentsOf->bind("EventId", cDBS::bndIn | cDBS::bndSet);
-   selectComponentsOf->bind("ChannelId", cDBS::bndIn | cDBS::bndSet, " and ");
-
-   status += selectComponentsOf->prepare();
-
    // select *
    //   from recordinglist where
    //      state <> 'D'
@@ -676,6 +558,12 @@ int cUpdate::initDb()
 
    status += deleteTimer->prepare();
 
+   // batch writer for the inserts of recordinglist
+
+   recordingListWriter = new cDbBatchWriter(recordingListDb, 25);
+
+   preparedAt = cTimeMs::Now();
+
    if (status == success)
    {
       // -------------------------------------------
@@ -741,6 +629,15 @@ int cUpdate::initDb()
    if (status == success)
       status += cEpg2VdrEpgHandler::getSingleton()->updateExternalIdsMap(mapDb);
 
+   // startup time by phase
+
+   tell(1, "Database initialized in %s (connect %s, open tables %s, prepare %s, register %s), "
+        "%d/%d tables verified%s",
+        ms2Dur(cTimeMs::Now()-start).c_str(),
+        ms2Dur(connectedAt-start).c_str(), ms2Dur(openedAt-connectedAt).c_str(),
+        ms2Dur(preparedAt-openedAt).c_str(), ms2Dur(cTimeMs::Now()-preparedAt).c_str(),
+        verified, opened, cDbStatement::lazyPrepare && verified ? ", lazy prepare" : "");
+
    return status;
 }
 
@@ -760,13 +657,11 @@ int cUpdate::exitDb()
    cParameters::exitDb();
 
    delete selectAllImages;           selectAllImages = 0;
-   delete selectUpdEvents;           selectUpdEvents = 0;
    delete selectEventById;           selectEventById = 0;
    delete selectAllEvents;           selectAllEvents = 0;
    delete selectAllChannels;         selectAllChannels = 0;
    delete selectChannelById;         selectChannelById = 0;
    delete markUnknownChannel;        markUnknownChannel = 0;
-   delete selectComponentsOf;        selectComponentsOf = 0;
    delete selectMasterVdr;           selectMasterVdr = 0;
    delete deleteTimer;               deleteTimer = 0;
    delete selectMyTimer;             selectMyTimer = 0;
@@ -780,6 +675,10 @@ int cUpdate::exitDb()
    delete selectPendingTimerActions; selectPendingTimerActions = 0;
    delete selectSwitchTimerActions;  selectSwitchTimerActions = 0;
 
+   fetcher.exitDb();
+
+   delete recordingListWriter;    recordingListWriter = 0;
+
    delete vdrDb;                  vdrDb = 0;
    delete mapDb;                  mapDb = 0;
    delete fileDb;                 fileDb = 0;
@@ -788,16 +687,12 @@ int cUpdate::exitDb()
    delete episodeDb;              episodeDb = 0;
    delete eventsDb;               eventsDb = 0;
    delete useeventsDb;            useeventsDb = 0;
-   delete compDb;                 compDb = 0;
    delete timerDb;                timerDb = 0;
    delete timerDoneDb;            timerDoneDb = 0;
    delete recordingDirDb;         recordingDirDb = 0;
    delete recordingListDb;        recordingListDb = 0;
    delete recordingImagesDb;      recordingImagesDb = 0;
 
-   delete viewDescription;        viewDescription = 0;
-   delete viewMergeSource;        viewMergeSource = 0;
-   delete viewLongDescription;    viewLongDescription = 0;
 
    delete connection; connection = 0;
 
@@ -835,7 +730,8 @@ int cUpdate::checkConnection(int& timeout)
 
    dbReconnectTriggered = no;
 
-   // check connection
+   // check connection, a dropped connection is re-established
+   //   in place (with all statements) by check()
 
    if (!dbConnected(yes))
    {
@@ -1494,18 +1390,22 @@ void clearEpg()
 
 //***************************************************************************
 // Refresh Epg
+//  - the events are fetched and built without any vdr lock, by the fetcher
+//    of this thread or on full reload by the fetch workers (FetchWorkers),
+//    applyChannel() applies them channel by channel in this thread
 //***************************************************************************
 
 int cUpdate::refreshEpg(const char* forChannelId, int maxTries)
 {
-   const cEvent* event;
-   int tries = 0;
-   int timerChanges = 0;
-   int total = 0;
-   int dels = 0;
+   RefreshStat stat;
+   int status = success;
+   int fetchFailed = no;                   // a channel is incomplete, don't advance lastEventsUpdateAt
    int channels = 0;
+   int workers = 1;
+   time_t since = 0;
    uint64_t start = cTimeMs::Now();
    cDbStatement* select = 0;
+   std::vector<cEpgFetchPool::Job> jobs;
 
    if (Epg2VdrConfig.loglevel >= 5)
       connection->showStat("before refresh");
@@ -1526,6 +1426,12 @@ int cUpdate::refreshEpg(const char* forChannelId, int maxTries)
       lastEventsUpdateAt = 0;
    }
 
+   since = forChannelId ? 0 : lastEventsUpdateAt;
+
+   // on full load stream the events instead of buffering the whole result per channel
+
+   fetcher.setStreaming(!lastEventsUpdateAt);
+
    // iterate over all channels in channelmap
 
    mapDb->clear();
@@ -1547,337 +1453,427 @@ int cUpdate::refreshEpg(const char* forChannelId, int maxTries)
          tell(2, "Update EPG, reloading all events");
    }
 
-   for (int f = select->find(); f && dbConnected(yes); f = select->fetch())
+   for (int f = select->find(); f && dbConnected(); f = select->fetch())
    {
-      int count = 0;
-      cSchedule* s = 0;
-      cChannel* channel = 0;
+      int known = no;
       tChannelID channelId = tChannelID::FromString(mapDb->getStrValue("ChannelId"));
 
       channels++;
 
-      eventsDb->clear();
-      eventsDb->setValue("UPDSP", forChannelId ? 0 : lastEventsUpdateAt);
-      eventsDb->setValue("CHANNELID", mapDb->getStrValue("CHANNELID"));
-
-      // #1 get timers lock
-
-#if defined (APIVERSNUM) && (APIVERSNUM >= 20301)
-      cStateKey timersKey;
-      tell(3, "-> Try to get timers lock");
-      cTimers* timers = cTimers::GetTimersWrite(timersKey, 500/*ms*/);
-#else
-      cTimers* timers = &Timers;
-#endif
+      {
+         GET_CHANNELS_READ(vdrChannels);
+         known = vdrChannels->GetByChannelID(channelId, true) != 0;
+      }
 
-      // #2 get channels lock
+      if (!known)
+      {
+         tell(mainActPending ? 0 : 4, "Error: Channel with ID '%s' don't exist on this VDR", mapDb->getStrValue("ChannelId"));
+         continue;
+      }
 
-#if defined (APIVERSNUM) && (APIVERSNUM >= 20301)
-      cStateKey channelsKey;
-      cChannels* channels = cChannels::GetChannelsWrite(channelsKey, 500);
-#else
-      cChannels* channels = &Channels;
-#endif
+      jobs.push_back({ mapDb->getStrValue("CHANNELID"), mapDb->getStrValue("CHANNELNAME") });
+   }
 
-      // #3 get schedules lock
+   select->freeResult();
 
-#if defined (APIVERSNUM) && (APIVERSNUM >= 20301)
-      cStateKey schedulesKey;
-      tell(3, "-> Try to get schedules lock");
-      cSchedules* schedules = cSchedules::GetSchedulesWrite(schedulesKey, 500/*ms*/);
-#else
-      cSchedulesLock* schedulesLock = new cSchedulesLock(true, 500/*ms*/);
-      cSchedules* schedules = (cSchedules*)cSchedules::Schedules(*schedulesLock);
-      tell(3, "LOCK (refreshEpg)");
-#endif
+   // full reload, fetch the channels in parallel by the fetch workers
 
-      // get channel and schedule of channel
+   if (!lastEventsUpdateAt && !forChannelId && Epg2VdrConfig.fetchWorkers > 1 && jobs.size() > 1)
+   {
+      cEpgFetchPool pool(Epg2VdrConfig.fetchWorkers);
+      cEpgFetchPool::Result result;
+      std::vector<cEpgFetchPool::Job> refetch;   // failed by a worker
+      int res;
 
-      if (channels && schedules && (channel = channels->GetByChannelID(channelId, true)))
-         s = (cSchedule*)schedules->GetSchedule(channel, true);
-      else if (channels && schedules)
-         tell(mainActPending ? 0 : 4, "Error: Channel with ID '%s' don't exist on this VDR", mapDb->getStrValue("ChannelId"));
+      workers = std::min(Epg2VdrConfig.fetchWorkers, (int)jobs.size());
+      pool.start(jobs, since);
 
-      if (!schedules || !channels || !timers)
+      while ((res = pool.next(result)) == success)
       {
-         tell(3, "Info: Can't get write lock on '%s'", !schedules ? "schedules" : !timers ? "timers" : "channels");
-
-#if defined (APIVERSNUM) && (APIVERSNUM >= 20301)
-         if (schedules) schedulesKey.Remove();
-         if (timers)    timersKey.Remove();
-         if (channels) channelsKey.Remove();
-#else
-         delete schedulesLock;
-#endif
+         stat.fetchTotal += result.fetchMs;
 
-         if (tries++ > maxTries)
+         if (result.status != success)
          {
-            select->freeResult();
-            tell(3, "Warning: Aborting refresh after %d tries", tries);
-            break;
+            tell(0, "Fetch worker failed on channel '%s', fetching it again", result.job.channelId.c_str());
+            refetch.push_back(result.job);
+            continue;
          }
 
-         tell(1, "Retrying in 1 seconds");
-         sleep(1);
-
-         continue;
+         if ((status = applyChannel(result.job.channelId.c_str(), result.job.channelName.c_str(),
+                                    result.staged, result.fetchMs, stat, maxTries)) != success)
+            break;
       }
 
-      tries = 0;
-
-      // lookup schedules object
-
-      if (s)
-      {
-         // -----------------------------------------
-         // iterate over all events of this schedule
+      // if the workers failed, go on with the remaining channels in this thread
 
-         for (int found = selectUpdEvents->find(); found && dbConnected(); found = selectUpdEvents->fetch())
-         {
-            cTimer* timer = 0;
-            char updFlg = toupper(eventsDb->getStrValue("UPDFLG")[0]);
-
-            updFlg = updFlg == 0 ? 'P' : updFlg;               // fix missing flag
-
-            // ignore unneded event rows ..
-
-            if (!Us::isNeeded(updFlg))
-               continue;
-
-            // get event / timer
-
-#if APIVERSNUM > 20501
-            if ((event = s->GetEventById(eventsDb->getIntValue("USEID"))))
-#else
-            if ((event = s->GetEvent(eventsDb->getIntValue("USEID"))))
-#endif
-            {
-               if (Us::isRemove(updFlg))
-                  tell(2, "Remove event %uld of channel '%s' due to updflg %c",
-                       event->EventID(), (const char*)event->ChannelID().ToString(), updFlg);
-
-               if (event->HasTimer())
-               {
-                  for (timer = timers->First(); timer; timer = timers->Next(timer))
-                  {
-                     if (!timer->Local())
-                        continue;
-
-                     if (timer->Event() == event)
-                        break;
-                  }
-               }
-
-               if (timer)
-                  timer->SetEvent(0);
-
-               s->DelEvent((cEvent*)event);
-            }
-
-            if (!Us::isRemove(updFlg))
-               event = s->AddEvent(createEventFromRow(eventsDb->getRow()));
-            else if (event)
-            {
-               event = 0;
-               dels++;
-            }
-
-            if (timer && event)
-            {
-               timer->SetEvent(event);
-               timer->Matches(event);
-               timerChanges++;
-            }
-            else if (timer)
-            {
-               tell(0, "Info: Timer '%s', has no event anymore", *timer->ToDescr());
-            }
+      if (res == fail && status == success)
+         pool.remainingJobs(jobs);
+      else
+         jobs.clear();
 
-            count++;
-         }
+      if (status == success)
+         jobs.insert(jobs.begin(), refetch.begin(), refetch.end());
+   }
 
-         selectUpdEvents->freeResult();
+   // fetch and apply channel by channel
 
-         // Kanal fertig machen ..
+   for (const auto& job : jobs)
+   {
+      std::vector<cEpgFetcher::StagedEvent> staged;
 
-         s->Sort();
-         s->SetModified();
+      if (status != success || !dbConnected(yes))
+         break;
 
-         tell(2, "Processed channel '%s' - '%s' with %d updates",
-              eventsDb->getStrValue("CHANNELID"),
-              mapDb->getStrValue("CHANNELNAME"),
-              count);
+      uint64_t fetchStart = cTimeMs::Now();
 
-         total += count;
+      if (fetcher.stageChannel(job.channelId.c_str(), since, staged) != success)
+      {
+         fetchFailed = yes;
+         break;
       }
 
-      // schedules lock freigeben
+      uint64_t fetchMs = cTimeMs::Now() - fetchStart;
 
-#if defined (APIVERSNUM) && (APIVERSNUM >= 20301)
-      schedulesKey.Remove();
-      tell(3, "-> Released schedules lock");
-      channelsKey.Remove();
-      tell(3, "-> Released channels lock");
-      timersKey.Remove();
-      tell(3, "-> Released timers lock");
-#else
-      tell(3, "LOCK free (refreshEpg)");
-      delete schedulesLock;
-#endif
+      stat.fetchTotal += fetchMs;
+      status = applyChannel(job.channelId.c_str(), job.channelName.c_str(), staged, fetchMs, stat, maxTries);
    }
 
-   select->freeResult();
-
-   if (timerChanges)
+   if (stat.timerChanges)
    {
       GET_TIMERS_WRITE(timers);
       timers->SetModified();
    }
 
+   uint64_t elapsed = cTimeMs::Now() - start;
+
    if (lastEventsUpdateAt)
       tell(1, "Updated changes since '%s'; %d channels, "
            "%d events (%d deletions) in %s",
            forChannelId ? "-" : l2pTime(lastEventsUpdateAt).c_str(),
-           channels, total, dels, ms2Dur(cTimeMs::Now()-start).c_str());
+           channels, stat.total, stat.dels, ms2Dur(elapsed).c_str());
    else
       tell(1, "Updated all %d channels, %d events (%d deletions) in %s",
-           channels, total, dels, ms2Dur(cTimeMs::Now()-start).c_str());
+           channels, stat.total, stat.dels, ms2Dur(elapsed).c_str());
+
+   // the fetch times of the channels against the time spent outside the vdr locks,
+   //   about 1.0 for the sequential path
+
+   tell(2, "Fetched with %d worker(s), %s fetch time of the channels in %s (speedup %.1f)",
+        workers, ms2Dur(stat.fetchTotal).c_str(), ms2Dur(elapsed - stat.lockTotal).c_str(),
+        stat.fetchTotal / (double)std::max(elapsed - stat.lockTotal, (uint64_t)1));
+
+   tell(2, "Held the vdr locks for %s in total, at most %s per channel",
+        ms2Dur(stat.lockTotal).c_str(), ms2Dur(stat.lockMax).c_str());
+
+   tell(2, "Updated %d events in place, replaced %d events",
+        stat.inPlace, stat.replaced);
 
    // print sql statistic for statement debugging
 
    if (Epg2VdrConfig.loglevel >= 5)
       connection->showStat("refresh");
 
-   return dbConnected(yes) ? success : fail;
+   if (fetchFailed)
+      tell(0, "Error: Refresh of the EPG incomplete, fetching the events failed");
+
+   return !fetchFailed && dbConnected(yes) ? success : fail;
 }
 
 //***************************************************************************
-// To/From Row
+// Timer Of Event
+//  - the local timers are indexed by their event on the first lookup of a
+//    locked section
 //***************************************************************************
 
-cEvent* cUpdate::createEventFromRow(const cDbRow* row)
+static cTimer* timerOfEvent(cTimers* timers, std::unordered_map<const cEvent*,cTimer*>& timerOf,
+                            int& indexed, const cEvent* event)
 {
-   cEvent* e = new cEvent(row->getIntValue("USEID"));
+   if (!indexed)
+   {
+      for (cTimer* t = timers->First(); t; t = timers->Next(t))
+      {
+         if (t->Local() && t->Event())
+            timerOf.emplace(t->Event(), t);      // the first timer of the event wins
+      }
 
-   e->SetTableID(row->getIntValue("TABLEID"));
-   e->SetVersion(row->getIntValue("VERSION"));
+      indexed = yes;
+   }
 
-   // e->SetTitle(row->getStrValue("TITLE"));
-   char* title = strdup(row->getStrValue("TITLE"));
-   strreplace(title, '\n', ' ');
-   stripControlCharacters(title);
-   e->SetTitle(title);
-   free(title);
+   auto it = timerOf.find(event);
 
-   // e->SetShortText(row->getStrValue("SHORTTEXT"));
-   char* shortText = strdup(row->getStrValue("SHORTTEXT"));
-   strreplace(shortText, '\n', ' ');
-   stripControlCharacters(shortText);
-   e->SetShortText(shortText);
-   free(shortText);
+   return it != timerOf.end() ? it->second : 0;
+}
 
-   e->SetStartTime(row->getIntValue("STARTTIME"));
-   e->SetDuration(row->getIntValue("DURATION"));
-   e->SetParentalRating(row->getIntValue("PARENTALRATING"));
-   e->SetVps(row->getIntValue("VPS"));
+//***************************************************************************
+// Update Event From
+//  - take over the data of a staged event with same id and start time
+//***************************************************************************
 
-   // e->SetDescription(viewDescription->getStrValue());
-   char* description = strdup(viewDescription->getStrValue());
-   stripControlCharacters(description);
-   e->SetDescription(description);
-   free(description);
+static void updateEventFrom(cEvent* event, const cEvent* from)
+{
+   uchar contents[MaxEventContents] = { 0 };
+   cComponents* components = 0;
 
-   e->SetComponents(0);
+   event->SetTableID(from->TableID());
+   event->SetVersion(from->Version());
+   event->SetTitle(from->Title());
+   event->SetShortText(from->ShortText());
+   event->SetDescription(from->Description());
+   event->SetDuration(from->Duration());
+   event->SetParentalRating(from->ParentalRating());
+   event->SetVps(from->Vps());
 
-   // ------------
-   // contents
+   for (int i = 0; i < MaxEventContents; i++)
+      contents[i] = from->Contents(i);
 
-   uchar contents[MaxEventContents] = { 0 };
-   int numContents = 0;
+   event->SetContents(contents);
 
-   for (const char* p = row->getStrValue("CONTENTS"); p && numContents < MaxEventContents; p = strchr(p, ','))
+   if (from->Components() && from->Components()->NumComponents())
    {
-      if (*p == ',') p++;
+      components = new cComponents;
 
-      if (*p)
-         contents[numContents++] = strtol(p, 0, 0);
+      for (int i = 0; i < from->Components()->NumComponents(); i++)
+      {
+         tComponent* c = from->Components()->Component(i);
+         components->SetComponent(i, c->stream, c->type, c->language, c->description);
+      }
    }
 
-   e->SetContents(contents);
+   event->SetComponents(components);      // event take ownership of components!
 
-   // ------------
-   // components
+#if (defined (APIVERSNUM) && (APIVERSNUM >= 20304)) || (WITH_AUX_PATCH)
+   event->SetAux(from->Aux());
+#endif
+}
 
-   if (row->hasValue("SOURCE", "vdr"))
+//***************************************************************************
+// Apply Channel
+//  - apply the staged events of a channel in a short critical section
+//  - the staged events are consumed, fail if the vdr locks can't be taken
+//***************************************************************************
+
+int cUpdate::applyChannel(const char* channelId, const char* channelName,
+                          std::vector<cEpgFetcher::StagedEvent>& staged,
+                          uint64_t fetchMs, RefreshStat& stat, int maxTries)
+{
+   const cEvent* event;
+   int count = 0;
+   cSchedule* s = 0;
+   cChannel* channel = 0;
+   int timersIndexed = no;
+   int sort = no;
+   std::unordered_map<const cEvent*,cTimer*> timerOf;
+
+#if defined (APIVERSNUM) && (APIVERSNUM >= 20301)
+   cStateKey timersKey;
+   cStateKey channelsKey;
+   cStateKey schedulesKey;
+#else
+   cSchedulesLock* schedulesLock = 0;
+#endif
+   cTimers* timers = 0;
+   cChannels* channels = 0;
+   cSchedules* schedules = 0;
+
+   while (dbConnected())
    {
-      cComponents* components = new cComponents;
+      // #1 get timers lock
 
-      compDb->clear();
-      compDb->setBigintValue("EVENTID", row->getBigintValue("EVENTID"));
-      compDb->setValue("CHANNELID", row->getStrValue("CHANNELID"));
+#if defined (APIVERSNUM) && (APIVERSNUM >= 20301)
+      tell(3, "-> Try to get timers lock");
+      timers = cTimers::GetTimersWrite(timersKey, 500/*ms*/);
+#else
+      timers = &Timers;
+#endif
 
-      for (int f = selectComponentsOf->find(); f; f = selectComponentsOf->fetch())
-      {
-         components->SetComponent(components->NumComponents(),
-                                  compDb->getIntValue("STREAM"),
-                                  compDb->getIntValue("TYPE"),
-                                  compDb->getStrValue("LANG"),
-                                  compDb->getStrValue("DESCRIPTION"));
-      }
+      // #2 get channels lock
+
+#if defined (APIVERSNUM) && (APIVERSNUM >= 20301)
+      channels = cChannels::GetChannelsWrite(channelsKey, 500);
+#else
+      channels = &Channels;
+#endif
 
-      selectComponentsOf->freeResult();
+      // #3 get schedules lock
 
-      if (components->NumComponents())
-         e->SetComponents(components);      // event take ownership of components!
-      else
-         delete components;
+#if defined (APIVERSNUM) && (APIVERSNUM >= 20301)
+      tell(3, "-> Try to get schedules lock");
+      schedules = cSchedules::GetSchedulesWrite(schedulesKey, 500/*ms*/);
+#else
+      schedulesLock = new cSchedulesLock(true, 500/*ms*/);
+      schedules = (cSchedules*)cSchedules::Schedules(*schedulesLock);
+      tell(3, "LOCK (refreshEpg)");
+#endif
+
+      if (schedules && channels && timers)
+         break;
+
+      tell(3, "Info: Can't get write lock on '%s'", !schedules ? "schedules" : !timers ? "timers" : "channels");
+
+#if defined (APIVERSNUM) && (APIVERSNUM >= 20301)
+      if (schedules) schedulesKey.Remove();
+      if (timers)    timersKey.Remove();
+      if (channels) channelsKey.Remove();
+#else
+      delete schedulesLock;
+      schedulesLock = 0;
+#endif
+      schedules = 0;
+
+      if (stat.tries++ > maxTries)
+         break;
+
+      tell(1, "Retrying in 1 seconds");
+      sleep(1);
    }
 
-#if (defined (APIVERSNUM) && (APIVERSNUM >= 20304)) || (WITH_AUX_PATCH)
+   if (!schedules)
+   {
+      for (auto& st : staged)
+         delete st.event;
+
+      staged.clear();
+      tell(3, "Warning: Aborting refresh after %d tries", stat.tries);
+
+      return fail;
+   }
+
+   stat.tries = 0;
 
-   // ------------
-   // aux
+   uint64_t lockStart = cTimeMs::Now();
 
-   if (Epg2VdrConfig.extendedEpgData2Aux)
+   // get channel and schedule of channel
+
+   if ((channel = channels->GetByChannelID(tChannelID::FromString(channelId), true)))
+      s = (cSchedule*)schedules->GetSchedule(channel, true);
+   else
+      tell(mainActPending ? 0 : 4, "Error: Channel with ID '%s' don't exist on this VDR", channelId);
+
+   // lookup schedules object
+
+   if (s)
    {
-      useeventsDb->clear();
-      useeventsDb->setValue("USEID", row->getIntValue("USEID"));
+      // -----------------------------------------
+      // iterate over all staged events of this schedule
 
-      if (selectEventById->find())
+      for (auto& st : staged)
       {
-         cXml xml;
+         cTimer* timer = 0;
 
-         xml.create("epg2vdr");
+         // get event / timer
 
-         for (int i = 0; auxFields[i]; i++)
+#if APIVERSNUM > 20501
+         if ((event = s->GetEventById(st.id)))
+#else
+         if ((event = s->GetEvent(st.id)))
+#endif
          {
-            cDbValue* value = useeventsDb->getValue(auxFields[i]);
+            // same start time, update the event in place
+
+            if (st.event && st.event->StartTime() == event->StartTime())
+            {
+               // the timer follows the vps time of VPS timers, and the end of the others
+
+               int timesChanged = st.event->Duration() != event->Duration() || st.event->Vps() != event->Vps();
+
+               updateEventFrom((cEvent*)event, st.event);
+               delete st.event;
+               st.event = 0;
+
+               if (timesChanged && event->HasTimer() && (timer = timerOfEvent(timers, timerOf, timersIndexed, event)))
+               {
+                  timer->Matches(event);
+                  stat.timerChanges++;
+               }
+
+               stat.inPlace++;
+               count++;
 
-            if (!value || value->isEmpty())
                continue;
+            }
 
-            if (value->getField()->hasFormat(cDBS::ffAscii) || value->getField()->hasFormat(cDBS::ffText) || value->getField()->hasFormat(cDBS::ffMText))
-               xml.appendElement(auxFields[i], value->getStrValue());
-            else
-               xml.appendElement(auxFields[i], value->getIntValue());
-         }
+            if (!st.event)
+               tell(2, "Remove event %uld of channel '%s' due to updflg %c",
+                    event->EventID(), (const char*)event->ChannelID().ToString(), st.updFlg);
 
-         // finally add some fields of the view
+            if (event->HasTimer() && (timer = timerOfEvent(timers, timerOf, timersIndexed, event)))
+            {
+               timerOf.erase(event);
+               timer->SetEvent(0);
+            }
 
-         xml.appendElement("source", viewMergeSource->getStrValue());
-         xml.appendElement("longdescription", viewLongDescription->getStrValue()); // the real original without view additions
+            if (st.event)
+               stat.replaced++;
+
+            s->DelEvent((cEvent*)event);
+         }
 
-         // set to events aux field
+         if (st.event)
+         {
+            event = s->AddEvent(st.event);
+            st.event = 0;                       // owned by the schedule now
+            sort = yes;
+         }
+         else if (event)
+         {
+            event = 0;
+            stat.dels++;
+         }
 
-         e->SetAux(xml.toText());
+         if (timer && event)
+         {
+            timer->SetEvent(event);
+            timer->Matches(event);
+            timerOf.emplace(event, timer);
+            stat.timerChanges++;
+         }
+         else if (timer)
+         {
+            tell(0, "Info: Timer '%s', has no event anymore", *timer->ToDescr());
+         }
+
+         count++;
       }
 
-      selectEventById->freeResult();
+      // Kanal fertig machen .. (sort only if events are added)
+
+      if (sort)
+         s->Sort();
+
+      s->SetModified();
    }
 
-#endif // WITH_AUX_PATCH
+   uint64_t lockMs = cTimeMs::Now() - lockStart;
 
-   return e;
+   // schedules lock freigeben
+
+#if defined (APIVERSNUM) && (APIVERSNUM >= 20301)
+   schedulesKey.Remove();
+   tell(3, "-> Released schedules lock");
+   channelsKey.Remove();
+   tell(3, "-> Released channels lock");
+   timersKey.Remove();
+   tell(3, "-> Released timers lock");
+#else
+   tell(3, "LOCK free (refreshEpg)");
+   delete schedulesLock;
+#endif
+
+   for (auto& st : staged)                     // not applied (channel vanished)
+      delete st.event;
+
+   staged.clear();
+
+   if (s)
+      tell(2, "Processed channel '%s' - '%s' with %d updates (fetch %s, locked %s%s)",
+           channelId, channelName, count, ms2Dur(fetchMs).c_str(), ms2Dur(lockMs).c_str(),
+           sort ? ", sorted" : "");
+
+   stat.total += count;
+   stat.lockTotal += lockMs;
+   stat.lockMax = std::max(stat.lockMax, lockMs);
+
+   return success;
 }
 
 //***************************************************************************
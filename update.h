@@ -9,6 +9,7 @@
 
 #include <mysql.h>
 #include <queue>
+#include <vector>
 
 #include <vdr/status.h>
 
@@ -20,6 +21,7 @@
 
 #include "epg2vdr.h"
 #include "parameters.h"
+#include "fetcher.h"
 
 #define EPGDNAME "epgd"
 
@@ -171,6 +173,21 @@ class cUpdate : public cThread, public cStatus, public cParameters
          bool on;
       };
 
+      // counters of a refreshEpg() run
+
+      struct RefreshStat
+      {
+         int tries {0};
+         int timerChanges {0};
+         int total {0};
+         int dels {0};
+         int inPlace {0};               // events updated in place
+         int replaced {0};              // events replaced (start time moved)
+         uint64_t fetchTotal {0};       // ms
+         uint64_t lockTotal {0};        // ms
+         uint64_t lockMax {0};          // ms
+      };
+
       // functions
 
       int initDb();
@@ -182,11 +199,12 @@ class cUpdate : public cThread, public cStatus, public cParameters
       void updateVdrData();
       int updateRecFolderOption();
       int dbConnected(int force = no)
-      { return connection && connection->isConnected() && (!force || connection->check() == success); }
+      { return connection && (force ? connection->check() == success : connection->isConnected()); }
       int checkConnection(int& timeout);
 
       int refreshEpg(const char* channelid = 0, int maxTries = 5);
-      cEvent* createEventFromRow(const cDbRow* row);
+      int applyChannel(const char* channelId, const char* channelName, std::vector<cEpgFetcher::StagedEvent>& staged,
+                       uint64_t fetchMs, RefreshStat& stat, int maxTries);
       int lookupVdrEventOf(int eId, const char* cId);
       int storePicturesToFs();
       int cleanupPictures();
@@ -270,20 +288,19 @@ class cUpdate : public cThread, public cStatus, public cParameters
       cDbTable* timerDb {};
       cDbTable* timerDoneDb {};
       cDbTable* vdrDb {};
-      cDbTable* compDb {};
       cDbTable* recordingDirDb {};
       cDbTable* recordingListDb {};
       cDbTable* recordingImagesDb {};
 
+      cDbBatchWriter* recordingListWriter {};
+
       cDbStatement* selectMasterVdr {};
       cDbStatement* selectAllImages {};
-      cDbStatement* selectUpdEvents {};
       cDbStatement* selectAllEvents {};
       cDbStatement* selectEventById {};
       cDbStatement* selectAllChannels {};
       cDbStatement* selectChannelById {};
       cDbStatement* markUnknownChannel {};
-      cDbStatement* selectComponentsOf {};
       cDbStatement* deleteTimer {};
       cDbStatement* selectMyTimer {};
       cDbStatement* selectRecordings {};
@@ -296,6 +313,8 @@ class cUpdate : public cThread, public cStatus, public cParameters
       cDbStatement* selectTimerByDoneId {};
       cDbStatement* selectMaxUpdSp {};
 
+      cEpgFetcher fetcher;                   // fetch and build the events for refreshEpg()
+
       cDbValue vdrEvtId;
       cDbValue extEvtId;
       cDbValue vdrStartTime;
@@ -305,10 +324,6 @@ class cUpdate : public cThread, public cStatus, public cParameters
       cDbValue imageSizeRec;
       cDbValue masterId;
 
-      cDbValue* viewDescription {};
-      cDbValue* viewMergeSource {};
-      cDbValue* viewLongDescription {};
-
       std::queue<std::string> pendingNewRecordings;        // recordings to store details (obsolete if pendingRecordingActions implemented finally)
       std::queue<RecordingAction> pendingRecordingActions; // recordings actions (start/stop)
       std::map<long,SwitchTimer> switchTimers;
@@ -317,5 +332,4 @@ class cUpdate : public cThread, public cStatus, public cParameters
 
       std::list<cTimerThread*> timerThreads;
       static void sendEvent(int event, void* userData);
-      static const char* auxFields[];
 };